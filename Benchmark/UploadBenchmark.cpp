@@ -0,0 +1,284 @@
+// Buffer upload strategy micro-benchmark
+//
+// Compares the ways buffer.h could stream data to the GPU, for upload sizes from 64 B to 256 MB:
+//	subdata		glBufferSubData into a fixed buffer
+//	orphan		glBufferData(nullptr) then glBufferSubData (buffer orphaning)
+//	unsync		glMapBufferRange with GL_MAP_UNSYNCHRONIZED_BIT on a fenced ring of regions
+//	persistent	persistent coherent mapping (like StreamBuffer), memcpy into a fenced ring of regions
+//	staging		memcpy into a persistent staging ring, then glCopyBufferSubData to the destination (like UploadQueue)
+// For each method and size it reports the throughput (bytes / wall time, glFinish included) and
+// the CPU time spent in one upload call on average.
+//
+// Windows: build Benchmark/UploadBenchmark.vcxproj (SDL2 + GLEW from the DragonflyPack, hidden window).
+// Linux, headless (no X, no GPU needed; Mesa llvmpipe through EGL surfaceless):
+//	g++ -O2 -std=c++17 Benchmark/UploadBenchmark.cpp -lEGL -lOpenGL -o upload_benchmark
+//	EGL_PLATFORM=surfaceless LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe ./upload_benchmark --csv > results.csv
+// Options: --min <bytes> --max <bytes> --time <ms per measurement> --methods subdata,orphan,... --csv
+
+#ifdef _WIN32
+	#include <GL/glew.h>
+	#include <SDL/SDL.h>
+#else
+	#define GL_GLEXT_PROTOTYPES
+	#include <GL/glcorearb.h>
+	#include <EGL/egl.h>
+	#include <EGL/eglext.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+/****************************************************************************
+ *						Headless OpenGL 4.5 context							*/
+
+#ifdef _WIN32
+struct Context {
+	SDL_Window* window = nullptr;
+	SDL_GLContext context = nullptr;
+	bool create() {
+		if (SDL_Init(SDL_INIT_VIDEO) != 0) return false;
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		window = SDL_CreateWindow("UploadBenchmark", 0, 0, 16, 16, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+		if (window == nullptr) return false;
+		context = SDL_GL_CreateContext(window);
+		if (context == nullptr) return false;
+		glewExperimental = GL_TRUE;
+		return glewInit() == GLEW_OK;
+	}
+	~Context() {
+		if (context != nullptr) SDL_GL_DeleteContext(context);
+		if (window != nullptr) SDL_DestroyWindow(window);
+		SDL_Quit();
+	}
+};
+#else
+struct Context {
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+	bool create() {
+		auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if (getPlatformDisplay != nullptr)
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display == EGL_NO_DISPLAY)
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) return false;
+		if (!eglBindAPI(EGL_OPENGL_API)) return false;
+		const EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		EGLConfig config = EGL_NO_CONFIG_KHR; EGLint num_configs = 0;
+		if (!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) || num_configs == 0)
+			config = EGL_NO_CONFIG_KHR; // surfaceless displays may expose no configs at all (EGL_KHR_no_config_context)
+		const EGLint context_attribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+		if (context == EGL_NO_CONTEXT) return false;
+		return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_TRUE; // EGL_KHR_surfaceless_context
+	}
+	~Context() {
+		if (context != EGL_NO_CONTEXT) { eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT); eglDestroyContext(display, context); }
+		if (display != EGL_NO_DISPLAY) eglTerminate(display);
+	}
+};
+#endif
+
+using Clock = std::chrono::steady_clock;
+double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+/****************************************************************************
+ *						Upload methods										*/
+
+// Fenced ring of 'num' regions, each 'size' bytes, like StreamBuffer
+struct FencedRing {
+	std::vector<GLsync> fences;
+	GLsizeiptr size = 0;
+	GLuint current = 0;
+	FencedRing(GLsizeiptr size, GLuint num) : fences(num, nullptr), size(size) {}
+	~FencedRing() { for (GLsync f : fences) if (f != nullptr) glDeleteSync(f); }
+	GLintptr begin() {
+		GLsync& fence = fences[current];
+		if (fence != nullptr) {
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+		return size * current;
+	}
+	void end() {
+		fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		current = (current + 1) % static_cast<GLuint>(fences.size());
+	}
+};
+
+constexpr GLuint RING_REGIONS = 3;
+
+// One method prepared for one size: 'upload' does a single upload of 'size' bytes from 'src'
+struct Method {
+	const char* name;
+	std::function<std::function<void(const char* src)>(GLsizeiptr size, std::vector<GLuint>& buffers)> prepare;
+};
+
+GLuint createBuffer(std::vector<GLuint>& buffers) {
+	GLuint id = 0;
+	glGenBuffers(1, &id);
+	glBindBuffer(GL_ARRAY_BUFFER, id);
+	buffers.push_back(id);
+	return id;
+}
+
+std::vector<Method> allMethods()
+{
+	std::vector<Method> methods;
+	methods.push_back({ "subdata", [](GLsizeiptr size, std::vector<GLuint>& buffers) {
+		GLuint buffer = createBuffer(buffers);
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+		return std::function<void(const char*)>([buffer, size](const char* src) {
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, size, src);
+		});
+	} });
+	methods.push_back({ "orphan", [](GLsizeiptr size, std::vector<GLuint>& buffers) {
+		GLuint buffer = createBuffer(buffers);
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		return std::function<void(const char*)>([buffer, size](const char* src) {
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, size, src);
+		});
+	} });
+	methods.push_back({ "unsync", [](GLsizeiptr size, std::vector<GLuint>& buffers) {
+		GLuint buffer = createBuffer(buffers);
+		glBufferData(GL_ARRAY_BUFFER, size * RING_REGIONS, nullptr, GL_STREAM_DRAW);
+		auto ring = std::make_shared<FencedRing>(size, RING_REGIONS);
+		return std::function<void(const char*)>([buffer, size, ring](const char* src) {
+			const GLintptr offset = ring->begin();
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			void* dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+			std::memcpy(dst, src, size);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			ring->end();
+		});
+	} });
+	methods.push_back({ "persistent", [](GLsizeiptr size, std::vector<GLuint>& buffers) {
+		createBuffer(buffers);
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size * RING_REGIONS, nullptr, flags);
+		char* mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size * RING_REGIONS, flags));
+		auto ring = std::make_shared<FencedRing>(size, RING_REGIONS);
+		return std::function<void(const char*)>([mapped, size, ring](const char* src) {
+			std::memcpy(mapped + ring->begin(), src, size);
+			ring->end();
+		});
+	} });
+	methods.push_back({ "staging", [](GLsizeiptr size, std::vector<GLuint>& buffers) {
+		GLuint target = createBuffer(buffers);
+		glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, 0);
+		GLuint staging = createBuffer(buffers);
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size * RING_REGIONS, nullptr, flags);
+		char* mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size * RING_REGIONS, flags));
+		auto ring = std::make_shared<FencedRing>(size, RING_REGIONS);
+		return std::function<void(const char*)>([mapped, size, ring, staging, target](const char* src) {
+			const GLintptr offset = ring->begin();
+			std::memcpy(mapped + offset, src, size);
+			glBindBuffer(GL_COPY_READ_BUFFER, staging);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, size);
+			ring->end();
+		});
+	} });
+	return methods;
+}
+
+/****************************************************************************
+ *						Measurement											*/
+
+struct Result {
+	size_t iterations = 0;
+	double throughput = 0;		// bytes per second, GPU completion included
+	double cpu_per_call = 0;	// seconds spent in one upload call
+};
+
+Result measure(const Method& method, GLsizeiptr size, const std::vector<char>& source, double min_time)
+{
+	std::vector<GLuint> buffers;
+	Result result;
+	{
+		std::function<void(const char*)> upload = method.prepare(size, buffers);
+		upload(source.data()); // warm up: first touch of the storage
+		glFinish();
+
+		double cpu_time = 0;
+		const Clock::time_point start = Clock::now();
+		do {
+			const Clock::time_point call_start = Clock::now();
+			upload(source.data());
+			cpu_time += seconds(Clock::now() - call_start);
+			++result.iterations;
+		} while (result.iterations < 3 || (seconds(Clock::now() - start) < min_time && result.iterations < 100000));
+		glFinish();
+		const double wall_time = seconds(Clock::now() - start);
+
+		result.throughput = static_cast<double>(size) * result.iterations / wall_time;
+		result.cpu_per_call = cpu_time / result.iterations;
+	} // the upload functor (and its fences) die before the buffers
+	glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+	return result;
+}
+
+std::string formatSize(GLsizeiptr size)
+{
+	if (size >= (1 << 20)) return std::to_string(size >> 20) + " MB";
+	if (size >= (1 << 10)) return std::to_string(size >> 10) + " KB";
+	return std::to_string(size) + " B";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	GLsizeiptr min_size = 64, max_size = GLsizeiptr(256) << 20;
+	double min_time = 0.2;
+	bool csv = false;
+	std::string method_filter;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if (arg == "--min" && has_value)			min_size = std::atoll(argv[++i]);
+		else if (arg == "--max" && has_value)		max_size = std::atoll(argv[++i]);
+		else if (arg == "--time" && has_value)		min_time = std::atof(argv[++i]) / 1000.0;
+		else if (arg == "--methods" && has_value)	method_filter = "," + std::string(argv[++i]) + ",";
+		else if (arg == "--csv")					csv = true;
+		else { std::fprintf(stderr, "usage: %s [--min bytes] [--max bytes] [--time ms] [--methods subdata,orphan,unsync,persistent,staging] [--csv]\n", argv[0]); return 1; }
+	}
+
+	Context context;
+	if (!context.create()) { std::fprintf(stderr, "Could not create an OpenGL 4.5 core context.\n"); return 1; }
+	std::fprintf(stderr, "%s | %s | %s\n", glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	std::vector<char> source(static_cast<size_t>(max_size));
+	for (size_t i = 0; i < source.size(); ++i) source[i] = static_cast<char>(i * 7);
+
+	if (csv) std::printf("method,size,iterations,throughput_MBps,cpu_us_per_call\n");
+	else std::printf("%-11s %10s %10s %14s %16s\n", "method", "size", "iterations", "MB/s", "CPU us/call");
+	for (const Method& method : allMethods()) {
+		if (!method_filter.empty() && method_filter.find("," + std::string(method.name) + ",") == std::string::npos) continue;
+		for (GLsizeiptr size = min_size; size <= max_size; size *= 4) {
+			const Result r = measure(method, size, source, min_time);
+			if (glGetError() != GL_NO_ERROR) std::fprintf(stderr, "GL error in %s at %s\n", method.name, formatSize(size).c_str());
+			if (csv) std::printf("%s,%lld,%zu,%.3f,%.3f\n", method.name, static_cast<long long>(size), r.iterations, r.throughput / 1e6, r.cpu_per_call * 1e6);
+			else std::printf("%-11s %10s %10zu %14.1f %16.3f\n", method.name, formatSize(size).c_str(), r.iterations, r.throughput / 1e6, r.cpu_per_call * 1e6);
+			std::fflush(stdout);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include "BindingTable.h"
+
+using namespace eltecg::ogl;
+
+int BindingTable::targetIndex(BufferType type)
+{
+	switch (type) {
+	case BufferType::UNIFORM_BUFFER:			return 0;
+	case BufferType::SHADER_STORAGE_BUFFER:		return 1;
+	case BufferType::ATOMIC_COUNTER_BUFFER:		return 2;
+	case BufferType::TRANSFORM_FEEDBACK_BUFFER:	return 3;
+	default: ASSERT(false, "BindingTable: invalid buffer type for an indexed binding."); return 0;
+	}
+}
+
+GLenum BindingTable::targetEnum(int target)
+{
+	static const GLenum targets[TARGET_NUM] = { GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_ATOMIC_COUNTER_BUFFER, GL_TRANSFORM_FEEDBACK_BUFFER };
+	return targets[target];
+}
+
+BindingTable& BindingTable::setBuffer(BufferType type, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	ASSERT(buffer == 0 || size > 0, "BindingTable: the bound range cannot be empty.");
+	std::vector<BufferSlot>& slots = m_buffers[targetIndex(type)];
+	if (slots.size() <= index) slots.resize(index + 1);
+	slots[index] = buffer == 0 ? BufferSlot{ 0, 0, 0, true } : BufferSlot{ buffer, offset, size, true };
+	return *this;
+}
+
+BindingTable& BindingTable::setTexture(GLuint unit, GLuint texture)
+{
+	if (m_textures.size() <= unit) m_textures.resize(unit + 1);
+	m_textures[unit] = NameSlot{ texture, true };
+	return *this;
+}
+
+BindingTable& BindingTable::setSampler(GLuint unit, GLuint sampler)
+{
+	if (m_samplers.size() <= unit) m_samplers.resize(unit + 1);
+	m_samplers[unit] = NameSlot{ sampler, true };
+	return *this;
+}
+
+void BindingTable::clear()
+{
+	for (std::vector<BufferSlot>& slots : m_buffers) slots.clear();
+	m_textures.clear();
+	m_samplers.clear();
+}
+
+void BindingTable::invalidate()
+{
+	s_current() = CurrentState();
+}
+
+// A slot needs binding if the table sets it to something else than what is known to be bound.
+// Slots between two changed ones are sent along with the table's (or the current) value, so the
+// changes go out in a single call. This is only impossible if a slot in the gap is neither set
+// by the table nor known, then the span is split there.
+int BindingTable::bindBuffers(int target, const std::vector<BufferSlot>& wanted, std::vector<BufferSlot>& current)
+{
+	if (current.size() < wanted.size()) current.resize(wanted.size());
+	std::vector<GLuint> buffers;
+	std::vector<GLintptr> offsets;
+	std::vector<GLsizeiptr> sizes;
+	GLuint first = 0, gap_begin = 0;
+	int calls = 0;
+	auto flush = [&]() {
+		if (buffers.empty()) return;
+		glBindBuffersRange(targetEnum(target), first, static_cast<GLsizei>(buffers.size()), buffers.data(), offsets.data(), sizes.data());
+		buffers.clear(); offsets.clear(); sizes.clear();
+		++calls;
+	};
+	for (GLuint i = 0; i < wanted.size(); ++i) {
+		if (!wanted[i].used || (current[i].used && wanted[i] == current[i])) continue;
+		for (GLuint j = gap_begin; j < i && !buffers.empty(); ++j)
+			if (!wanted[j].used && !current[j].used) flush();
+		for (GLuint j = gap_begin; j < i && !buffers.empty(); ++j) {
+			const BufferSlot& slot = wanted[j].used ? wanted[j] : current[j];
+			buffers.push_back(slot.buffer); offsets.push_back(slot.offset); sizes.push_back(slot.size);
+		}
+		if (buffers.empty()) first = i;
+		buffers.push_back(wanted[i].buffer); offsets.push_back(wanted[i].offset); sizes.push_back(wanted[i].size);
+		current[i] = wanted[i];
+		gap_begin = i + 1;
+	}
+	flush();
+	return calls;
+}
+
+// Same as bindBuffers, for texture units (glBindTextures) or sampler units (glBindSamplers).
+int BindingTable::bindNames(bool textures, const std::vector<NameSlot>& wanted, std::vector<NameSlot>& current)
+{
+	if (current.size() < wanted.size()) current.resize(wanted.size());
+	std::vector<GLuint> names;
+	GLuint first = 0, gap_begin = 0;
+	int calls = 0;
+	auto flush = [&]() {
+		if (names.empty()) return;
+		if (textures)	glBindTextures(first, static_cast<GLsizei>(names.size()), names.data());
+		else			glBindSamplers(first, static_cast<GLsizei>(names.size()), names.data());
+		names.clear();
+		++calls;
+	};
+	for (GLuint i = 0; i < wanted.size(); ++i) {
+		if (!wanted[i].used || (current[i].used && wanted[i].name == current[i].name)) continue;
+		for (GLuint j = gap_begin; j < i && !names.empty(); ++j)
+			if (!wanted[j].used && !current[j].used) flush();
+		for (GLuint j = gap_begin; j < i && !names.empty(); ++j)
+			names.push_back(wanted[j].used ? wanted[j].name : current[j].name);
+		if (names.empty()) first = i;
+		names.push_back(wanted[i].name);
+		current[i] = wanted[i];
+		gap_begin = i + 1;
+	}
+	flush();
+	return calls;
+}
+
+int BindingTable::bind() const
+{
+	CurrentState& current = s_current();
+	int calls = 0;
+	for (int target = 0; target < TARGET_NUM; ++target)
+		calls += bindBuffers(target, m_buffers[target], current.buffers[target]);
+	calls += bindNames(true, m_textures, current.textures);
+	calls += bindNames(false, m_samplers, current.samplers);
+	GL_CHECK;
+	return calls;
+}
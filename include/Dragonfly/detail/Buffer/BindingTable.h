@@ -0,0 +1,93 @@
+#pragma once
+#include "../buffer.h"
+#include <vector>
+
+//namespace for opengl base classes
+namespace eltecg { namespace ogl {
+
+/****************************************************************************
+ *						Indexed binding table								*
+ ****************************************************************************/
+//https://www.khronos.org/opengl/wiki/Vertex_Rendering#Multibind_and_state
+// Collects the indexed buffer ranges, textures and samplers a draw or dispatch needs.
+// bind() compares them to what is currently bound and issues one glBindBuffersRange per
+// buffer target (and one glBindTextures/glBindSamplers) for the changed contiguous span only.
+// Slots that are not set in the table are left as they are.
+//	BindingTable table;
+//	table.setBuffer(0, particles).setBuffer(1, forces).setTexture(0, noise_id);
+//	table.bind();	// then glDispatchCompute(...)
+// If something else changes these bindings (Buffer::bindBufferRange, Texture::bind(unit),
+// ImGui, ...), call BindingTable::invalidate() so that the next bind() does not skip it.
+class BindingTable
+{
+public:
+	BindingTable() = default;
+
+/****************************************************************************
+ *						Filling the table									*/
+
+	//Sets an indexed buffer binding. size == 0 means until the end of the buffer.
+	template<BufferType T_buffer_type>
+	BindingTable& setBuffer(GLuint index, const Buffer<T_buffer_type>& buffer, GLintptr offset = 0, GLsizeiptr size = 0);
+	//Raw version, 'size' has to be the exact size in bytes
+	BindingTable& setBuffer(BufferType type, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+	//Texture to a texture unit (the raw name, eg. (GLuint)texture), 0 unbinds
+	BindingTable& setTexture(GLuint unit, GLuint texture);
+	//Sampler object to a texture unit, 0 means the texture's own sampling state
+	BindingTable& setSampler(GLuint unit, GLuint sampler);
+
+	//Removes every slot from the table (does not unbind anything)
+	void clear();
+
+/****************************************************************************
+ *						Binding												*/
+
+	//Binds the changed slots. Returns the number of multi-bind calls issued.
+	int bind() const;
+
+	//Forgets the cached current bindings, so the next bind() sets every slot of the table.
+	static void invalidate();
+
+protected:
+	struct BufferSlot {
+		GLuint buffer = 0;	GLintptr offset = 0;	GLsizeiptr size = 0;	bool used = false;
+		bool operator==(const BufferSlot& o) const { return buffer == o.buffer && offset == o.offset && size == o.size; }
+		bool operator!=(const BufferSlot& o) const { return !(*this == o); }
+	};
+	struct NameSlot {
+		GLuint name = 0;	bool used = false;
+	};
+
+	static constexpr int TARGET_NUM = 4;
+	static int targetIndex(BufferType type);
+	static GLenum targetEnum(int target);
+
+	// what is bound right now (shared by all tables)
+	struct CurrentState {
+		std::vector<BufferSlot> buffers[TARGET_NUM];
+		std::vector<NameSlot> textures, samplers;
+	};
+	static CurrentState& s_current() { static CurrentState state; return state; }
+
+	static int bindBuffers(int target, const std::vector<BufferSlot>& wanted, std::vector<BufferSlot>& current);
+	static int bindNames(bool textures, const std::vector<NameSlot>& wanted, std::vector<NameSlot>& current);
+
+/****************************************************************************
+ *						Variables											*/
+	std::vector<BufferSlot> m_buffers[TARGET_NUM];	// per target, indexed by the binding index
+	std::vector<NameSlot> m_textures;				// indexed by texture unit
+	std::vector<NameSlot> m_samplers;				// indexed by texture unit
+};
+
+template<BufferType T_buffer_type>
+inline BindingTable& BindingTable::setBuffer(GLuint index, const Buffer<T_buffer_type>& buffer, GLintptr offset, GLsizeiptr size)
+{
+	static_assert(T_buffer_type == BufferType::TRANSFORM_FEEDBACK_BUFFER
+		|| T_buffer_type == BufferType::UNIFORM_BUFFER
+		|| T_buffer_type == BufferType::ATOMIC_COUNTER_BUFFER
+		|| T_buffer_type == BufferType::SHADER_STORAGE_BUFFER, "Invalid buffer type for an indexed binding.");
+	return setBuffer(T_buffer_type, index, buffer, offset, size == 0 ? buffer.getSize() - offset : size);
+}
+
+}} //namespace eltecg::ogl
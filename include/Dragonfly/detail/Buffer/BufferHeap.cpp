@@ -0,0 +1,153 @@
+#include "BufferHeap.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace eltecg::ogl;
+
+OffsetAllocator::OffsetAllocator(GLsizeiptr capacity) : m_capacity(capacity)
+{
+	if (capacity > 0) insertFree(0, capacity);
+}
+
+void OffsetAllocator::insertFree(GLintptr offset, GLsizeiptr size)
+{
+	m_free_by_offset.emplace(offset, size);
+	m_free_by_size.emplace(size, offset);
+}
+
+void OffsetAllocator::eraseFree(std::map<GLintptr, GLsizeiptr>::iterator it)
+{
+	auto range = m_free_by_size.equal_range(it->second);
+	for (auto s = range.first; s != range.second; ++s)
+		if (s->second == it->first) { m_free_by_size.erase(s); break; }
+	m_free_by_offset.erase(it);
+}
+
+OffsetAllocator::Handle OffsetAllocator::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+	ASSERT(size > 0 && alignment > 0, "OffsetAllocator: invalid size or alignment.");
+	// best fit: the smallest free block that can hold the aligned range
+	auto fit = m_free_by_size.lower_bound(size);
+	GLintptr aligned = 0;
+	for (; fit != m_free_by_size.end(); ++fit) {
+		aligned = (fit->second + alignment - 1) / alignment * alignment;
+		if (aligned + size <= fit->second + fit->first) break;
+	}
+	if (fit == m_free_by_size.end()) return INVALID_HANDLE;
+
+	const GLintptr block_offset = fit->second;
+	const GLsizeiptr block_size = fit->first;
+	eraseFree(m_free_by_offset.find(block_offset));
+	// the remainder after the range goes back to the free list, the padding in front stays with the allocation
+	const GLintptr end = aligned + size;
+	if (end < block_offset + block_size) insertFree(end, block_offset + block_size - end);
+	m_used += end - block_offset;
+
+	Handle handle;
+	if (!m_free_handles.empty()) { handle = m_free_handles.back(); m_free_handles.pop_back(); }
+	else { handle = static_cast<Handle>(m_ranges.size()); m_ranges.emplace_back(); m_padding.emplace_back(); }
+	m_ranges[handle] = Range{ aligned, size, alignment };
+	m_padding[handle] = aligned - block_offset;
+	return handle;
+}
+
+void OffsetAllocator::free(Handle handle)
+{
+	ASSERT(isValid(handle), "OffsetAllocator: invalid handle or double free.");
+	if (!isValid(handle)) return;
+	GLintptr offset = m_ranges[handle].offset - m_padding[handle];
+	GLsizeiptr size = m_ranges[handle].size + m_padding[handle];
+	m_used -= size;
+	m_ranges[handle] = Range{};
+	m_padding[handle] = 0;
+	m_free_handles.push_back(handle);
+
+	// coalesce with the neighbours
+	auto next = m_free_by_offset.lower_bound(offset);
+	if (next != m_free_by_offset.end() && next->first == offset + size) {
+		size += next->second;
+		eraseFree(next);
+	}
+	auto after = m_free_by_offset.lower_bound(offset);
+	if (after != m_free_by_offset.begin()) {
+		auto prev = std::prev(after);
+		if (prev->first + prev->second == offset) {
+			offset = prev->first;
+			size += prev->second;
+			eraseFree(prev);
+		}
+	}
+	insertFree(offset, size);
+}
+
+void OffsetAllocator::clear()
+{
+	m_free_by_offset.clear();
+	m_free_by_size.clear();
+	m_ranges.clear();
+	m_padding.clear();
+	m_free_handles.clear();
+	m_used = 0;
+	if (m_capacity > 0) insertFree(0, m_capacity);
+}
+
+void OffsetAllocator::grow(GLsizeiptr new_capacity)
+{
+	ASSERT(new_capacity >= m_capacity, "OffsetAllocator: cannot shrink.");
+	if (new_capacity <= m_capacity) return;
+	GLintptr offset = m_capacity;
+	GLsizeiptr size = new_capacity - m_capacity;
+	if (!m_free_by_offset.empty()) {
+		auto last = std::prev(m_free_by_offset.end());
+		if (last->first + last->second == m_capacity) {
+			offset = last->first;
+			size += last->second;
+			eraseFree(last);
+		}
+	}
+	insertFree(offset, size);
+	m_capacity = new_capacity;
+}
+
+std::vector<OffsetAllocator::Move> OffsetAllocator::compact()
+{
+	std::vector<Handle> live;
+	live.reserve(getAllocationCount());
+	for (Handle h = 0; h < m_ranges.size(); ++h)
+		if (m_ranges[h].size != 0) live.push_back(h);
+	std::sort(live.begin(), live.end(), [this](Handle a, Handle b) { return m_ranges[a].offset < m_ranges[b].offset; });
+
+	std::vector<Move> moves;
+	GLintptr end = 0;
+	for (Handle h : live) {
+		Range& r = m_ranges[h];
+		const GLintptr to = (end + r.alignment - 1) / r.alignment * r.alignment;
+		// once something moved, everything after it is reported, so the moved span is contiguous
+		if (to != r.offset || !moves.empty()) {
+			Move m{ r.offset, to, r.size };
+			if (!moves.empty() && moves.back().from - moves.back().to == m.from - m.to)
+				moves.back().size = m.to + m.size - moves.back().to; // same shift as the previous one: merge
+			else
+				moves.push_back(m);
+		}
+		m_padding[h] = to - end;
+		r.offset = to;
+		end = to + r.size;
+	}
+	m_free_by_offset.clear();
+	m_free_by_size.clear();
+	m_used = end;
+	if (end < m_capacity) insertFree(end, m_capacity - end);
+	return moves;
+}
+
+GLsizeiptr OffsetAllocator::getLargestFreeBlock() const
+{
+	return m_free_by_size.empty() ? 0 : std::prev(m_free_by_size.end())->first;
+}
+
+float OffsetAllocator::getFragmentation() const
+{
+	const GLsizeiptr free_size = getFreeSize();
+	return free_size == 0 ? 0.f : 1.f - static_cast<float>(getLargestFreeBlock()) / static_cast<float>(free_size);
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include "../buffer.h"
+#include <cstdint>
+#include <vector>
+#include <map>
+
+//namespace for opengl base classes
+namespace eltecg { namespace ogl {
+
+/****************************************************************************
+ *						Offset allocator (CPU only)							*
+ ****************************************************************************/
+// Hands out [offset, offset+size) ranges of a linear address space. Best-fit search
+// over the free blocks ordered by size, neighbouring free blocks are merged on free.
+// Allocations are referred to by handles, so compact() can move them around.
+class OffsetAllocator
+{
+public:
+	using Handle = uint32_t;
+	static constexpr Handle INVALID_HANDLE = static_cast<Handle>(-1);
+
+	struct Range { GLintptr offset = 0; GLsizeiptr size = 0; GLsizeiptr alignment = 1; };
+	struct Move { GLintptr from, to; GLsizeiptr size; };
+
+	OffsetAllocator(GLsizeiptr capacity = 0);
+
+	//Returns INVALID_HANDLE if there is no large enough free block
+	Handle allocate(GLsizeiptr size, GLsizeiptr alignment = 1);
+	void free(Handle handle);
+	void clear();
+
+	//Packs all allocations to the beginning. Returns the (non-overlapping, ordered) moves to replay on the data.
+	std::vector<Move> compact();
+
+	//Extends the address space, old ranges stay in place
+	void grow(GLsizeiptr new_capacity);
+
+	inline const Range& getRange(Handle handle) const { ASSERT(isValid(handle), "OffsetAllocator: invalid handle."); return m_ranges[handle]; }
+	inline bool isValid(Handle handle) const { return handle < m_ranges.size() && m_ranges[handle].size != 0; }
+
+	inline GLsizeiptr getCapacity() const { return m_capacity; }
+	inline GLsizeiptr getUsedSize() const { return m_used; }
+	inline GLsizeiptr getFreeSize() const { return m_capacity - m_used; }
+	GLsizeiptr getLargestFreeBlock() const;
+	inline size_t getFreeBlockCount() const { return m_free_by_offset.size(); }
+	inline size_t getAllocationCount() const { return m_ranges.size() - m_free_handles.size(); }
+	//0 if all free memory is in one block, close to 1 if it is scattered in small pieces
+	float getFragmentation() const;
+
+protected:
+	void insertFree(GLintptr offset, GLsizeiptr size);
+	void eraseFree(std::map<GLintptr, GLsizeiptr>::iterator it);
+
+	GLsizeiptr m_capacity = 0;
+	GLsizeiptr m_used = 0;	// including alignment padding
+	std::map<GLintptr, GLsizeiptr>		m_free_by_offset;	// offset -> size
+	std::multimap<GLsizeiptr, GLintptr>	m_free_by_size;		// size -> offset
+	std::vector<Range>	m_ranges;		// handle -> range (size == 0 for unused handles)
+	std::vector<GLsizeiptr> m_padding;	// handle -> bytes wasted in front of the range for alignment
+	std::vector<Handle>	m_free_handles;
+};
+
+/****************************************************************************
+ *						GPU heap ("mega buffer")							*
+ ****************************************************************************/
+// One large immutable buffer that many meshes share. Offsets of an allocation can
+// change only by compact(), query them with getOffset() after compacting.
+//	VertexHeap vertices(256 << 20);
+//	auto mesh = vertices.allocate(mesh_vertices);	// upload, returns a handle
+//	... glDrawArrays(mode, vertices.getFirst<Vertex>(mesh), count) ...
+template<BufferType T_buffer_type>
+	class BufferHeap final
+{
+public:
+	using Handle = OffsetAllocator::Handle;
+	static constexpr Handle INVALID_HANDLE = OffsetAllocator::INVALID_HANDLE;
+
+	BufferHeap(GLsizeiptr capacity, BufferFlags flags = BufferFlags::DYNAMIC_STORAGE_BIT);
+	~BufferHeap() = default;
+
+	BufferHeap(const BufferHeap&) = delete;
+	BufferHeap& operator=(const BufferHeap&) = delete;
+	BufferHeap(BufferHeap&&) = default;
+	BufferHeap& operator=(BufferHeap&&) = default;
+
+	operator GLuint () const { return m_buffer; }
+
+	Handle allocate(GLsizeiptr size, GLsizeiptr alignment = 1) { return m_allocator.allocate(size, alignment); }
+	//Allocates room for the container (aligned to its value type) and uploads it. Needs DYNAMIC_STORAGE_BIT.
+	template<typename Container>
+	Handle allocate(const Container& container);
+	void free(Handle handle) { m_allocator.free(handle); }
+
+	//Overwrites (part of) an allocation. Needs DYNAMIC_STORAGE_BIT.
+	template<typename Container>
+	void assign(Handle handle, const Container& container, GLintptr offset = 0);
+
+	inline GLintptr getOffset(Handle handle) const { return m_allocator.getRange(handle).offset; }
+	inline GLsizeiptr getSize(Handle handle) const { return m_allocator.getRange(handle).size; }
+	//Index of the first element of the allocation (eg. 'first' or 'basevertex' of draw calls)
+	template<typename T_value>
+	inline GLint getFirst(Handle handle) const { ASSERT(getOffset(handle) % sizeof(T_value) == 0, "BufferHeap: allocation is not aligned to the value type."); return static_cast<GLint>(getOffset(handle) / sizeof(T_value)); }
+
+	//Moves every allocation to the beginning of the buffer with GPU side copies. The buffer name stays the same.
+	//Returns the number of bytes moved.
+	GLsizeiptr compact();
+
+	inline const OffsetAllocator& getAllocator() const { return m_allocator; }
+	inline float getFragmentation() const { return m_allocator.getFragmentation(); }
+	inline Buffer<T_buffer_type>& getBuffer() { return m_buffer; }
+
+protected:
+	Buffer<T_buffer_type> m_buffer;
+	OffsetAllocator m_allocator;
+	BufferFlags m_flags;
+};
+
+template<BufferType T_buffer_type>
+inline BufferHeap<T_buffer_type>::BufferHeap(GLsizeiptr capacity, BufferFlags flags)
+	: m_allocator(capacity), m_flags(flags)
+{
+	m_buffer.allocateImmutable(capacity, flags);
+}
+
+template<BufferType T_buffer_type>
+template<typename Container>
+inline typename BufferHeap<T_buffer_type>::Handle BufferHeap<T_buffer_type>::allocate(const Container& container)
+{
+	using value_type = std::decay_t<decltype(*container.data())>;
+	Handle handle = m_allocator.allocate(container.size() * sizeof(value_type), sizeof(value_type));
+	ASSERT(handle != INVALID_HANDLE, "BufferHeap: out of memory. Try compact() or a larger heap.");
+	if (handle != INVALID_HANDLE)
+		this->assign(handle, container);
+	return handle;
+}
+
+template<BufferType T_buffer_type>
+template<typename Container>
+inline void BufferHeap<T_buffer_type>::assign(Handle handle, const Container& container, GLintptr offset)
+{
+	using value_type = std::decay_t<decltype(*container.data())>;
+	ASSERT(m_flags && BufferFlags::DYNAMIC_STORAGE_BIT, "BufferHeap: the heap was not created with DYNAMIC_STORAGE_BIT.");
+	const OffsetAllocator::Range& range = m_allocator.getRange(handle);
+	const GLsizeiptr to_write = container.size() * sizeof(value_type);
+	ASSERT(offset + to_write <= range.size, "BufferHeap: container is larger than the allocation.");
+	glNamedBufferSubData(m_buffer, range.offset + offset, to_write, (const GLvoid*)container.data());
+}
+
+template<BufferType T_buffer_type>
+inline GLsizeiptr BufferHeap<T_buffer_type>::compact()
+{
+	std::vector<OffsetAllocator::Move> moves = m_allocator.compact();
+	if (moves.empty()) return 0;
+	// Ranges may overlap when moved inside one buffer, so the packed data goes through a temporary
+	// buffer first, and then comes back in a single copy.
+	const GLintptr first = moves.front().to;
+	const GLintptr last = moves.back().to + moves.back().size;
+	Buffer<BufferType::COPY_WRITE_BUFFER> temp;
+	temp.allocateImmutable(last - first);
+	GLsizeiptr moved = 0;
+	for (const OffsetAllocator::Move& m : moves) {
+		temp.copyBufferSubData(m_buffer, m.from, m.to - first, m.size);
+		moved += m.size;
+	}
+	m_buffer.copyBufferSubData(temp, 0, first, last - first);
+	return moved;
+}
+
+using VertexHeap = BufferHeap<BufferType::ARRAY_BUFFER>;
+using IndexHeap = BufferHeap<BufferType::ELEMENT_ARRAY_BUFFER>;
+
+}} //namespace eltecg::ogl
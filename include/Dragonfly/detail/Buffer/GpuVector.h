@@ -0,0 +1,190 @@
+#pragma once
+#include "../buffer.h"
+#include <utility>
+
+//namespace for opengl base classes
+namespace eltecg { namespace ogl {
+
+/****************************************************************************
+ *						Growable GPU array									*
+ ****************************************************************************/
+// std::vector-like array that lives only on the GPU. The storage is immutable, growing it
+// allocates a new store with double capacity and copies the old contents over on the GPU,
+// so the data never travels back to the CPU. Push, set and erase are small uploads or GPU copies.
+//	GpuVector<Particle, BufferType::SHADER_STORAGE_BUFFER> particles;
+//	particles.push_back(spawned);		// amortized O(1), may reallocate
+//	particles.erase_swap(dead_index);	// moves the last element into the hole (GPU side)
+// Reallocation changes the buffer name, so VAOs and bindings that refer to it have to be updated:
+// check getGeneration() (it changes on every reallocation).
+template<typename T_value, BufferType T_buffer_type = BufferType::ARRAY_BUFFER>
+	class GpuVector final
+{
+public:
+	using value_type = T_value;
+
+	GpuVector(size_t initial_capacity = 0);
+	template<typename Container>
+	explicit GpuVector(const Container& container);
+
+	GpuVector(const GpuVector&) = delete;
+	GpuVector& operator=(const GpuVector&) = delete;
+	GpuVector(GpuVector&&) = default;
+	GpuVector& operator=(GpuVector&&) = default;
+
+	operator GLuint () const { return m_buffer; }
+
+/****************************************************************************
+ *						Modifiers											*/
+
+	void push_back(const T_value& value);
+	//Appends every element of the container (one upload)
+	template<typename Container>
+	void append(const Container& container);
+	void pop_back() { ASSERT(m_size > 0, "GpuVector: pop_back on an empty vector."); --m_size; }
+	//Moves the last element to 'index' (GPU side copy), then removes the last one. Does not keep the order.
+	void erase_swap(size_t index);
+
+	//New elements are zero initialized
+	void resize(size_t new_size);
+	void reserve(size_t new_capacity);
+	void shrink_to_fit();
+	void clear() { m_size = 0; }
+
+	//Overwrites the element at 'index'
+	void set(size_t index, const T_value& value);
+	//Overwrites elements starting from 'first'
+	template<typename Container>
+	void assign(const Container& container, size_t first = 0);
+
+/****************************************************************************
+ *						Getters												*/
+
+	inline size_t size() const { return m_size; }
+	inline size_t capacity() const { return m_capacity; }
+	inline bool empty() const { return m_size == 0; }
+	inline GLsizeiptr getSizeInBytes() const { return static_cast<GLsizeiptr>(m_size * sizeof(T_value)); }
+	//Changes every time the storage is reallocated (and so the buffer name changes)
+	inline size_t getGeneration() const { return m_generation; }
+
+	inline Buffer<T_buffer_type>& getBuffer() { return m_buffer; }
+	inline void bindBuffer() { m_buffer.bindBuffer(); }
+	//Binds the used part [0, size) to an indexed binding point, does nothing if empty (size 0 would mean the whole buffer)
+	inline void bindBufferRange(GLuint index) { if (!empty()) m_buffer.bindBufferRange(index, 0, getSizeInBytes()); }
+
+protected:
+	//Reallocates to exactly 'new_capacity' elements, copying [0, size) over on the GPU
+	void reallocate(size_t new_capacity);
+	//Makes room for at least 'required' elements with geometric growth
+	void grow(size_t required);
+
+	Buffer<T_buffer_type> m_buffer;
+	size_t m_size = 0;
+	size_t m_capacity = 0;
+	size_t m_generation = 0;
+};
+
+template<typename T_value, BufferType T_buffer_type>
+inline GpuVector<T_value, T_buffer_type>::GpuVector(size_t initial_capacity)
+{
+	static_assert(std::is_trivially_copyable_v<T_value>, "GpuVector: the value type has to be trivially copyable.");
+	if (initial_capacity > 0) reallocate(initial_capacity);
+}
+
+template<typename T_value, BufferType T_buffer_type>
+template<typename Container>
+inline GpuVector<T_value, T_buffer_type>::GpuVector(const Container& container) : GpuVector(container.size())
+{
+	append(container);
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void GpuVector<T_value, T_buffer_type>::reallocate(size_t new_capacity)
+{
+	ASSERT(new_capacity >= m_size, "GpuVector: cannot reallocate to less than the size.");
+	Buffer<T_buffer_type> new_buffer;
+	// at least one element, GL does not allow zero sized storage
+	new_buffer.allocateImmutable(static_cast<GLsizeiptr>((new_capacity > 0 ? new_capacity : 1) * sizeof(T_value)), BufferFlags::DYNAMIC_STORAGE_BIT);
+	if (m_size > 0)
+		new_buffer.copyBufferSubData(m_buffer, 0, 0, getSizeInBytes());
+	m_buffer = std::move(new_buffer); // the old store is deleted with new_buffer
+	m_capacity = new_capacity;
+	++m_generation;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void GpuVector<T_value, T_buffer_type>::grow(size_t required)
+{
+	if (required <= m_capacity) return;
+	size_t new_capacity = m_capacity < 16 ? 16 : m_capacity;
+	while (new_capacity < required) new_capacity *= 2;
+	reallocate(new_capacity);
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void GpuVector<T_value, T_buffer_type>::push_back(const T_value& value)
+{
+	grow(m_size + 1);
+	glNamedBufferSubData(m_buffer, static_cast<GLintptr>(m_size * sizeof(T_value)), sizeof(T_value), &value);
+	++m_size;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+template<typename Container>
+inline void GpuVector<T_value, T_buffer_type>::append(const Container& container)
+{
+	static_assert(std::is_same_v<std::decay_t<decltype(*container.data())>, T_value>, "GpuVector: container has a different value type.");
+	if (container.size() == 0) return;
+	grow(m_size + container.size());
+	glNamedBufferSubData(m_buffer, static_cast<GLintptr>(m_size * sizeof(T_value)), static_cast<GLsizeiptr>(container.size() * sizeof(T_value)), container.data());
+	m_size += container.size();
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void GpuVector<T_value, T_buffer_type>::erase_swap(size_t index)
+{
+	ASSERT(index < m_size, "GpuVector: index out of range.");
+	if (index + 1 < m_size)
+		m_buffer.copyBufferSubData(m_buffer, (m_size - 1) * sizeof(T_value), index * sizeof(T_value), sizeof(T_value));
+	--m_size;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void GpuVector<T_value, T_buffer_type>::resize(size_t new_size)
+{
+	if (new_size > m_size) {
+		grow(new_size);
+		glClearNamedBufferSubData(m_buffer, GL_R8UI, static_cast<GLintptr>(m_size * sizeof(T_value)),
+			static_cast<GLsizeiptr>((new_size - m_size) * sizeof(T_value)), GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+	}
+	m_size = new_size;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void GpuVector<T_value, T_buffer_type>::reserve(size_t new_capacity)
+{
+	if (new_capacity > m_capacity) reallocate(new_capacity);
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void GpuVector<T_value, T_buffer_type>::shrink_to_fit()
+{
+	if (m_size < m_capacity) reallocate(m_size);
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void GpuVector<T_value, T_buffer_type>::set(size_t index, const T_value& value)
+{
+	ASSERT(index < m_size, "GpuVector: index out of range.");
+	glNamedBufferSubData(m_buffer, static_cast<GLintptr>(index * sizeof(T_value)), sizeof(T_value), &value);
+}
+
+template<typename T_value, BufferType T_buffer_type>
+template<typename Container>
+inline void GpuVector<T_value, T_buffer_type>::assign(const Container& container, size_t first)
+{
+	static_assert(std::is_same_v<std::decay_t<decltype(*container.data())>, T_value>, "GpuVector: container has a different value type.");
+	ASSERT(first + container.size() <= m_size, "GpuVector: assigned range is out of range, use resize or append first.");
+	glNamedBufferSubData(m_buffer, static_cast<GLintptr>(first * sizeof(T_value)), static_cast<GLsizeiptr>(container.size() * sizeof(T_value)), container.data());
+}
+
+}} //namespace eltecg::ogl
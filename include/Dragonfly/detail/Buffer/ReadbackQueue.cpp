@@ -0,0 +1,96 @@
+#include "ReadbackQueue.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace eltecg::ogl;
+
+ReadbackQueue::ReadbackQueue(GLsizeiptr staging_size)
+{
+	if (staging_size > 0) allocateStaging(staging_size);	// otherwise the first enqueue allocates
+	s_queues().push_back(this);
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+	auto& queues = s_queues();
+	queues.erase(std::remove(queues.begin(), queues.end(), this), queues.end());
+	for (PendingRead& read : m_pending) glDeleteSync(read.fence); // the promises are broken, futures throw
+	if (m_mapped != nullptr) m_staging.unmapBuffer();
+}
+
+void ReadbackQueue::allocateStaging(GLsizeiptr size)
+{
+	ASSERT(m_pending.empty(), "ReadbackQueue: cannot reallocate the staging buffer while reads are pending.");
+	if (m_mapped != nullptr) {
+		m_staging.unmapBuffer();
+		m_staging = Buffer<BufferType::COPY_WRITE_BUFFER>(); // immutable storage cannot be resized, so get a new name
+	}
+	const BufferFlags flags = BufferFlags::MAP_READ_BIT | BufferFlags::MAP_PERSISTENT_BIT | BufferFlags::MAP_COHERENT_BIT | BufferFlags::CLIENT_STORAGE_BIT;
+	m_staging.allocateImmutable(size, flags);
+	m_mapped = static_cast<const char*>(m_staging.mapBufferRange(0, size, GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+	GL_CHECK;
+	ASSERT(m_mapped != nullptr, "ReadbackQueue: persistent mapping failed.");
+	m_staging_size = size;
+	m_allocator = OffsetAllocator(size);
+}
+
+void ReadbackQueue::enqueue(GLuint buffer, GLintptr offset, GLsizeiptr size, Resolver&& resolve)
+{
+	if (size <= 0) { resolve(m_mapped, 0); return; }
+	// 16 byte alignment is enough for any value type and keeps the memcpy fast
+	OffsetAllocator::Handle range = m_allocator.allocate(size, 16);
+	while (range == OffsetAllocator::INVALID_HANDLE && !m_pending.empty()) {
+		resolveFront(true); // out of staging memory: this is the only place where we stall
+		range = m_allocator.allocate(size, 16);
+	}
+	if (range == OffsetAllocator::INVALID_HANDLE) {
+		GLsizeiptr new_size = std::max<GLsizeiptr>(m_staging_size, 1);
+		while (new_size < size) new_size *= 2;
+		allocateStaging(new_size);
+		range = m_allocator.allocate(size, 16);
+	}
+	// shader writes to SSBOs and atomic counters must be visible to the copy
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glCopyNamedBufferSubData(buffer, m_staging, offset, m_allocator.getRange(range).offset, size);
+	GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	GL_CHECK;
+	m_pending.push_back(PendingRead{ fence, range, size, std::move(resolve) });
+}
+
+void ReadbackQueue::resolveFront(bool wait)
+{
+	PendingRead read = std::move(m_pending.front());
+	m_pending.pop_front();
+	if (wait) {
+		GLenum result;
+		do	result = glClientWaitSync(read.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+		while (result == GL_TIMEOUT_EXPIRED);
+		ASSERT(result != GL_WAIT_FAILED, "ReadbackQueue: waiting for a fence failed.");
+	}
+	glDeleteSync(read.fence);
+	read.resolve(m_mapped + m_allocator.getRange(read.range).offset, read.size);
+	m_allocator.free(read.range);
+}
+
+size_t ReadbackQueue::poll()
+{
+	size_t resolved = 0;
+	while (!m_pending.empty()) {
+		const GLenum result = glClientWaitSync(m_pending.front().fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) break;
+		ASSERT(result != GL_WAIT_FAILED, "ReadbackQueue: polling a fence failed.");
+		resolveFront(false);
+		++resolved;
+	}
+	return resolved;
+}
+
+void ReadbackQueue::finish()
+{
+	while (!m_pending.empty()) resolveFront(true);
+}
+
+void ReadbackQueue::pollAll()
+{
+	for (ReadbackQueue* queue : s_queues()) queue->poll();
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "BufferHeap.h"
+#include <vector>
+#include <deque>
+#include <future>
+#include <memory>
+#include <functional>
+#include <cstring>
+
+//namespace for opengl base classes
+namespace eltecg { namespace ogl {
+
+/****************************************************************************
+ *						Asynchronous readback								*
+ ****************************************************************************/
+// Reads buffer contents back without stalling: read() copies the range into a persistently
+// mapped (MAP_READ_BIT) staging buffer on the GPU and puts a fence behind the copy. poll()
+// checks the fences without waiting and resolves the finished reads on the CPU.
+// Every living ReadbackQueue is polled once per df::Sample::Run iteration (pollAll), so
+// results typically arrive one or two frames later instead of stalling the current one.
+//	ReadbackQueue readback;
+//	std::future<std::vector<GLuint>> counts = readback.read<GLuint>(atomic_counters);
+//	... later frames: if (counts.wait_for(std::chrono::seconds(0)) == std::future_status::ready) ...
+//	readback.read<glm::vec4>(particles, [](std::vector<glm::vec4>&& data) { /* on the render thread */ });
+// Do not block on the future on the render thread before the queue got polled (it would deadlock), use finish() if you must.
+class ReadbackQueue final
+{
+public:
+	ReadbackQueue(GLsizeiptr staging_size = 1 << 20);
+	~ReadbackQueue();
+
+	ReadbackQueue(const ReadbackQueue&) = delete;
+	ReadbackQueue& operator=(const ReadbackQueue&) = delete;
+
+	//Reads 'count' elements from byte 'offset' (count == 0: until the end of the buffer)
+	template<typename T_value, BufferType T_buffer_type>
+	std::future<std::vector<T_value>> read(const Buffer<T_buffer_type>& buffer, GLintptr offset = 0, size_t count = 0);
+
+	//Same, but calls 'callback' from poll() when the data arrived
+	template<typename T_value, BufferType T_buffer_type>
+	void read(const Buffer<T_buffer_type>& buffer, std::function<void(std::vector<T_value>&&)> callback, GLintptr offset = 0, size_t count = 0);
+
+	//Resolves every read whose fence signaled, does not wait. Returns the number of resolved reads.
+	size_t poll();
+	//Waits for all pending reads and resolves them
+	void finish();
+
+	inline size_t getPendingCount() const { return m_pending.size(); }
+	inline GLsizeiptr getStagingSize() const { return m_staging_size; }
+
+	//Polls every ReadbackQueue (called by df::Sample::Run at the beginning of each frame)
+	static void pollAll();
+
+protected:
+	using Resolver = std::function<void(const char* data, GLsizeiptr size)>;
+	struct PendingRead {
+		GLsync	fence;
+		OffsetAllocator::Handle range;
+		GLsizeiptr size;
+		Resolver resolve;
+	};
+
+	//Copies the range to the staging buffer and fences it
+	void enqueue(GLuint buffer, GLintptr offset, GLsizeiptr size, Resolver&& resolve);
+	//Resolves the oldest pending read, waiting for it if needed
+	void resolveFront(bool wait);
+	//Recreates the staging buffer (only when nothing is pending)
+	void allocateStaging(GLsizeiptr size);
+
+	static std::vector<ReadbackQueue*>& s_queues() { static std::vector<ReadbackQueue*> queues; return queues; }
+
+	Buffer<BufferType::COPY_WRITE_BUFFER> m_staging;
+	OffsetAllocator m_allocator;
+	const char*	m_mapped = nullptr;
+	GLsizeiptr	m_staging_size = 0;
+	std::deque<PendingRead> m_pending;		// in submission order, fences signal in this order too
+};
+
+template<typename T_value, BufferType T_buffer_type>
+inline std::future<std::vector<T_value>> ReadbackQueue::read(const Buffer<T_buffer_type>& buffer, GLintptr offset, size_t count)
+{
+	// std::function has to be copyable, so the promise is shared
+	auto promise = std::make_shared<std::promise<std::vector<T_value>>>();
+	std::future<std::vector<T_value>> result = promise->get_future();
+	this->read<T_value>(buffer, [promise](std::vector<T_value>&& data) { promise->set_value(std::move(data)); }, offset, count);
+	return result;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void ReadbackQueue::read(const Buffer<T_buffer_type>& buffer, std::function<void(std::vector<T_value>&&)> callback, GLintptr offset, size_t count)
+{
+	static_assert(std::is_trivially_copyable_v<T_value>, "ReadbackQueue: the value type has to be trivially copyable.");
+	if (count == 0) count = static_cast<size_t>((buffer.getSize() - offset) / sizeof(T_value));
+	const GLsizeiptr size = static_cast<GLsizeiptr>(count * sizeof(T_value));
+	ASSERT(offset + size <= buffer.getSize(), "ReadbackQueue: the range to read is outside of the buffer.");
+	enqueue(buffer, offset, size, [callback = std::move(callback), count](const char* data, GLsizeiptr bytes) {
+		std::vector<T_value> values(count);
+		std::memcpy(values.data(), data, bytes);
+		callback(std::move(values));
+	});
+}
+
+}} //namespace eltecg::ogl
@@ -0,0 +1,193 @@
+#pragma once
+#include "../buffer.h"
+#include <vector>
+#include <cstring>
+
+//namespace for opengl base classes
+namespace eltecg { namespace ogl {
+
+/****************************************************************************
+ *						Persistent mapped streaming buffer					*
+ ****************************************************************************/
+//https://www.khronos.org/opengl/wiki/Buffer_Object_Streaming#Persistent_mapped_streaming
+// The storage is mapped once and split into 'num_regions' equal regions (one per frame in flight).
+// Every frame writes its data through a plain pointer into the current region, and endFrame() puts
+// a fence behind the draws that read it. A region is only written again after its fence signaled,
+// so uploads are a memcpy without any implicit synchronization in the driver.
+//	StreamBuffer<glm::mat4> transforms(1024);
+//	glm::mat4* ptr = transforms.beginFrame();		// may wait for the GPU (see getStallCount())
+//	/* fill ptr[0..1023] */							// then draw using transforms.getOffset()
+//	transforms.endFrame();
+template<typename T_value, BufferType T_buffer_type = BufferType::ARRAY_BUFFER>
+	class StreamBuffer final
+{
+public:
+/****************************************************************************
+ *						Constructors and destructors						*/
+	StreamBuffer(size_t count_per_region, GLuint num_regions = 3);
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	StreamBuffer(StreamBuffer&& o);
+	StreamBuffer& operator=(StreamBuffer&& o);
+
+	constexpr BufferType Type() const { return T_buffer_type; }
+	operator GLuint () const { return m_buffer; }
+
+/****************************************************************************
+ *						Streaming											*/
+
+	//Waits until the GPU is done with the current region, then returns a write pointer to it.
+	T_value* beginFrame();
+
+	//Fences the current region and moves on to the next one. Call it after the draws reading the region.
+	void endFrame();
+
+	//Copies the container to the current region (call between beginFrame and endFrame)
+	template<typename Container>
+	void assign(const Container& container, size_t first = 0);
+
+/****************************************************************************
+ *						Getters												*/
+
+	//Byte offset of the current region inside the buffer (bindBufferRange, glVertexArrayVertexBuffer, etc.)
+	inline GLintptr getOffset() const { return m_region_stride * m_curr_region; }
+	//Index of the first element in the current region (eg. 'first' of glDrawArrays)
+	inline GLint getFirst() const { return static_cast<GLint>(getOffset() / sizeof(T_value)); }
+	inline size_t getCount() const { return m_count_per_region; }
+	inline GLsizeiptr getRegionSize() const { return m_count_per_region * sizeof(T_value); }
+	inline GLuint getRegionIndex() const { return m_curr_region; }
+	inline GLuint getRegionNum() const { return m_num_regions; }
+	//Number of times beginFrame had to wait for a fence. If it keeps growing, use more regions.
+	inline size_t getStallCount() const { return m_stall_count; }
+
+	inline Buffer<T_buffer_type>& getBuffer() { return m_buffer; }
+
+/****************************************************************************
+ *						Binding												*/
+
+	inline void bindBuffer() { m_buffer.bindBuffer(); }
+
+	//Binds the current region to an indexed binding point
+	inline void bindBufferRange(GLuint index) { m_buffer.bindBufferRange(index, getOffset(), getRegionSize()); }
+
+protected:
+	void waitRegion(GLuint region);
+
+/****************************************************************************
+ *						Variables											*/
+	Buffer<T_buffer_type> m_buffer;
+	std::vector<GLsync>	m_fences;				// one per region, nullptr if the region is free
+	char*		m_mapped = nullptr;
+	size_t		m_count_per_region = 0;
+	GLsizeiptr	m_region_stride = 0;			// region size rounded up to the binding offset alignment
+	GLuint		m_num_regions = 0;
+	GLuint		m_curr_region = 0;
+	size_t		m_stall_count = 0;
+
+}; // StreamBuffer class
+
+template<typename T_value, BufferType T_buffer_type>
+inline StreamBuffer<T_value, T_buffer_type>::StreamBuffer(size_t count_per_region, GLuint num_regions)
+	: m_fences(num_regions, nullptr), m_count_per_region(count_per_region), m_num_regions(num_regions)
+{
+	static_assert(std::is_trivially_copyable_v<T_value>, "StreamBuffer: the value type has to be trivially copyable.");
+	ASSERT(count_per_region > 0 && num_regions > 0, "StreamBuffer: cannot create an empty stream buffer.");
+	GLint alignment = 1;
+	if constexpr (T_buffer_type == BufferType::UNIFORM_BUFFER)
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	else if constexpr (T_buffer_type == BufferType::SHADER_STORAGE_BUFFER)
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	else if constexpr (T_buffer_type == BufferType::ARRAY_BUFFER)
+		alignment = sizeof(T_value); // so that getFirst() is exact
+	const GLsizeiptr region_size = static_cast<GLsizeiptr>(count_per_region * sizeof(T_value));
+	m_region_stride = (region_size + alignment - 1) / alignment * alignment;
+
+	const BufferFlags flags = BufferFlags::MAP_WRITE_BIT | BufferFlags::MAP_PERSISTENT_BIT | BufferFlags::MAP_COHERENT_BIT;
+	m_buffer.allocateImmutable(m_region_stride * num_regions, flags);
+	m_mapped = static_cast<char*>(m_buffer.mapBufferRange(0, m_region_stride * num_regions, static_cast<GLbitfield>(flags)));
+	GL_CHECK;
+	ASSERT(m_mapped != nullptr, "StreamBuffer: persistent mapping failed.");
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline StreamBuffer<T_value, T_buffer_type>::~StreamBuffer()
+{
+	for (GLsync& fence : m_fences)
+		if (fence != nullptr) glDeleteSync(fence);
+	if (m_mapped != nullptr) m_buffer.unmapBuffer();
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline StreamBuffer<T_value, T_buffer_type>::StreamBuffer(StreamBuffer&& o)
+	: m_buffer(std::move(o.m_buffer)), m_fences(std::move(o.m_fences)), m_mapped(o.m_mapped),
+	m_count_per_region(o.m_count_per_region), m_region_stride(o.m_region_stride),
+	m_num_regions(o.m_num_regions), m_curr_region(o.m_curr_region), m_stall_count(o.m_stall_count)
+{
+	o.m_fences.clear();
+	o.m_mapped = nullptr;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline StreamBuffer<T_value, T_buffer_type>& StreamBuffer<T_value, T_buffer_type>::operator=(StreamBuffer&& o)
+{
+	if (this == &o) return *this;
+	std::swap(m_buffer, o.m_buffer);
+	std::swap(m_fences, o.m_fences);
+	std::swap(m_mapped, o.m_mapped);
+	m_count_per_region = o.m_count_per_region;
+	m_region_stride = o.m_region_stride;
+	m_num_regions = o.m_num_regions;
+	m_curr_region = o.m_curr_region;
+	m_stall_count = o.m_stall_count;
+	return *this;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void StreamBuffer<T_value, T_buffer_type>::waitRegion(GLuint region)
+{
+	GLsync& fence = m_fences[region];
+	if (fence == nullptr) return;
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		++m_stall_count;
+		do	result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+		while (result == GL_TIMEOUT_EXPIRED);
+	}
+	ASSERT(result != GL_WAIT_FAILED, "StreamBuffer: waiting for the region's fence failed.");
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline T_value* StreamBuffer<T_value, T_buffer_type>::beginFrame()
+{
+	waitRegion(m_curr_region);
+	return reinterpret_cast<T_value*>(m_mapped + getOffset());
+}
+
+template<typename T_value, BufferType T_buffer_type>
+inline void StreamBuffer<T_value, T_buffer_type>::endFrame()
+{
+	ASSERT(m_fences[m_curr_region] == nullptr, "StreamBuffer: endFrame called twice on the same region, or without beginFrame.");
+	m_fences[m_curr_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_curr_region = (m_curr_region + 1) % m_num_regions;
+}
+
+template<typename T_value, BufferType T_buffer_type>
+template<typename Container>
+inline void StreamBuffer<T_value, T_buffer_type>::assign(const Container& container, size_t first)
+{
+	static_assert(std::is_same_v<std::decay_t<decltype(*container.data())>, T_value>, "StreamBuffer: container has a different value type.");
+	ASSERT(first + container.size() <= m_count_per_region, "StreamBuffer: container does not fit in a region.");
+	ASSERT(m_fences[m_curr_region] == nullptr, "StreamBuffer: the current region is still in use by the GPU. Call beginFrame first.");
+	std::memcpy(m_mapped + getOffset() + first * sizeof(T_value), container.data(), container.size() * sizeof(T_value));
+}
+
+template<typename T_value> using StreamArrayBuffer = StreamBuffer<T_value, BufferType::ARRAY_BUFFER>;
+template<typename T_value> using StreamUniformBuffer = StreamBuffer<T_value, BufferType::UNIFORM_BUFFER>;
+template<typename T_value> using StreamShaderStorageBuffer = StreamBuffer<T_value, BufferType::SHADER_STORAGE_BUFFER>;
+
+}} //namespace eltecg::ogl
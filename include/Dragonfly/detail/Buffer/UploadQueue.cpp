@@ -0,0 +1,93 @@
+#include "UploadQueue.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace eltecg::ogl;
+
+UploadQueue::UploadQueue(GLsizeiptr arena_size_per_frame, GLuint frames_in_flight)
+	: m_arena(static_cast<size_t>(arena_size_per_frame), frames_in_flight)
+{
+}
+
+void UploadQueue::enqueue(GLuint buffer, GLintptr offset, const void* data, GLsizeiptr size)
+{
+	if (size <= 0) return;
+	if (size > m_arena.getRegionSize()) {
+		// the earlier requests go first so that the last write wins, then a one-off staging buffer
+		// takes the data, glNamedBufferSubData would need DYNAMIC_STORAGE_BIT on the destination
+		issueCopies();
+		GLuint staging = 0;
+		glCreateBuffers(1, &staging);
+		glNamedBufferStorage(staging, size, data, 0);
+		glCopyNamedBufferSubData(staging, buffer, 0, offset, size);
+		glDeleteBuffers(1, &staging);	// freed once the copy is done
+		++m_current_stats.direct;
+		return;
+	}
+	if (m_region != nullptr && m_region_used + size > m_arena.getRegionSize()) {
+		// the region is full: its copies go now and the next region takes the rest of the frame
+		issueCopies();
+		m_arena.endFrame();
+		m_region = nullptr;
+		m_region_used = 0;
+		++m_current_stats.overflows;
+	}
+	if (m_region == nullptr) m_region = m_arena.beginFrame();
+	std::memcpy(m_region + m_region_used, data, size);
+	m_requests.push_back(Request{ buffer, offset, m_region_used, size });
+	m_region_used += size;
+	m_current_stats.bytes += size;
+	++m_current_stats.requests;
+}
+
+void UploadQueue::issueCopies()
+{
+	// Group by destination, keeping the submission order inside a group. A group is sorted by
+	// offset only if its ranges do not overlap, otherwise later writes have to stay later.
+	std::stable_sort(m_requests.begin(), m_requests.end(), [](const Request& a, const Request& b) { return a.buffer < b.buffer; });
+	auto by_offset = [](const Request& a, const Request& b) { return a.dst_offset < b.dst_offset; };
+	std::vector<Request> sorted;
+	for (auto group = m_requests.begin(); group != m_requests.end(); ) {
+		auto group_end = std::find_if(group, m_requests.end(), [&](const Request& r) { return r.buffer != group->buffer; });
+		sorted.assign(group, group_end);
+		std::sort(sorted.begin(), sorted.end(), by_offset);
+		bool overlap = false;
+		for (size_t i = 1; i < sorted.size() && !overlap; ++i)
+			overlap = sorted[i - 1].dst_offset + sorted[i - 1].size > sorted[i].dst_offset;
+		if (!overlap) std::copy(sorted.begin(), sorted.end(), group);
+		group = group_end;
+	}
+
+	// one copy per run that is contiguous both in the destination and in the arena
+	const GLintptr region_offset = m_arena.getOffset();
+	for (size_t i = 0; i < m_requests.size(); ) {
+		Request run = m_requests[i++];
+		for (; i < m_requests.size(); ++i) {
+			const Request& next = m_requests[i];
+			if (next.buffer != run.buffer || next.dst_offset != run.dst_offset + run.size || next.src_offset != run.src_offset + run.size) break;
+			run.size += next.size;
+		}
+		glCopyNamedBufferSubData(m_arena.getBuffer(), run.buffer, region_offset + run.src_offset, run.dst_offset, run.size);
+		++m_current_stats.copies;
+	}
+	m_requests.clear();
+}
+
+size_t UploadQueue::flush()
+{
+	issueCopies();
+	GL_CHECK;
+
+	if (m_region != nullptr) m_arena.endFrame();
+	m_region = nullptr;
+	m_region_used = 0;
+
+	m_last_stats = m_current_stats;
+	m_total_stats.bytes += m_current_stats.bytes;
+	m_total_stats.requests += m_current_stats.requests;
+	m_total_stats.copies += m_current_stats.copies;
+	m_total_stats.direct += m_current_stats.direct;
+	m_total_stats.overflows += m_current_stats.overflows;
+	m_current_stats = UploadStats();
+	return m_last_stats.copies;
+}
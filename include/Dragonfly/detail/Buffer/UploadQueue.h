@@ -0,0 +1,85 @@
+#pragma once
+#include "StreamBuffer.h"
+#include <vector>
+
+//namespace for opengl base classes
+namespace eltecg { namespace ogl {
+
+/****************************************************************************
+ *						Coalescing upload queue								*
+ ****************************************************************************/
+// Frame-scoped replacement for many small assignMutable calls. enqueue() copies the data into a
+// persistently mapped staging arena right away, flush() then sorts the requests by destination
+// and issues one glCopyNamedBufferSubData per run of adjacent ranges. The arena is split into
+// regions like a StreamBuffer, so a frame only waits for the GPU if it is 'frames_in_flight' behind.
+//	UploadQueue uploads(1 << 20);
+//	uploads.enqueue(vbo, moved_vertices, first * sizeof(Vertex));	// any number of times per frame
+//	uploads.enqueue(ubo, light_params);
+//	uploads.flush();	// sync point: before the draws that read these buffers
+// The destination buffers do not need DYNAMIC_STORAGE_BIT. If a frame fills its region, the copies so far
+// are issued and the next region is used, which may wait for the GPU (see UploadStats::overflows). A single
+// request larger than a region is copied from a temporary buffer of its own (see UploadStats::direct).
+class UploadQueue final
+{
+public:
+	struct UploadStats {
+		GLsizeiptr	bytes = 0;		// uploaded through the arena
+		size_t		requests = 0;	// enqueue calls that went through the arena
+		size_t		copies = 0;		// glCopyNamedBufferSubData calls issued
+		size_t		direct = 0;		// requests larger than a region, copied from a temporary buffer
+		size_t		overflows = 0;	// times a frame filled its region and went on in the next one
+		//Average number of requests served by one copy
+		float getMergeRatio() const { return copies == 0 ? 0.f : static_cast<float>(requests) / static_cast<float>(copies); }
+	};
+
+	UploadQueue(GLsizeiptr arena_size_per_frame = 4 << 20, GLuint frames_in_flight = 3);
+
+	UploadQueue(const UploadQueue&) = delete;
+	UploadQueue& operator=(const UploadQueue&) = delete;
+
+	//Schedules writing the container to the buffer at byte 'offset'.
+	template<BufferType T_buffer_type, typename Container>
+	void enqueue(Buffer<T_buffer_type>& buffer, const Container& container, GLintptr offset = 0);
+	//Raw version
+	void enqueue(GLuint buffer, GLintptr offset, const void* data, GLsizeiptr size);
+
+	//Issues the copies of this frame and fences the staging region. Returns the number of copies.
+	size_t flush();
+
+	inline size_t getPendingCount() const { return m_requests.size(); }
+	//Statistics of the last flush
+	inline const UploadStats& getLastStats() const { return m_last_stats; }
+	//Statistics summed over every flush so far
+	inline const UploadStats& getTotalStats() const { return m_total_stats; }
+	inline void resetTotalStats() { m_total_stats = UploadStats(); }
+
+protected:
+	struct Request {
+		GLuint		buffer;
+		GLintptr	dst_offset;
+		GLintptr	src_offset;	// inside the current region of the arena
+		GLsizeiptr	size;
+	};
+
+	//Issues the copies of the pending requests, the region stays in use
+	void issueCopies();
+
+	StreamBuffer<char, BufferType::COPY_READ_BUFFER> m_arena;
+	char*		m_region = nullptr;		// write pointer of the current region, nullptr before the first request of the frame
+	GLsizeiptr	m_region_used = 0;
+	std::vector<Request> m_requests;
+	UploadStats	m_current_stats;
+	UploadStats	m_last_stats;
+	UploadStats	m_total_stats;
+};
+
+template<BufferType T_buffer_type, typename Container>
+inline void UploadQueue::enqueue(Buffer<T_buffer_type>& buffer, const Container& container, GLintptr offset)
+{
+	using value_type = std::decay_t<decltype(*container.data())>;
+	const GLsizeiptr size = container.size() * sizeof(value_type);
+	ASSERT(offset + size <= buffer.getSize(), "UploadQueue: container to be uploaded is larger than the buffer.");
+	enqueue(buffer, offset, container.data(), size);
+}
+
+}} //namespace eltecg::ogl
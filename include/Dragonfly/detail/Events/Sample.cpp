@@ -2,12 +2,18 @@
 #include <GL/glew.h>
 #include "Sample.h"
 #include "../../detail/Framebuffer/FramebufferBase.h"
+#include "../../detail/vao.h"
+#include "../../detail/Program/ProgramCache.h"
+#include "../../detail/File/FileWatcher.h"
+#include <iostream>
 #include "renderdoc_load_api.h"
 
 df::Sample::Sample(const char* name_, int width_, int height_, FLAGS flags_)
 {
 	if(flags_ && FLAGS::INIT_RENDERDOC)
 		rdoc::initRenderDocAPI(false);
+	if(flags_ && FLAGS::HOT_RELOAD)
+		df::FileWatcher::Start();
 
 	auto err = SDL_Init(SDL_INIT_EVERYTHING);
 	ASSERT( err != -1, (std::string("Unable to initialize SDL: ") + SDL_GetError()).c_str());
@@ -79,6 +85,12 @@ df::Sample::~Sample()
 {
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplSDL2_Shutdown();
+	eltecg::ogl::VertexArray::releaseShared();
+	df::FileWatcher::Stop();
+#ifdef _DEBUG
+	if (df::ProgramCache::GetStats().hits + df::ProgramCache::GetStats().misses != 0)
+		std::cout << df::ProgramCache::GetStats().ToString();
+#endif // _DEBUG
 	if(_mainWindowContext)	SDL_GL_DeleteContext(_mainWindowContext);
 	if(_mainWindowPtr)		SDL_DestroyWindow(_mainWindowPtr);
 	SDL_Quit();
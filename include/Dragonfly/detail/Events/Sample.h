@@ -24,8 +24,8 @@ public:
 		V_SYNC				= 1 << 2,		V_SYNC_ADAPTIVE		= 1 << 3,
 		IMGUI_DOCKING		= 1 << 4,		IMGUI_VIEWPORTS		= 1 << 5,
 		WINDOW_RESIZABLE	= 1 << 6,		WINDOW_BORDERLESS	= 1 << 7,
-		WINDOW_FULLSCREEN	= 1 << 8,
-		DEFAULT				= V_SYNC_ADAPTIVE | IMGUI_DOCKING | IMGUI_VIEWPORTS | WINDOW_RESIZABLE | (df::IS_THIS_DEBUG ? RENDERDOC : NONE)
+		WINDOW_FULLSCREEN	= 1 << 8,		HOT_RELOAD			= 1 << 9,	// df::FileWatcher reloads saved shader files
+		DEFAULT				= V_SYNC_ADAPTIVE | IMGUI_DOCKING | IMGUI_VIEWPORTS | WINDOW_RESIZABLE | (df::IS_THIS_DEBUG ? RENDERDOC | HOT_RELOAD : NONE)
 	};
 
 protected:
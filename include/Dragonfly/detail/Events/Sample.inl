@@ -5,6 +5,8 @@
 #include <iostream>
 #include <functional>
 #include "../Traits/EventHandlerTraits.h"
+#include "../Buffer/ReadbackQueue.h"
+#include "../Program/ProgramBase.h"
 #include <ImGui/imgui.h>
 #include <ImGui-addons/impl/imgui_impl_sdl.h>
 #include <ImGui-addons/impl/imgui_impl_opengl3.h>
@@ -116,6 +118,9 @@ inline void Sample::Run(F&& RenderFunc_)
 	_CallResizeHandlers(_resize, canvas_width, canvas_height);
 	while (!_quit)
 	{
+		eltecg::ogl::ReadbackQueue::pollAll(); // resolve the readbacks the GPU has finished since the last frame
+		df::FileWatcher::Dispatch(); // reload the shader files saved since the last frame, relinks with LinkAsync
+		df::ProgramLowLevelBase::PollAsyncLinks(); // swap in the programs the driver has linked since the last frame
 		while (SDL_PollEvent(&ev))
 		{
 			ImGui_ImplSDL2_ProcessEvent(&ev);
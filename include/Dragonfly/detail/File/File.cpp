@@ -12,8 +12,13 @@ SFile::SFile(const std::string &path_){
 	Load();
 }
 
+SFile SFile::FromSource(const std::string &name, const std::string &code_, int version_number_){
+	return SFile(name, code_, version_number_);
+}
+
 void SFile::SetLocation(const std::string &path_){
 	path = path_;
+	watch = FileWatcher::Handle(path);
 	for (auto &p : std::filesystem::path(path))	{
 		folder = filename;
 		filename = p.generic_string();
@@ -25,6 +30,7 @@ void SFile::SetLocation(const std::string &path_){
 }
 
 bool SFile::Load(){
+	if (generated) return true;
 	std::ifstream file(path);
 	code.clear();
 	if(!file.is_open())	{
@@ -37,20 +43,27 @@ bool SFile::Load(){
 	{
 		version_number= std::stoi(line.substr(9, 4));
 		ASSERT(100 <= version_number && version_number <= 460, ("Invalid GLSL version specified in " + path + ".").c_str());
+		first_line = 2;
 	}
 	else
 	{
 		code += line + '\n';
+		first_line = 1;
 	}
 	while (getline(file, line))
 	{
 		code += line + '\n';
 	}
 	file.close();	error_msg.clear();
+	dirty = false;
 	return true;
 }
 
 bool SFile::Save() const{
+	if (generated) {
+		error_msg += "Generated code cannot be saved : " + path + '\n';
+		return false;
+	}
 	std::ofstream out(path, std::ofstream::binary || std::ofstream::trunc);
 	if(!out.is_open())	{
 		error_msg += "Could not open file : " + path + '\n';
@@ -63,11 +76,14 @@ bool SFile::Save() const{
 	}
 	out.write(code.c_str(), code.length());
 	out.close();	error_msg.clear();
+	dirty = false;
 	return true;
 }
 
 void SFile::Assign(const std::string & code_){
 	code = code_; dirty = true;
 	path = folder = filename = extension = error_msg = "";
+	watch.Reset();
 	folder_depth_level = 0;
+	first_line = 1;
 }
\ No newline at end of file
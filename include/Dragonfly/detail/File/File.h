@@ -3,6 +3,7 @@
 #include <vector>
 #include <GL/glew.h>
 #include "../../config.h"
+#include "FileWatcher.h"
 
 //	1. Choose a file loader:		[DONE]
 //		SFile,						Storage and interface between a file and memory copy
@@ -22,14 +23,19 @@ namespace df
 class SFile {
 private:
 	void SetLocation(const std::string &path_);
+	SFile(const std::string &name, const std::string &code_, int version_number_)
+		: path(name), filename(name), code(code_), version_number(version_number_), generated(true) {}
 protected:
 	std::string path;
 	std::string folder, filename, extension;
 	std::string code;
 	int version_number = 130; // default version number (130)
+	int first_line = 1;		// line of the file 'code' starts at, 2 if Load dropped the #version line
 	int folder_depth_level = 0;
 	mutable std::string error_msg;
 	mutable bool dirty = false;
+	bool generated = false;	// made by FromSource, there is no file behind it
+	FileWatcher::Handle watch;	// the path is watched for hot reload while the file lives
 	SFile() = delete;
 	SFile(SFile &) = delete;
 	SFile& operator=(const SFile&) = delete;
@@ -38,6 +44,8 @@ public:
 	SFile& operator=(SFile&&) = default;
 	//Create and Load shader file assosiated with path_
 	SFile(const std::string &path_);
+	//Create from code in memory (eg. a shader generated by the framework), 'name' only shows up in the error messages
+	static SFile FromSource(const std::string &name, const std::string &code_, int version_number_ = 430);
 
 	//Reload or Save file
 	bool Load();
@@ -57,8 +65,12 @@ public:
 	inline const std::string& GetCode() const { return code; }
 	inline const std::string& GetErrors() const { return error_msg; }
 	inline const int GetVersionNumber() const { return version_number; }
+	// Line of the file the first line of the code is, the #version line is not part of the code
+	inline int GetFirstLine() const { return first_line; }
 	// True if content of file differs from code in memory
 	inline bool isDirty() const { return dirty; }
+	// True if the code was generated in memory, Load keeps it and Save fails
+	inline bool IsGenerated() const { return generated; }
 
 	//This class doesn't implement these features:
 	void Render(std::string name = "") {} void Update() {} void Open() {} void Close() {} void ViewFile(){}
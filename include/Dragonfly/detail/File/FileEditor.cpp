@@ -20,6 +20,12 @@ void FileEditor::CreateEditor() const{
 	}
 }
 
+bool FileEditor::Load() {
+	const bool loaded = SFile::Load();
+	if (editor) editor->SetText(code);
+	return loaded;
+}
+
 void FileEditor::SetErrorMarkers(const TextEditor::ErrorMarkers & errm) {
 	//CreateEditor();
 	error_markers = errm;
@@ -38,7 +44,7 @@ void FileEditor::Render()
 			ImVec2 region = ImGui::GetContentRegionAvail();
 			if (ImGui::Button("Save", { region.x*0.49f, 16.f + region.y*0.05f })) Save();
 			ImGui::SameLine();
-			if (ImGui::Button("Load", { region.x*0.49f, 16.f + region.y*0.05f })) { Load(); editor->SetText(code); }
+			if (ImGui::Button("Load", { region.x*0.49f, 16.f + region.y*0.05f })) Load();
 			if (!error_msg.empty()) {
 				ImGui::PushStyleColor(ImGuiCol_Text, { 1,0.5f,0.5f,1 });
 				ImGui::TextUnformatted(error_msg.c_str(), error_msg.c_str() + error_msg.length());
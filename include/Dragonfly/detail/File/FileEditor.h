@@ -11,6 +11,7 @@ public:
 		enum class Type { UNKNOWN = 0, ERROR = 1, WARNING = 2 };
 		Type type = Type::UNKNOWN;
 		int line=-1, col = -1, e_code = 0;
+		int source = -1;	// GLSL source string number, see Shader::GetSourceFiles
 		std::string path, message;
 	};
 private:
@@ -31,8 +32,13 @@ public:
 	FileEditor& operator=(FileEditor&&) = default;
 	//Create and Load shader file assosiated with path_
 	FileEditor(const std::string &path_) : SFile(path_), editor(nullptr) {}
+	//Wrap an already loaded (or generated) file
+	FileEditor(SFile &&file) : SFile(std::move(file)), editor(nullptr) {}
 	~FileEditor() {}
 
+	// Reloads the file and the text of the editor (the hot reload calls it too)
+	bool Load();
+
 	// Set Error Markers: TODO: make it pretty(er)
 	void SetErrorMarkers(const TextEditor::ErrorMarkers &errm);
 
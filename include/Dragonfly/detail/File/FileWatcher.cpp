@@ -0,0 +1,404 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace df;
+
+namespace {
+
+struct FileEvent
+{
+	std::string directory, filename;
+};
+
+// The OS watches directories, not files: editors often save by renaming a temporary file over the original,
+// a watch on the file itself would be lost. Only the watcher thread calls Sync and Wait, Wake is thread safe.
+class DirectoryMonitor
+{
+public:
+	bool Open();
+	void Close();
+	//Makes a blocking Wait return
+	void Wake();
+	//Watches exactly 'directories'
+	void Sync(const std::vector<std::string>& directories);
+	//Blocks until there are events, Wake is called or 'timeout_ms' passed (-1: no timeout)
+	void Wait(int timeout_ms, std::vector<FileEvent>& events);
+
+private:
+#ifdef _WIN32
+	struct Directory
+	{
+		std::string name;
+		HANDLE handle = INVALID_HANDLE_VALUE;
+		OVERLAPPED overlapped = {};
+		alignas(DWORD) char buffer[16 * 1024];
+	};
+	static bool issueRead(Directory& directory);
+	static void closeDirectory(Directory& directory);
+	HANDLE _wake = nullptr;
+	std::map<std::string, std::unique_ptr<Directory>> _directories;	// the OVERLAPPED must not move
+#else
+	int _inotify = -1, _wake = -1;
+	std::map<std::string, int> _watches;	// directory -> watch descriptor
+#endif
+};
+
+#ifdef _WIN32
+
+bool DirectoryMonitor::Open()
+{
+	_wake = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+	return _wake != nullptr;
+}
+
+void DirectoryMonitor::Close()
+{
+	for (auto& directory : _directories) closeDirectory(*directory.second);
+	_directories.clear();
+	if (_wake) CloseHandle(_wake);
+	_wake = nullptr;
+}
+
+void DirectoryMonitor::Wake()
+{
+	if (_wake) SetEvent(_wake);
+}
+
+bool DirectoryMonitor::issueRead(Directory& directory)
+{
+	return ReadDirectoryChangesW(directory.handle, directory.buffer, sizeof(directory.buffer), FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &directory.overlapped, nullptr) != FALSE;
+}
+
+void DirectoryMonitor::closeDirectory(Directory& directory)
+{
+	DWORD bytes = 0;
+	CancelIoEx(directory.handle, &directory.overlapped);
+	GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, TRUE);	// the buffer is written until the read is cancelled
+	CloseHandle(directory.handle);
+	CloseHandle(directory.overlapped.hEvent);
+}
+
+void DirectoryMonitor::Sync(const std::vector<std::string>& directories)
+{
+	for (auto it = _directories.begin(); it != _directories.end();) {
+		if (std::find(directories.begin(), directories.end(), it->first) != directories.end()) { ++it; continue; }
+		closeDirectory(*it->second);
+		it = _directories.erase(it);
+	}
+	for (const std::string& name : directories) {
+		if (_directories.count(name)) continue;
+		auto directory = std::make_unique<Directory>();
+		directory->name = name;
+		directory->handle = CreateFileW(std::filesystem::path(name).c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (directory->handle == INVALID_HANDLE_VALUE) continue;	// retried on the next Sync
+		directory->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		if (!directory->overlapped.hEvent || !issueRead(*directory)) {
+			if (directory->overlapped.hEvent) CloseHandle(directory->overlapped.hEvent);
+			CloseHandle(directory->handle);
+			continue;
+		}
+		_directories[name] = std::move(directory);
+	}
+}
+
+void DirectoryMonitor::Wait(int timeout_ms, std::vector<FileEvent>& events)
+{
+	std::vector<HANDLE> handles = { _wake };
+	std::vector<Directory*> directories;
+	for (auto& directory : _directories) {
+		if (handles.size() == MAXIMUM_WAIT_OBJECTS) break;
+		handles.push_back(directory.second->overlapped.hEvent);
+		directories.push_back(directory.second.get());
+	}
+	const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, timeout_ms < 0 ? INFINITE : static_cast<DWORD>(timeout_ms));
+	if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + handles.size()) return;
+	Directory& directory = *directories[result - WAIT_OBJECT_0 - 1];
+	DWORD bytes = 0;
+	if (GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, FALSE) && bytes != 0) {	// 0 bytes: the buffer overflowed
+		for (const char* entry = directory.buffer;;) {
+			const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(entry);
+			if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+				events.push_back({ directory.name, std::filesystem::path(std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR))).generic_string() });
+			if (info->NextEntryOffset == 0) break;
+			entry += info->NextEntryOffset;
+		}
+	}
+	issueRead(directory);
+}
+
+#else
+
+bool DirectoryMonitor::Open()
+{
+	_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_inotify >= 0 && _wake >= 0) return true;
+	Close();
+	return false;
+}
+
+void DirectoryMonitor::Close()
+{
+	if (_inotify >= 0) close(_inotify);	// removes the watches too
+	if (_wake >= 0) close(_wake);
+	_inotify = _wake = -1;
+	_watches.clear();
+}
+
+void DirectoryMonitor::Wake()
+{
+	const uint64_t one = 1;
+	if (_wake >= 0 && write(_wake, &one, sizeof(one)) < 0) {}	// only fails if the counter is already set
+}
+
+void DirectoryMonitor::Sync(const std::vector<std::string>& directories)
+{
+	for (auto it = _watches.begin(); it != _watches.end();) {
+		if (std::find(directories.begin(), directories.end(), it->first) != directories.end()) { ++it; continue; }
+		inotify_rm_watch(_inotify, it->second);
+		it = _watches.erase(it);
+	}
+	for (const std::string& directory : directories) {
+		if (_watches.count(directory)) continue;
+		const int watch = inotify_add_watch(_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO);
+		if (watch >= 0) _watches[directory] = watch;	// retried on the next Sync otherwise
+	}
+}
+
+void DirectoryMonitor::Wait(int timeout_ms, std::vector<FileEvent>& events)
+{
+	pollfd fds[2] = { { _inotify, POLLIN, 0 }, { _wake, POLLIN, 0 } };
+	if (::poll(fds, 2, timeout_ms) <= 0) return;
+	if (fds[1].revents & POLLIN) {
+		uint64_t count;
+		if (read(_wake, &count, sizeof(count)) < 0) {}
+	}
+	if (!(fds[0].revents & POLLIN)) return;
+	alignas(inotify_event) char buffer[16 * 1024];
+	ssize_t length;
+	while ((length = read(_inotify, buffer, sizeof(buffer))) > 0) {
+		for (const char* entry = buffer; entry < buffer + length;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(entry);
+			entry += sizeof(inotify_event) + event->len;
+			if (event->len == 0) continue;	// about the directory itself
+			for (const auto& watch : _watches)
+				if (watch.second == event->wd) { events.push_back({ watch.first, event->name }); break; }
+		}
+	}
+}
+
+#endif
+
+struct WatcherState
+{
+	std::mutex mutex;
+	std::map<std::string, std::map<std::string, int>> directories;	// normalized directory -> file name -> handle count
+	bool directories_changed = false;	// the thread syncs the monitor before its next wait
+	std::vector<std::string> changed;	// collected by the thread, handed out by Dispatch
+	std::atomic<bool> has_changes{ false };
+	std::atomic<bool> stop{ false };
+	std::thread thread;
+	DirectoryMonitor monitor;
+	int debounce_ms = 100;
+	std::map<const void*, std::pair<int, FileWatcher::Callback>> subscribers;	// priority and callback, main thread only
+};
+
+//Never destroyed: SFiles with static storage may release their handles after it would be
+WatcherState& s_state() { static WatcherState* state = new WatcherState; return *state; }
+
+void splitPath(const std::string& path, std::string& directory, std::string& filename)
+{
+	const std::filesystem::path p(path);
+	directory = p.parent_path().generic_string();
+	filename = p.filename().generic_string();
+}
+
+void watchLoop(WatcherState& state)
+{
+	using Clock = std::chrono::steady_clock;
+	std::vector<FileEvent> events;
+	std::vector<std::string> pending;
+	Clock::time_point deadline;
+	while (!state.stop) {
+		std::vector<std::string> directories;
+		bool sync = false;
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			if ((sync = state.directories_changed)) {
+				for (const auto& directory : state.directories) directories.push_back(directory.first);
+				state.directories_changed = false;
+			}
+		}
+		if (sync) state.monitor.Sync(directories);
+
+		int timeout_ms = -1;	// nothing pending: sleep until the OS has something
+		if (!pending.empty())
+			timeout_ms = static_cast<int>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count()));
+		events.clear();
+		state.monitor.Wait(timeout_ms, events);
+
+		std::lock_guard<std::mutex> lock(state.mutex);
+		for (const FileEvent& event : events) {
+			auto directory = state.directories.find(event.directory);
+			if (directory == state.directories.end() || !directory->second.count(event.filename)) continue;
+			pending.push_back((std::filesystem::path(event.directory) / event.filename).generic_string());
+			deadline = Clock::now() + std::chrono::milliseconds(state.debounce_ms);
+		}
+		if (!pending.empty() && Clock::now() >= deadline) {
+			state.changed.insert(state.changed.end(), pending.begin(), pending.end());
+			state.has_changes.store(true, std::memory_order_release);
+			pending.clear();
+		}
+	}
+}
+
+} //namespace
+
+FileWatcher::Handle::Handle(const std::string& path)
+	: _path(Normalize(path))
+{
+	if (_path.empty()) return;
+	std::string directory, filename;
+	splitPath(_path, directory, filename);
+	WatcherState& state = s_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	auto& files = state.directories[directory];
+	if (files.empty()) {
+		state.directories_changed = true;
+		if (state.thread.joinable()) state.monitor.Wake();
+	}
+	++files[filename];
+}
+
+FileWatcher::Handle& FileWatcher::Handle::operator=(Handle&& other) noexcept
+{
+	if (&other == this) return *this;
+	Reset();
+	_path = std::move(other._path);
+	other._path.clear();
+	return *this;
+}
+
+void FileWatcher::Handle::Reset()
+{
+	if (_path.empty()) return;
+	std::string directory, filename;
+	splitPath(_path, directory, filename);
+	_path.clear();
+	WatcherState& state = s_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	auto dir = state.directories.find(directory);
+	if (dir == state.directories.end()) return;
+	auto file = dir->second.find(filename);
+	if (file != dir->second.end() && --file->second == 0) dir->second.erase(file);
+	if (dir->second.empty()) {
+		state.directories.erase(dir);
+		state.directories_changed = true;
+		if (state.thread.joinable()) state.monitor.Wake();
+	}
+}
+
+bool FileWatcher::Start(int debounce_ms)
+{
+	WatcherState& state = s_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	if (state.thread.joinable()) return true;
+	if (!state.monitor.Open()) {
+		WARNING(true, "FileWatcher: could not start watching files, shaders are not reloaded automatically.");
+		return false;
+	}
+	state.debounce_ms = debounce_ms;
+	state.directories_changed = true;
+	state.stop = false;
+	state.thread = std::thread(watchLoop, std::ref(state));
+	return true;
+}
+
+void FileWatcher::Stop()
+{
+	WatcherState& state = s_state();
+	if (!IsRunning()) return;
+	state.stop = true;
+	state.monitor.Wake();
+	state.thread.join();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	state.monitor.Close();
+}
+
+bool FileWatcher::IsRunning()
+{
+	WatcherState& state = s_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	return state.thread.joinable();
+}
+
+void FileWatcher::Subscribe(const void* owner, Callback&& callback, int priority)
+{
+	s_state().subscribers[owner] = { priority, std::move(callback) };
+}
+
+void FileWatcher::Unsubscribe(const void* owner)
+{
+	s_state().subscribers.erase(owner);
+}
+
+void FileWatcher::Dispatch()
+{
+	WatcherState& state = s_state();
+	if (!state.has_changes.load(std::memory_order_acquire)) return;
+	std::vector<std::string> changed;
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		changed.swap(state.changed);
+		state.has_changes = false;
+	}
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+#ifdef _DEBUG
+	for (const std::string& path : changed) std::cout << "FileWatcher: " << path << " changed.\n";
+#endif // _DEBUG
+	// a callback may (un)subscribe, eg. by destroying a program
+	std::vector<std::pair<int, const void*>> owners;
+	for (const auto& subscriber : state.subscribers) owners.emplace_back(subscriber.second.first, subscriber.first);
+	std::stable_sort(owners.begin(), owners.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+	for (const auto& owner : owners) {
+		auto subscriber = state.subscribers.find(owner.second);
+		if (subscriber == state.subscribers.end()) continue;
+		Callback callback = subscriber->second.second;
+		callback(changed);
+	}
+}
+
+std::string FileWatcher::Normalize(const std::string& path)
+{
+	if (path.empty()) return path;
+	std::error_code error;
+	const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+	return (error ? std::filesystem::path(path) : absolute).lexically_normal().generic_string();
+}
+
+bool FileWatcher::Contains(const std::vector<std::string>& changed, const std::string& path)
+{
+	return !path.empty() && std::binary_search(changed.begin(), changed.end(), Normalize(path));
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "../../config.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace df
+{
+
+/****************************************************************************
+ *						Shader hot reload									*
+ ****************************************************************************/
+// Every SFile that was loaded from a path is watched. A background thread waits on the OS (inotify on Linux,
+// ReadDirectoryChangesW on Windows) for writes to the watched files, it is asleep while nothing changes.
+// A burst of events (an editor writing a temp file, renaming it, touching it again) is collected until
+// the files are quiet for 'debounce_ms', then the batch is handed to the main thread.
+//	df::FileWatcher::Start();			// df::Sample does it with FLAGS::HOT_RELOAD (on in debug builds)
+//	program << "a.vert"_vert << "a.frag"_frag << df::LinkProgram;
+//	... save a.frag in an editor: the next frame reloads it, recompiles only the fragment shader and relinks with LinkAsync
+// df::Sample::Run calls Dispatch at the beginning of each frame, that is a single atomic load if nothing changed.
+// Files with unsaved edits in memory (isDirty) are not reloaded.
+
+class FileWatcher
+{
+public:
+	FileWatcher() = delete;
+	using Callback = std::function<void(const std::vector<std::string>&)>;
+
+	//Keeps a path watched while it lives, SFile holds one
+	class Handle
+	{
+	public:
+		Handle() = default;
+		explicit Handle(const std::string& path);
+		Handle(Handle&& other) noexcept : _path(std::move(other._path)) { other._path.clear(); }
+		Handle& operator=(Handle&& other) noexcept;
+		~Handle() { Reset(); }
+		void Reset();
+	private:
+		Handle(const Handle&) = delete;
+		Handle& operator=(const Handle&) = delete;
+		std::string _path;	// normalized, empty: nothing is watched
+	};
+
+	//Starts the watcher thread, paths registered before are watched too
+	static bool Start(int debounce_ms = 100);
+	static void Stop();
+	static bool IsRunning();
+
+	//'callback' gets the sorted, normalized paths of the changed files, called from Dispatch on the main thread.
+	//Lower priorities are called first (eg. caches that have to be invalidated before the programs reload).
+	static void Subscribe(const void* owner, Callback&& callback, int priority = 0);
+	static void Unsubscribe(const void* owner);
+	//Hands the changes the thread has collected since the last call to the subscribers
+	static void Dispatch();
+
+	//Absolute, lexically normal path with forward slashes, what the callbacks get
+	static std::string Normalize(const std::string& path);
+	//True if 'changed' (from a callback) holds 'path'
+	static bool Contains(const std::vector<std::string>& changed, const std::string& path);
+};
+
+} //namespace df
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace df
+{
+
+// 64 bit non-cryptographic hash for cache keys and change detection (8 bytes per step, then an avalanche).
+// Stable across runs and platforms of the same endianness, so it can be stored in files.
+//	uint64_t key = df::hashBytes(code.data(), code.size());
+//	key = df::hashString(defines, key);	// chaining: the previous hash is the seed
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0)
+{
+	constexpr uint64_t k1 = 0x9E3779B185EBCA87ull, k2 = 0xC2B2AE3D27D4EB4Full;
+	auto mix = [](uint64_t h) { h ^= h >> 33; h *= 0xFF51AFD7ED558CCDull; h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ull; return h ^ (h >> 33); };
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	uint64_t h = seed ^ (size * k1);
+	for (; size >= 8; size -= 8, p += 8) {
+		uint64_t word;
+		std::memcpy(&word, p, 8);
+		h ^= (word * k2 << 31 | word * k2 >> 33) * k1;
+		h = (h << 27 | h >> 37) * k1 + 0x52DCE729;
+	}
+	uint64_t tail = 0;
+	if (size > 0) std::memcpy(&tail, p, size);	// p may be null for empty input
+	h ^= tail * k2;
+	return mix(h);
+}
+
+inline uint64_t hashString(const std::string& str, uint64_t seed = 0) { return hashBytes(str.data(), str.size(), seed); }
+
+} //namespace df
@@ -0,0 +1,105 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace df;
+
+MappedFile& MappedFile::operator=(MappedFile &&other) noexcept {
+	if (this == &other) return *this;
+	Close();
+	path = std::move(other.path);
+	error_msg = std::move(other.error_msg);
+	data = std::exchange(other.data, nullptr);
+	size = std::exchange(other.size, 0);
+	is_open = std::exchange(other.is_open, false);
+#ifdef _WIN32
+	file_handle = std::exchange(other.file_handle, nullptr);
+	mapping_handle = std::exchange(other.mapping_handle, nullptr);
+#endif
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &path_){
+	Close();
+	path = path_;
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		error_msg = "Could not open file : " + path + '\n';
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file, &file_size);
+	file_handle = file;
+	size = static_cast<size_t>(file_size.QuadPart);
+	is_open = true;
+	if (size == 0) return true;	// an empty file cannot be mapped
+
+	mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle != nullptr)
+		data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr) {
+		Close();
+		error_msg = "Could not map file : " + path + '\n';
+		return false;
+	}
+	error_msg.clear();
+	return true;
+}
+
+void MappedFile::Close(){
+	if (data != nullptr) UnmapViewOfFile(data);
+	if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+	if (file_handle != nullptr) CloseHandle(file_handle);
+	data = nullptr;	mapping_handle = file_handle = nullptr;
+	size = 0;	is_open = false;
+}
+
+#else //POSIX
+
+bool MappedFile::Open(const std::string &path_){
+	Close();
+	path = path_;
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0) {
+		if (fd >= 0) ::close(fd);
+		error_msg = "Could not open file : " + path + '\n';
+		return false;
+	}
+	size = static_cast<size_t>(info.st_size);
+	is_open = true;
+	if (size > 0) {
+		void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED) {
+			::close(fd);
+			Close();
+			error_msg = "Could not map file : " + path + '\n';
+			return false;
+		}
+		madvise(mapping, size, MADV_SEQUENTIAL);
+		data = static_cast<const char*>(mapping);
+	}
+	::close(fd);	// the mapping keeps the file alive
+	error_msg.clear();
+	return true;
+}
+
+void MappedFile::Close(){
+	if (data != nullptr) munmap(const_cast<char*>(data), size);
+	data = nullptr;
+	size = 0;	is_open = false;
+}
+
+#endif
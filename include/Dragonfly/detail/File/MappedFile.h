@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <utility>
+#include "../../config.h"
+
+namespace df
+{
+
+// Read-only memory mapping of a whole file. The pages are loaded on demand by the OS, so parsing or
+// uploading straight from GetData() never copies the file into a buffer of its own.
+//	df::MappedFile file("bunny.obj");
+//	if (file.IsOpen()) parse(file.GetData(), file.GetData() + file.GetSize());
+class MappedFile {
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string &path_) { Open(path_); }
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+	MappedFile& operator=(MappedFile &&other) noexcept;
+
+	//Maps the file, closing the previous one. Empty files open fine with a null pointer.
+	bool Open(const std::string &path_);
+	void Close();
+
+	inline const char* GetData() const { return data; }
+	inline size_t GetSize() const { return size; }
+	inline bool IsOpen() const { return is_open; }
+	inline const std::string& GetPath() const { return path; }
+	inline const std::string& GetErrors() const { return error_msg; }
+
+private:
+	std::string path;
+	std::string error_msg;
+	const char *data = nullptr;
+	size_t size = 0;
+	bool is_open = false;
+#ifdef _WIN32
+	void *file_handle = nullptr;
+	void *mapping_handle = nullptr;
+#endif
+};
+
+} //namespace df
@@ -0,0 +1,367 @@
+#include "IndexOptimizer.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace df;
+
+namespace {
+
+//Triangles around each vertex: triangles[offsets[v] .. offsets[v+1])
+struct Adjacency
+{
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> triangles;
+
+	Adjacency(const uint32_t* indices, size_t index_count, size_t vertex_count) : offsets(vertex_count + 1, 0), triangles(index_count)
+	{
+		for (size_t i = 0; i < index_count; ++i) ++offsets[indices[i] + 1];
+		for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] += offsets[v];
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < index_count; ++i) triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+	uint32_t count(uint32_t v) const { return offsets[v + 1] - offsets[v]; }
+};
+
+//FIFO post-transform cache with timestamps: a vertex is cached if it was loaded during the last 'size' misses
+struct CacheSimulator
+{
+	std::vector<uint32_t> loaded;
+	uint32_t now;
+	const unsigned size;
+
+	CacheSimulator(size_t vertex_count, unsigned cache_size) : loaded(vertex_count, 0), now(cache_size + 1), size(cache_size) {}
+	unsigned vertex(uint32_t v) {
+		if (now - loaded[v] <= size) return 0;
+		loaded[v] = now++;
+		return 1;
+	}
+	unsigned triangle(const uint32_t* t) { return vertex(t[0]) + vertex(t[1]) + vertex(t[2]); }
+	void flush() { now += size + 1; }
+};
+
+void tipsify(uint32_t* dst, const uint32_t* indices, size_t index_count, size_t vertex_count, unsigned cache_size)
+{
+	const Adjacency adjacency(indices, index_count, vertex_count);
+	std::vector<uint32_t> live(vertex_count);
+	for (uint32_t v = 0; v < vertex_count; ++v) live[v] = adjacency.count(v);
+	std::vector<uint32_t> cache_time(vertex_count, 0);
+	std::vector<bool> emitted(index_count / 3, false);
+	std::vector<uint32_t> dead_end, candidates;
+	dead_end.reserve(index_count);
+	uint32_t timestamp = cache_size + 1;
+	uint32_t cursor = 0;
+	size_t written = 0;
+
+	// a vertex with remaining triangles from the dead-end stack, or the next one in input order
+	auto skipDeadEnd = [&]() -> uint32_t {
+		while (!dead_end.empty()) {
+			const uint32_t v = dead_end.back();
+			dead_end.pop_back();
+			if (live[v] > 0) return v;
+		}
+		for (; cursor < vertex_count; ++cursor)
+			if (live[cursor] > 0) return cursor;
+		return ~0u;
+	};
+
+	for (uint32_t fan = skipDeadEnd(); fan != ~0u; )
+	{
+		candidates.clear();
+		for (uint32_t i = adjacency.offsets[fan]; i < adjacency.offsets[fan + 1]; ++i)
+		{
+			const uint32_t t = adjacency.triangles[i];
+			if (emitted[t]) continue;
+			for (int k = 0; k < 3; ++k)
+			{
+				const uint32_t v = indices[3 * t + k];
+				dst[written++] = v;
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (timestamp - cache_time[v] > cache_size) cache_time[v] = timestamp++;
+			}
+			emitted[t] = true;
+		}
+		// the candidate that stays in the cache while its remaining triangles are emitted, and got there first
+		uint32_t best = ~0u;
+		int64_t best_priority = -1;
+		for (uint32_t v : candidates)
+		{
+			if (live[v] == 0) continue;
+			int64_t priority = 0;
+			const int64_t age = static_cast<int64_t>(timestamp - cache_time[v]);
+			if (age + 2 * static_cast<int64_t>(live[v]) <= cache_size) priority = age;
+			if (priority > best_priority) { best_priority = priority; best = v; }
+		}
+		fan = best != ~0u ? best : skipDeadEnd();
+	}
+}
+
+const float* positionOf(const float* positions, size_t stride, uint32_t v)
+{
+	return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+}
+
+void sortClusters(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t stride,
+	unsigned cache_size, float threshold, size_t vertex_count)
+{
+	const size_t triangle_count = index_count / 3;
+	CacheSimulator cache(vertex_count, cache_size);
+
+	// hard boundaries: the vertex cache order restarts where a triangle misses all three vertices
+	std::vector<uint32_t> hard;
+	for (size_t t = 0; t < triangle_count; ++t)
+		if (cache.triangle(indices + 3 * t) == 3 || t == 0) hard.push_back(static_cast<uint32_t>(t));
+	hard.push_back(static_cast<uint32_t>(triangle_count));
+
+	// soft boundaries: split the hard clusters further while the ACMR stays within 'threshold' of the cluster's
+	std::vector<uint32_t> clusters;
+	for (size_t h = 0; h + 1 < hard.size(); ++h)
+	{
+		const uint32_t begin = hard[h], end = hard[h + 1];
+		cache.flush();
+		unsigned misses = 0;
+		for (uint32_t t = begin; t < end; ++t) misses += cache.triangle(indices + 3 * t);
+		const float target = threshold * static_cast<float>(misses) / static_cast<float>(end - begin);
+
+		cache.flush();
+		const size_t first_cluster = clusters.size();
+		clusters.push_back(begin);
+		unsigned running_misses = 0, running_triangles = 0;
+		for (uint32_t t = begin; t < end; ++t)
+		{
+			running_misses += cache.triangle(indices + 3 * t);
+			++running_triangles;
+			if (static_cast<float>(running_misses) <= target * static_cast<float>(running_triangles) && t + 1 < end)
+			{
+				clusters.push_back(t + 1);
+				cache.flush();
+				running_misses = running_triangles = 0;
+			}
+		}
+		// the tail after the last split rarely reaches the target, merge it into the previous cluster
+		if (running_triangles > 0 && clusters.size() > first_cluster + 1) clusters.pop_back();
+	}
+	clusters.push_back(static_cast<uint32_t>(triangle_count));
+
+	// sort clusters outside-in: by the distance of their plane from the mesh center along their normal
+	const size_t cluster_count = clusters.size() - 1;
+	std::vector<float> cluster_data(cluster_count * 6, 0.0f);	// area weighted centroid sum (3), normal sum (3)
+	float mesh_center[3] = { 0, 0, 0 }, mesh_area = 0;
+	for (size_t c = 0; c < cluster_count; ++c)
+	{
+		float* data = &cluster_data[6 * c];
+		float area_sum = 0;
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			const float* a = positionOf(positions, stride, indices[3 * t + 0]);
+			const float* b = positionOf(positions, stride, indices[3 * t + 1]);
+			const float* p = positionOf(positions, stride, indices[3 * t + 2]);
+			const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+			const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (int k = 0; k < 3; ++k) {
+				data[k] += area * (a[k] + b[k] + p[k]) / 3.0f;
+				data[3 + k] += n[k];
+				mesh_center[k] += area * (a[k] + b[k] + p[k]) / 3.0f;
+			}
+			area_sum += area;
+		}
+		mesh_area += area_sum;
+		if (area_sum > 0) for (int k = 0; k < 3; ++k) data[k] /= area_sum;
+	}
+	if (mesh_area > 0) for (int k = 0; k < 3; ++k) mesh_center[k] /= mesh_area;
+
+	std::vector<float> keys(cluster_count);
+	for (size_t c = 0; c < cluster_count; ++c)
+	{
+		const float* data = &cluster_data[6 * c];
+		const float length = std::sqrt(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+		float dot = 0;
+		for (int k = 0; k < 3; ++k) dot += (data[k] - mesh_center[k]) * data[3 + k];
+		keys[c] = length > 0 ? dot / length : 0.0f;
+	}
+	std::vector<uint32_t> order(cluster_count);
+	for (uint32_t c = 0; c < cluster_count; ++c) order[c] = c;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+	size_t written = 0;
+	for (uint32_t c : order)
+	{
+		const size_t count = 3 * static_cast<size_t>(clusters[c + 1] - clusters[c]);
+		std::memcpy(dst + written, indices + 3 * static_cast<size_t>(clusters[c]), count * sizeof(uint32_t));
+		written += count;
+	}
+}
+
+//Reorders the triangles along a Morton curve of their centroids
+void sortTrianglesSpatially(uint32_t* indices, size_t index_count, const float* positions, size_t stride, unsigned threads)
+{
+	const size_t triangle_count = index_count / 3;
+	float lo[3] = { INFINITY, INFINITY, INFINITY }, hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (size_t i = 0; i < index_count; ++i)
+	{
+		const float* p = positionOf(positions, stride, indices[i]);
+		for (int k = 0; k < 3; ++k) { lo[k] = std::min(lo[k], p[k]); hi[k] = std::max(hi[k], p[k]); }
+	}
+	const float extent = std::max({ hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], 1e-30f });
+	const float scale = 1023.0f / extent;
+
+	// 10 bits per axis, interleaved
+	auto spread = [](uint32_t x) {
+		x &= 0x3ff;
+		x = (x | (x << 16)) & 0x030000ff;
+		x = (x | (x << 8)) & 0x0300f00f;
+		x = (x | (x << 4)) & 0x030c30c3;
+		x = (x | (x << 2)) & 0x09249249;
+		return x;
+	};
+	std::vector<uint64_t> keys(triangle_count);	// morton code << 32 | triangle
+	const size_t block = 1 << 16;
+	detail::parallelFor((triangle_count + block - 1) / block, [&](size_t b)
+	{
+		for (size_t t = b * block; t < std::min(triangle_count, (b + 1) * block); ++t)
+		{
+			uint32_t code = 0;
+			for (int k = 0; k < 3; ++k)
+			{
+				const float c = (positionOf(positions, stride, indices[3 * t])[k] + positionOf(positions, stride, indices[3 * t + 1])[k]
+					+ positionOf(positions, stride, indices[3 * t + 2])[k]) / 3.0f;
+				code |= spread(static_cast<uint32_t>((c - lo[k]) * scale)) << k;
+			}
+			keys[t] = (static_cast<uint64_t>(code) << 32) | t;
+		}
+	}, threads);
+	std::sort(keys.begin(), keys.end());
+
+	const std::vector<uint32_t> source(indices, indices + index_count);
+	for (size_t t = 0; t < triangle_count; ++t)
+		std::memcpy(indices + 3 * t, &source[3 * (keys[t] & 0xffffffffu)], 3 * sizeof(uint32_t));
+}
+
+} //namespace
+
+/****************************************************************************
+ *						Passes												*/
+
+VertexCacheStats df::analyzeVertexCache(const uint32_t* indices, size_t index_count, size_t vertex_count, unsigned cache_size)
+{
+	ASSERT(index_count % 3 == 0, "analyzeVertexCache: the index count has to be a multiple of 3.");
+	VertexCacheStats stats;
+	CacheSimulator cache(vertex_count, cache_size);
+	std::vector<bool> seen(vertex_count, false);
+	for (size_t i = 0; i < index_count; ++i)
+	{
+		stats.transformed += cache.vertex(indices[i]);
+		if (!seen[indices[i]]) { seen[indices[i]] = true; ++stats.vertices; }
+	}
+	stats.triangles = index_count / 3;
+	stats.acmr = stats.triangles > 0 ? static_cast<float>(stats.transformed) / stats.triangles : 0.0f;
+	stats.atvr = stats.vertices > 0 ? static_cast<float>(stats.transformed) / stats.vertices : 0.0f;
+	return stats;
+}
+
+void df::optimizeVertexCache(uint32_t* dst, const uint32_t* indices, size_t index_count, size_t vertex_count, unsigned cache_size)
+{
+	ASSERT(index_count % 3 == 0, "optimizeVertexCache: the index count has to be a multiple of 3.");
+	if (dst == indices) {
+		const std::vector<uint32_t> source(indices, indices + index_count);
+		tipsify(dst, source.data(), index_count, vertex_count, cache_size);
+	}
+	else tipsify(dst, indices, index_count, vertex_count, cache_size);
+}
+
+void df::optimizeOverdraw(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+	size_t position_stride, unsigned cache_size, float threshold)
+{
+	ASSERT(index_count % 3 == 0, "optimizeOverdraw: the index count has to be a multiple of 3.");
+	if (index_count == 0) return;
+	if (dst == indices) {
+		const std::vector<uint32_t> source(indices, indices + index_count);
+		sortClusters(dst, source.data(), index_count, positions, position_stride, cache_size, threshold, vertex_count);
+	}
+	else sortClusters(dst, indices, index_count, positions, position_stride, cache_size, threshold, vertex_count);
+}
+
+size_t df::buildVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t index_count, size_t vertex_count)
+{
+	std::fill(remap, remap + vertex_count, ~0u);
+	uint32_t next = 0;
+	for (size_t i = 0; i < index_count; ++i)
+		if (remap[indices[i]] == ~0u) remap[indices[i]] = next++;
+	return next;
+}
+
+void df::remapIndices(uint32_t* dst, const uint32_t* indices, size_t index_count, const uint32_t* remap)
+{
+	for (size_t i = 0; i < index_count; ++i) dst[i] = remap[indices[i]];
+}
+
+void df::remapVertices(void* dst, const void* vertices, size_t vertex_count, size_t vertex_size, const uint32_t* remap)
+{
+	char* out = static_cast<char*>(dst);
+	const char* in = static_cast<const char*>(vertices);
+	for (size_t v = 0; v < vertex_count; ++v)
+		if (remap[v] != ~0u) std::memcpy(out + remap[v] * vertex_size, in + v * vertex_size, vertex_size);
+}
+
+/****************************************************************************
+ *						Whole mesh											*/
+
+IndexOptimizerReport df::optimizeMesh(uint32_t* indices, size_t index_count, void* vertices, size_t vertex_count, size_t vertex_size,
+	size_t position_offset, const IndexOptimizerSettings& settings)
+{
+	ASSERT(index_count % 3 == 0, "optimizeMesh: the index count has to be a multiple of 3.");
+	ASSERT(position_offset + 3 * sizeof(float) <= vertex_size, "optimizeMesh: the position is outside of the vertex.");
+	IndexOptimizerReport report;
+	report.before = analyzeVertexCache(indices, index_count, vertex_count, settings.cache_size);
+	report.vertex_count = vertex_count;
+
+	const size_t triangle_count = index_count / 3;
+	const size_t chunk_triangles = std::max<size_t>(1, settings.chunk_triangles);
+	const size_t chunk_count = (triangle_count + chunk_triangles - 1) / chunk_triangles;
+	const float* positions = reinterpret_cast<const float*>(static_cast<const char*>(vertices) + position_offset);
+
+	// chunks have to be spatially coherent, otherwise a shuffled input gives every chunk scattered triangles
+	if (chunk_count > 1) sortTrianglesSpatially(indices, index_count, positions, vertex_size, settings.threads);
+
+	// chunks are renumbered to local vertex ids, so the per-vertex arrays stay chunk sized
+	detail::parallelFor(chunk_count, [&](size_t chunk)
+	{
+		uint32_t* chunk_indices = indices + 3 * chunk * chunk_triangles;
+		const size_t count = 3 * std::min(chunk_triangles, triangle_count - chunk * chunk_triangles);
+
+		std::vector<uint32_t> global_ids(chunk_indices, chunk_indices + count);
+		std::sort(global_ids.begin(), global_ids.end());
+		global_ids.erase(std::unique(global_ids.begin(), global_ids.end()), global_ids.end());
+		std::vector<uint32_t> local(count);
+		for (size_t i = 0; i < count; ++i)
+			local[i] = static_cast<uint32_t>(std::lower_bound(global_ids.begin(), global_ids.end(), chunk_indices[i]) - global_ids.begin());
+
+		std::vector<uint32_t> ordered(count);
+		tipsify(ordered.data(), local.data(), count, global_ids.size(), settings.cache_size);
+		if (settings.overdraw_threshold > 1.0f)
+		{
+			std::vector<float> local_positions(3 * global_ids.size());
+			for (size_t v = 0; v < global_ids.size(); ++v)
+				std::memcpy(&local_positions[3 * v], positionOf(positions, vertex_size, global_ids[v]), 3 * sizeof(float));
+			sortClusters(local.data(), ordered.data(), count, local_positions.data(), 3 * sizeof(float), settings.cache_size, settings.overdraw_threshold, global_ids.size());
+		}
+		else local.swap(ordered);
+		for (size_t i = 0; i < count; ++i) chunk_indices[i] = global_ids[local[i]];
+	}, settings.threads);
+
+	if (settings.optimize_fetch)
+	{
+		std::vector<uint32_t> remap(vertex_count);
+		report.vertex_count = buildVertexFetchRemap(remap.data(), indices, index_count, vertex_count);
+		remapIndices(indices, indices, index_count, remap.data());
+		std::vector<char> reordered(report.vertex_count * vertex_size);
+		remapVertices(reordered.data(), vertices, vertex_count, vertex_size, remap.data());
+		std::memcpy(vertices, reordered.data(), reordered.size());
+	}
+	report.after = analyzeVertexCache(indices, index_count, report.vertex_count, settings.cache_size);
+	return report;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "../../config.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+namespace df
+{
+
+/****************************************************************************
+ *						Index buffer optimization							*
+ ****************************************************************************/
+// CPU only reordering of indexed triangle lists, before the data goes into an ElementArrayBuffer:
+//	1. optimizeVertexCache	Tipsify (Sander et al. 2007): triangle order for post-transform cache hits
+//	2. optimizeOverdraw		splits the result into clusters and sorts them outside-in (view independent),
+//							only where it costs less than 'threshold' times the ACMR
+//	3. vertex fetch remap	renumbers the vertices in first use order, so fetches walk the vertex buffer linearly
+// optimizeMesh does all three, processing large meshes in parallel chunks.
+//	df::IndexOptimizerReport r = df::optimizeMesh(indices, vertices);	// positions at offset 0 of the vertex
+//	printf("ACMR %.2f -> %.2f\n", r.before.acmr, r.after.acmr);
+
+struct VertexCacheStats
+{
+	size_t	triangles = 0;
+	size_t	vertices = 0;		// distinct vertices referenced
+	size_t	transformed = 0;	// vertex shader invocations (cache misses)
+	float	acmr = 0;			// average cache miss ratio: transformed / triangles (0.5 is the best possible, 3 the worst)
+	float	atvr = 0;			// average transform to vertex ratio: transformed / vertices (1 is the best possible)
+};
+
+//Simulates a FIFO post-transform cache of 'cache_size' vertices
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t index_count, size_t vertex_count, unsigned cache_size = 16);
+
+//Reorders triangles for vertex cache locality (Tipsify). 'dst' may be the same as 'indices'.
+void optimizeVertexCache(uint32_t* dst, const uint32_t* indices, size_t index_count, size_t vertex_count, unsigned cache_size = 16);
+
+//Reorders clusters of a vertex cache optimized list to reduce overdraw. 'positions' points to the first
+//float3 position, consecutive positions are 'position_stride' bytes apart. 'dst' may be the same as 'indices'.
+void optimizeOverdraw(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+	size_t position_stride, unsigned cache_size = 16, float threshold = 1.05f);
+
+//Fills 'remap' (vertex_count elements) with the new index of each vertex in first use order, unreferenced
+//vertices get ~0u. Returns the number of referenced vertices.
+size_t buildVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t index_count, size_t vertex_count);
+void remapIndices(uint32_t* dst, const uint32_t* indices, size_t index_count, const uint32_t* remap);
+//'dst' must not overlap 'vertices' and must hold buildVertexFetchRemap's result many vertices
+void remapVertices(void* dst, const void* vertices, size_t vertex_count, size_t vertex_size, const uint32_t* remap);
+
+struct IndexOptimizerSettings
+{
+	unsigned	cache_size = 16;
+	float		overdraw_threshold = 1.05f;		// <= 1 disables the overdraw pass
+	bool		optimize_fetch = true;
+	size_t		chunk_triangles = 1 << 18;		// triangles per parallel job, chunks are optimized independently
+	unsigned	threads = 0;					// 0: hardware concurrency
+};
+
+struct IndexOptimizerReport
+{
+	VertexCacheStats before, after;
+	size_t vertex_count = 0;	// after removing the unreferenced vertices
+};
+
+//Runs every pass in place on an interleaved vertex array, the position (3 floats) is at 'position_offset' bytes in each vertex.
+//With the fetch optimization the referenced vertices are moved to the front, the rest is left unspecified.
+IndexOptimizerReport optimizeMesh(uint32_t* indices, size_t index_count, void* vertices, size_t vertex_count, size_t vertex_size,
+	size_t position_offset = 0, const IndexOptimizerSettings& settings = IndexOptimizerSettings());
+
+//Same, and drops the unreferenced vertices from the end
+template<typename Vertex_T>
+IndexOptimizerReport optimizeMesh(std::vector<uint32_t>& indices, std::vector<Vertex_T>& vertices,
+	size_t position_offset = 0, const IndexOptimizerSettings& settings = IndexOptimizerSettings());
+
+/****************************************************************************
+ *						Implementation										*/
+
+template<typename Vertex_T>
+inline IndexOptimizerReport optimizeMesh(std::vector<uint32_t>& indices, std::vector<Vertex_T>& vertices,
+	size_t position_offset, const IndexOptimizerSettings& settings)
+{
+	static_assert(std::is_trivially_copyable_v<Vertex_T>, "optimizeMesh: the vertex type has to be trivially copyable.");
+	IndexOptimizerReport report = optimizeMesh(indices.data(), indices.size(), vertices.data(), vertices.size(), sizeof(Vertex_T), position_offset, settings);
+	vertices.resize(report.vertex_count);
+	return report;
+}
+
+} //namespace df
@@ -0,0 +1,169 @@
+#include "MeshCache.h"
+#include "../File/Hash.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace df;
+
+namespace {
+
+const char cache_magic[8] = { 'D', 'F', 'M', 'E', 'S', 'H', 0, 0 };
+
+//Content hash of big files: 1 MB blocks are hashed in parallel, then the block hashes
+uint64_t hashContent(const char* data, size_t size)
+{
+	const size_t block = 1 << 20;
+	std::vector<uint64_t> hashes((size + block - 1) / block);
+	detail::parallelFor(hashes.size(), [&](size_t b) {
+		hashes[b] = hashBytes(data + b * block, std::min(block, size - b * block));
+	});
+	return hashBytes(hashes.data(), hashes.size() * sizeof(uint64_t), size);
+}
+
+int64_t sourceTime(const std::string& source)
+{
+	std::error_code error;
+	const auto time = std::filesystem::last_write_time(source, error);
+	return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+uint64_t alignUp(uint64_t offset) { return (offset + MeshCacheHeader::SECTION_ALIGNMENT - 1) / MeshCacheHeader::SECTION_ALIGNMENT * MeshCacheHeader::SECTION_ALIGNMENT; }
+
+} //namespace
+
+MeshCacheHeader df::meshCacheLayout(const eltecg::ogl::VertexFormat& format, const VertexSemantic* semantics, const bool* dummies, size_t type_count, const MeshLoadSettings& settings)
+{
+	MeshCacheHeader layout = {};
+	std::copy(cache_magic, cache_magic + 8, layout.magic);
+	layout.version = MeshCacheHeader::VERSION;
+	layout.header_size = sizeof(MeshCacheHeader);
+	layout.stride = static_cast<uint32_t>(format.getStride(0));
+	ASSERT(format.getAttribs().size() <= MeshCacheHeader::MAX_ATTRIBS, "loadMeshCached: too many attributes.");
+	size_t type = 0;
+	for (const eltecg::ogl::VertexAttribFormat& attrib : format.getAttribs()) {
+		if (layout.attrib_count == MeshCacheHeader::MAX_ATTRIBS) break;
+		while (type < type_count && dummies[type]) ++type;
+		layout.attribs[layout.attrib_count++] = { static_cast<uint32_t>(attrib.components), attrib.type, attrib.normalized,
+			static_cast<uint32_t>(attrib.kind), attrib.relative_offset, static_cast<uint32_t>(type < type_count ? semantics[type++] : VertexSemantic::NONE) };
+	}
+	layout.layout_hash = hashBytes(layout.attribs, layout.attrib_count * sizeof(MeshCacheAttrib), layout.stride);
+	layout.layout_hash = hashBytes(&settings.deduplicate, sizeof(bool), layout.layout_hash);
+	return layout;
+}
+
+std::string CachedMesh::GetCachePath(const std::string& source, const MeshCacheHeader& layout, const MeshCacheSettings& settings)
+{
+	std::error_code error;
+	std::filesystem::path absolute = std::filesystem::absolute(source, error);
+	if (error) absolute = source;
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hashString(absolute.lexically_normal().generic_string(), layout.layout_hash)));
+	return (std::filesystem::path(settings.directory) / (std::filesystem::path(source).filename().generic_string() + '.' + key + ".dfmesh")).generic_string();
+}
+
+void CachedMesh::SetSections(const uint8_t* vertices, size_t vertex_bytes, const uint32_t* indices, size_t index_count)
+{
+	_vertices = { vertices, vertex_bytes };
+	_indices = { indices, index_count };
+}
+
+bool CachedMesh::Open(const std::string& source, const MeshCacheHeader& layout, const MeshCacheSettings& settings)
+{
+	std::error_code error;
+	const uint64_t source_size = std::filesystem::file_size(source, error);
+	if (error) return false;	// the import reports it
+	if (!_file.Open(GetCachePath(source, layout, settings)) || _file.GetSize() < sizeof(MeshCacheHeader)) { _file.Close(); return false; }
+
+	MeshCacheHeader header;
+	std::memcpy(&header, _file.GetData(), sizeof(header));
+	bool valid = std::equal(cache_magic, cache_magic + 8, header.magic) && header.version == MeshCacheHeader::VERSION
+		&& header.header_size == sizeof(MeshCacheHeader) && header.layout_hash == layout.layout_hash && header.stride == layout.stride
+		&& header.source_size == source_size && header.vertex_count * header.stride == header.vertex_bytes
+		&& header.vertex_offset + header.vertex_bytes <= _file.GetSize() && header.index_offset + header.index_bytes <= _file.GetSize()
+		&& header.index_bytes == header.index_count * sizeof(uint32_t);
+	const int64_t source_time = sourceTime(source);
+	if (valid && (settings.verify_content || header.source_time != source_time)) {
+		MappedFile source_file(source);	// touched or verified: the content decides
+		valid = source_file.IsOpen() && hashContent(source_file.GetData(), source_file.GetSize()) == header.source_hash;
+		if (valid && header.source_time != source_time) {
+			// same content with a new time stamp (eg. a checkout), store the time so the next run skips the hashing
+			const std::string cache_path = _file.GetPath();
+			_file.Close();
+			{
+				std::fstream patch(cache_path, std::fstream::in | std::fstream::out | std::fstream::binary);
+				patch.seekp(offsetof(MeshCacheHeader, source_time));
+				patch.write(reinterpret_cast<const char*>(&source_time), sizeof(source_time));
+			}
+			valid = _file.Open(cache_path) && _file.GetSize() >= header.index_offset + header.index_bytes;
+		}
+	}
+	if (!valid) { _file.Close(); return false; }
+
+	const uint8_t* base = reinterpret_cast<const uint8_t*>(_file.GetData());
+	SetSections(base + header.vertex_offset, header.vertex_bytes, reinterpret_cast<const uint32_t*>(base + header.index_offset), header.index_count);
+	_vertex_count = header.vertex_count;
+	_stride = static_cast<GLsizei>(header.stride);
+	_imported = false;
+	_errors.clear();
+	return true;
+}
+
+bool CachedMesh::Store(const std::string& source, const MeshCacheHeader& layout, InterleavedMesh&& mesh, const MeshCacheSettings& settings)
+{
+	_file.Close();
+	_imported = true;
+	_errors.clear();
+	_vertex_count = mesh.vertex_count;
+	_stride = mesh.stride;
+
+	MeshCacheHeader header = layout;
+	{
+		MappedFile source_file(source);
+		header.source_size = source_file.GetSize();
+		header.source_hash = hashContent(source_file.GetData(), source_file.GetSize());
+	}
+	header.source_time = sourceTime(source);
+	header.vertex_count = mesh.vertex_count;
+	header.index_count = mesh.indices.size();
+	header.vertex_offset = alignUp(sizeof(MeshCacheHeader));
+	header.vertex_bytes = mesh.vertices.size();
+	header.index_offset = alignUp(header.vertex_offset + header.vertex_bytes);
+	header.index_bytes = mesh.indices.size() * sizeof(uint32_t);
+
+	// written next to the cache and renamed, so an interrupted write never leaves a broken cache behind
+	const std::string cache_path = GetCachePath(source, layout, settings);
+	const std::string temp_path = cache_path + ".tmp";
+	std::error_code error;
+	std::filesystem::create_directories(settings.directory, error);
+	bool written = false;
+	{
+		std::ofstream out(temp_path, std::ofstream::binary | std::ofstream::trunc);
+		if (out.is_open()) {
+			const std::vector<char> padding(MeshCacheHeader::SECTION_ALIGNMENT, 0);
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(padding.data(), header.vertex_offset - sizeof(header));
+			out.write(reinterpret_cast<const char*>(mesh.vertices.data()), header.vertex_bytes);
+			out.write(padding.data(), header.index_offset - header.vertex_offset - header.vertex_bytes);
+			out.write(reinterpret_cast<const char*>(mesh.indices.data()), header.index_bytes);
+			written = out.good();
+		}
+	}
+	if (written) {
+		std::filesystem::rename(temp_path, cache_path, error);
+		written = !error;
+	}
+	if (!written) std::filesystem::remove(temp_path, error);
+
+	if (written && _file.Open(cache_path) && _file.GetSize() >= header.index_offset + header.index_bytes) {
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(_file.GetData());
+		SetSections(base + header.vertex_offset, header.vertex_bytes, reinterpret_cast<const uint32_t*>(base + header.index_offset), header.index_count);
+		return true;
+	}
+	WARNING(true, ("loadMeshCached: could not write the cache of " + source + ", the mesh stays in memory.").c_str());
+	_file.Close();
+	_memory = std::move(mesh);
+	SetSections(_memory.vertices.data(), _memory.vertices.size(), _memory.indices.data(), _memory.indices.size());
+	return false;
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "../../config.h"
+#include "MeshLoader.h"
+#include "../File/MappedFile.h"
+#include <string>
+#include <vector>
+
+namespace df
+{
+
+/****************************************************************************
+ *						Binary mesh cache									*
+ ****************************************************************************/
+// The first loadMeshCached of a source file imports it with loadMesh and writes the interleaved result to
+// a cache file. Later runs map the cache file and hand the mapped sections straight to the GPU, there is
+// no parsing and no copy on the CPU side.
+//	auto mesh = df::loadMeshCached<glm::vec3, eltecg::ogl::snorm_2_10_10_10_t, df::half2>("bunny.obj");
+//	if (!mesh.IsValid()) std::cerr << mesh.GetErrors();
+//	mesh.Upload(vbo, ibo);	// or vbo.constructImmutable(mesh.GetVertices()), uploads.enqueue(vbo, mesh.GetVertices())
+//	vao.addVBO<glm::vec3, eltecg::ogl::snorm_2_10_10_10_t, df::half2>(vbo);	vao.addIBO(ibo);
+// Cache files are named after the source path and the layout, the header holds the source's size, time stamp and content
+// hash and the attribute signature of the type list. A cache whose source or layout differs is rebuilt.
+
+struct MeshCacheSettings
+{
+	std::string	directory = "mesh_cache";	// created on the first write
+	bool		verify_content = false;		// hash the source even if its size and time stamp match the cache
+};
+
+//One attribute of the cached layout (VertexAttribFormat of binding 0 and its semantic)
+struct MeshCacheAttrib
+{
+	uint32_t	components;
+	uint32_t	type;			// GLenum
+	uint32_t	normalized;
+	uint32_t	kind;			// VertexAttribFormat::Kind
+	uint32_t	relative_offset;
+	uint32_t	semantic;		// VertexSemantic
+};
+
+struct MeshCacheHeader
+{
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t MAX_ATTRIBS = 16;
+	static constexpr uint64_t SECTION_ALIGNMENT = 4096;	// sections start on pages
+
+	char			magic[8];		// "DFMESH" and zeros
+	uint32_t		version;
+	uint32_t		header_size;
+	uint64_t		source_size;
+	int64_t			source_time;	// last write time of the source (file clock ticks)
+	uint64_t		source_hash;	// hashBytes of the source's content
+	uint64_t		layout_hash;	// attributes, semantics and the load settings that change the data
+	uint64_t		vertex_count;
+	uint64_t		index_count;
+	uint64_t		vertex_offset;	// in bytes from the start of the file
+	uint64_t		vertex_bytes;
+	uint64_t		index_offset;
+	uint64_t		index_bytes;
+	uint32_t		stride;
+	uint32_t		attrib_count;
+	MeshCacheAttrib	attribs[MAX_ATTRIBS];
+};
+
+//A read-only section of the cache that works as a container for constructImmutable and UploadQueue::enqueue
+template<typename T>
+struct MappedSection
+{
+	using value_type = T;
+	const T*	ptr = nullptr;
+	size_t		count = 0;
+	const T* data() const { return ptr; }
+	size_t size() const { return count; }
+	const T* begin() const { return ptr; }
+	const T* end() const { return ptr + count; }
+};
+
+class CachedMesh
+{
+public:
+	CachedMesh() = default;
+	CachedMesh(CachedMesh&&) = default;
+	CachedMesh& operator=(CachedMesh&&) = default;
+
+	//Maps the cache of 'source' if it is up to date with the source and 'layout'
+	bool Open(const std::string& source, const MeshCacheHeader& layout, const MeshCacheSettings& settings);
+	//Writes the cache of 'source' and maps it. If the cache cannot be written, the mesh is kept in memory instead.
+	bool Store(const std::string& source, const MeshCacheHeader& layout, InterleavedMesh&& mesh, const MeshCacheSettings& settings);
+
+	inline MappedSection<uint8_t> GetVertices() const { return _vertices; }
+	inline MappedSection<uint32_t> GetIndices() const { return _indices; }
+	inline size_t GetVertexCount() const { return _vertex_count; }
+	inline GLsizei GetStride() const { return _stride; }
+	inline bool IsValid() const { return _errors.empty(); }
+	inline bool IsMapped() const { return _file.IsOpen(); }
+	//True if the source was parsed this time (there was no usable cache)
+	inline bool WasImported() const { return _imported; }
+	inline const std::string& GetErrors() const { return _errors; }
+	inline void SetErrors(const std::string& errors) { _errors = errors; }
+
+	//constructImmutable of both buffers straight from the mapped sections
+	template<eltecg::ogl::BufferType T_vbo, eltecg::ogl::BufferType T_ibo>
+	void Upload(eltecg::ogl::Buffer<T_vbo>& vbo, eltecg::ogl::Buffer<T_ibo>& ibo, eltecg::ogl::BufferFlags flags = eltecg::ogl::BufferFlags::NONE) const
+	{
+		vbo.constructImmutable(_vertices, flags);
+		ibo.constructImmutable(_indices, flags);
+	}
+
+	//The cache file of 'source' with 'layout', so meshes loaded with different type lists do not evict each other
+	static std::string GetCachePath(const std::string& source, const MeshCacheHeader& layout, const MeshCacheSettings& settings);
+
+private:
+	void SetSections(const uint8_t* vertices, size_t vertex_bytes, const uint32_t* indices, size_t index_count);
+
+	MappedFile _file;
+	InterleavedMesh _memory;	// only if the cache could not be written
+	MappedSection<uint8_t> _vertices;
+	MappedSection<uint32_t> _indices;
+	size_t _vertex_count = 0;
+	GLsizei _stride = 0;
+	bool _imported = false;
+	std::string _errors;
+};
+
+//The layout part of a cache header (magic, version, attributes, layout hash) for a type list
+template<typename ... T_vertex_types>
+MeshCacheHeader meshCacheLayout(const std::array<VertexSemantic, sizeof...(T_vertex_types)>& semantics, const MeshLoadSettings& settings);
+
+//Non-template part of meshCacheLayout
+MeshCacheHeader meshCacheLayout(const eltecg::ogl::VertexFormat& format, const VertexSemantic* semantics, const bool* dummies, size_t type_count, const MeshLoadSettings& settings);
+
+template<typename ... T_vertex_types>
+CachedMesh loadMeshCached(const std::string& path,
+	const std::array<VertexSemantic, sizeof...(T_vertex_types)>& semantics = defaultSemantics<T_vertex_types...>(),
+	const MeshLoadSettings& settings = MeshLoadSettings(), const MeshCacheSettings& cache_settings = MeshCacheSettings());
+
+/****************************************************************************
+ *						Implementation										*/
+
+template<typename ... T_vertex_types>
+inline MeshCacheHeader meshCacheLayout(const std::array<VertexSemantic, sizeof...(T_vertex_types)>& semantics, const MeshLoadSettings& settings)
+{
+	constexpr bool dummies[] = { eltecg::ogl::is_dummy_t_v<T_vertex_types>... };
+	return meshCacheLayout(eltecg::ogl::VertexFormat::get<T_vertex_types...>(), semantics.data(), dummies, sizeof...(T_vertex_types), settings);
+}
+
+template<typename ... T_vertex_types>
+inline CachedMesh loadMeshCached(const std::string& path, const std::array<VertexSemantic, sizeof...(T_vertex_types)>& semantics,
+	const MeshLoadSettings& settings, const MeshCacheSettings& cache_settings)
+{
+	const MeshCacheHeader layout = meshCacheLayout<T_vertex_types...>(semantics, settings);
+	CachedMesh mesh;
+	if (mesh.Open(path, layout, cache_settings)) return mesh;
+	InterleavedMesh imported = loadMesh<T_vertex_types...>(path, semantics, settings);
+	if (!imported.error.empty()) mesh.SetErrors(imported.error);
+	else mesh.Store(path, layout, std::move(imported), cache_settings);
+	return mesh;
+}
+
+} //namespace df
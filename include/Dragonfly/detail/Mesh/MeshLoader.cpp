@@ -0,0 +1,759 @@
+#include "MeshLoader.h"
+#include "../File/MappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+
+using namespace df;
+
+namespace {
+
+/****************************************************************************
+ *						Number parsing										*/
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+inline bool isDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+	while (p < end && isBlank(*p)) ++p;
+	return p;
+}
+
+inline const char* nextLine(const char* p, const char* end)
+{
+	const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+	return newline ? newline + 1 : end;
+}
+
+const double exact_powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+//Decimal float after optional blanks: [+-]digits[.digits][(e|E)[+-]digits]. Returns nullptr if there is no number.
+//The first 19 significant digits go into an integer that is scaled by an exact power of ten, which is
+//within one float ulp for every input a mesh file has.
+const char* parseFloat(const char* p, const char* end, float& out)
+{
+	p = skipBlanks(p, end);
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+	uint64_t mantissa = 0;
+	int exponent = 0, significant = 0;
+	bool any_digit = false;
+	for (; p < end && isDigit(*p); ++p, any_digit = true) {
+		if (significant < 19) { mantissa = 10 * mantissa + (*p - '0'); significant += mantissa != 0; }
+		else ++exponent;
+	}
+	if (p < end && *p == '.')
+		for (++p; p < end && isDigit(*p); ++p, any_digit = true)
+			if (significant < 19) { mantissa = 10 * mantissa + (*p - '0'); significant += mantissa != 0; --exponent; }
+	if (!any_digit) return nullptr;
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char* q = p + 1;
+		bool negative_exponent = false;
+		if (q < end && (*q == '-' || *q == '+')) negative_exponent = *q++ == '-';
+		if (q < end && isDigit(*q)) {
+			int e = 0;
+			for (; q < end && isDigit(*q); ++q) if (e < 10000) e = 10 * e + (*q - '0');
+			exponent += negative_exponent ? -e : e;
+			p = q;
+		}
+	}
+	double value = static_cast<double>(mantissa);
+	if (mantissa != 0 && exponent != 0) {
+		if (-22 <= exponent && exponent < 0)	value /= exact_powers_of_ten[-exponent];
+		else if (0 < exponent && exponent <= 22)	value *= exact_powers_of_ten[exponent];
+		else value *= std::pow(10.0, exponent);
+	}
+	out = static_cast<float>(negative ? -value : value);
+	return p;
+}
+
+//Signed decimal integer after optional blanks, nullptr if there is none
+const char* parseInt(const char* p, const char* end, int64_t& out)
+{
+	p = skipBlanks(p, end);
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+	if (p == end || !isDigit(*p)) return nullptr;
+	int64_t value = 0;
+	for (; p < end && isDigit(*p); ++p) value = 10 * value + (*p - '0');
+	out = negative ? -value : value;
+	return p;
+}
+
+//Cuts [begin, end) into pieces of about 'chunk_size' bytes that end after a '\n'
+std::vector<std::pair<const char*, const char*>> splitLines(const char* begin, const char* end, size_t chunk_size)
+{
+	std::vector<std::pair<const char*, const char*>> chunks;
+	chunk_size = std::max<size_t>(chunk_size, 1);
+	for (const char* p = begin; p < end; ) {
+		const char* chunk_end = static_cast<size_t>(end - p) <= chunk_size ? end : nextLine(p + chunk_size, end);
+		chunks.emplace_back(p, chunk_end);
+		p = chunk_end;
+	}
+	return chunks;
+}
+
+std::string lineAt(const char* p, const char* end)
+{
+	const char* line_end = p;
+	while (line_end < end && *line_end != '\n' && *line_end != '\r' && line_end - p < 80) ++line_end;
+	return std::string(p, line_end);
+}
+
+/****************************************************************************
+ *						OBJ													*/
+
+// Face indices as written in the file are resolved after every chunk is parsed: absolute ones are stored
+// zero based, relative (negative) ones relative to the chunk's first element plus this tag.
+constexpr int64_t relative_tag = int64_t(1) << 62;
+constexpr int64_t missing_index = -1;
+
+struct ObjCorner { int64_t v, vt, vn; };
+
+struct ObjChunk
+{
+	std::vector<glm::vec3>	positions, normals;
+	std::vector<glm::vec2>	texcoords;
+	std::vector<glm::vec4>	colors;		// empty or one per position
+	std::vector<ObjCorner>	corners;	// three per triangle
+	std::string				error;
+};
+
+inline const char* parseObjIndex(const char* p, const char* end, size_t local_count, int64_t& out)
+{
+	int64_t index;
+	const char* q = parseInt(p, end, index);
+	if (q == nullptr) return nullptr;
+	if (index > 0)		out = index - 1;
+	else if (index < 0)	out = relative_tag + static_cast<int64_t>(local_count) + index;
+	else return nullptr;	// OBJ indices start at 1
+	return q;
+}
+
+void parseObjChunk(const char* p, const char* end, ObjChunk& chunk)
+{
+	std::vector<ObjCorner> polygon;
+	for (; p < end; p = nextLine(p, end))
+	{
+		const char* line = p = skipBlanks(p, end);
+		if (end - p < 2 || (!isBlank(p[1]) && !(p[0] == 'v' && end - p > 2 && isBlank(p[2])))) continue;
+		bool ok = true;
+		if (p[0] == 'v' && isBlank(p[1]))
+		{	// v x y z [w] | v x y z r g b
+			float values[7] = {};
+			int count = 0;
+			for (const char* q = p + 1; count < 7 && (q = parseFloat(q, end, values[count])) != nullptr; ++count) p = q;
+			ok = count >= 3;
+			chunk.positions.emplace_back(values[0], values[1], values[2]);
+			if (count >= 6) {
+				if (chunk.colors.size() + 1 < chunk.positions.size()) chunk.colors.resize(chunk.positions.size() - 1, glm::vec4(1));
+				const float* rgb = values + (count == 6 ? 3 : 4);
+				chunk.colors.emplace_back(rgb[0], rgb[1], rgb[2], 1.0f);
+			}
+			else if (!chunk.colors.empty()) chunk.colors.emplace_back(1.0f);
+		}
+		else if (p[0] == 'v' && p[1] == 't')
+		{	// vt u [v [w]]
+			glm::vec2 uv(0);
+			const char* q = parseFloat(p + 2, end, uv.x);
+			ok = q != nullptr;
+			if (ok && parseFloat(q, end, uv.y) == nullptr) uv.y = 0;
+			chunk.texcoords.push_back(uv);
+		}
+		else if (p[0] == 'v' && p[1] == 'n')
+		{	// vn x y z
+			glm::vec3 n;
+			const char* q = parseFloat(p + 2, end, n.x);
+			ok = q && (q = parseFloat(q, end, n.y)) && parseFloat(q, end, n.z);
+			chunk.normals.push_back(n);
+		}
+		else if (p[0] == 'f')
+		{	// f v[/vt][/vn] ... or f v//vn ...
+			polygon.clear();
+			for (p = skipBlanks(p + 1, end); p < end && *p != '\n' && *p != '#'; p = skipBlanks(p, end))
+			{
+				ObjCorner c = { missing_index, missing_index, missing_index };
+				p = parseObjIndex(p, end, chunk.positions.size(), c.v);
+				if (p && p < end && *p == '/') {
+					if (++p < end && *p != '/') p = parseObjIndex(p, end, chunk.texcoords.size(), c.vt);
+					if (p && p < end && *p == '/') p = parseObjIndex(p + 1, end, chunk.normals.size(), c.vn);
+				}
+				if (!(ok = p != nullptr)) break;
+				polygon.push_back(c);
+			}
+			ok = ok && polygon.size() >= 3;
+			for (size_t i = 2; ok && i < polygon.size(); ++i) {
+				chunk.corners.push_back(polygon[0]);
+				chunk.corners.push_back(polygon[i - 1]);
+				chunk.corners.push_back(polygon[i]);
+			}
+			if (!ok) p = line;
+		}
+		if (!ok) {
+			chunk.error = "parseObj: cannot parse \"" + lineAt(line, end) + "\"\n";
+			return;
+		}
+	}
+	if (!chunk.colors.empty()) chunk.colors.resize(chunk.positions.size(), glm::vec4(1));
+}
+
+//Open addressing table of vertex ids, keyed by the corner triples they were made from
+class CornerTable
+{
+public:
+	explicit CornerTable(size_t expected) { rehash(std::max<size_t>(64, 2 * expected)); }
+
+	//The id of the triple, a new one (the number of unique triples so far) if it is the first of its kind
+	uint32_t insert(const uint32_t* triple)
+	{
+		if (2 * (_keys.size() / 3 + 1) > _slots.size()) rehash(2 * _slots.size());
+		for (size_t slot = hash(triple) & _mask; ; slot = (slot + 1) & _mask) {
+			const uint32_t id = _slots[slot];
+			if (id == ~0u) {
+				_slots[slot] = static_cast<uint32_t>(_keys.size() / 3);
+				_keys.insert(_keys.end(), triple, triple + 3);
+				return _slots[slot];
+			}
+			if (std::memcmp(&_keys[3 * size_t(id)], triple, 3 * sizeof(uint32_t)) == 0) return id;
+		}
+	}
+	//Three per unique vertex, in id order
+	const std::vector<uint32_t>& keys() const { return _keys; }
+
+private:
+	static size_t hash(const uint32_t* t)
+	{
+		uint64_t h = (uint64_t(t[0]) * 0x9E3779B97F4A7C15ull) ^ (uint64_t(t[1]) * 0xC2B2AE3D27D4EB4Full) ^ (uint64_t(t[2]) * 0x165667B19E3779F9ull);
+		return static_cast<size_t>(h ^ (h >> 29));
+	}
+	void rehash(size_t min_size)
+	{
+		size_t size = 64;
+		while (size < min_size) size *= 2;
+		_slots.assign(size, ~0u);
+		_mask = size - 1;
+		for (uint32_t id = 0; id < _keys.size() / 3; ++id) {
+			size_t slot = hash(&_keys[3 * size_t(id)]) & _mask;
+			while (_slots[slot] != ~0u) slot = (slot + 1) & _mask;
+			_slots[slot] = id;
+		}
+	}
+	std::vector<uint32_t> _slots;
+	std::vector<uint32_t> _keys;
+	size_t _mask = 0;
+};
+
+template<typename T>
+void concatenate(std::vector<T>& dst, std::vector<ObjChunk>& chunks, std::vector<T> ObjChunk::* member, const std::vector<size_t>& offsets, unsigned threads)
+{
+	dst.resize(offsets.back());
+	detail::parallelFor(chunks.size(), [&](size_t c) {
+		std::copy((chunks[c].*member).begin(), (chunks[c].*member).end(), dst.begin() + offsets[c]);
+		std::vector<T>().swap(chunks[c].*member);
+	}, threads);
+}
+
+template<typename T>
+std::vector<size_t> prefixSums(const std::vector<ObjChunk>& chunks, std::vector<T> ObjChunk::* member)
+{
+	std::vector<size_t> offsets(chunks.size() + 1, 0);
+	for (size_t c = 0; c < chunks.size(); ++c) offsets[c + 1] = offsets[c] + (chunks[c].*member).size();
+	return offsets;
+}
+
+/****************************************************************************
+ *						PLY													*/
+
+enum class PlyType { NONE, INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+enum class PlyFormat { ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN };
+
+//Where a vertex property goes: x y z nx ny nz u v red green blue alpha
+enum PlySlot { PLY_X, PLY_Y, PLY_Z, PLY_NX, PLY_NY, PLY_NZ, PLY_U, PLY_V, PLY_R, PLY_G, PLY_B, PLY_A, PLY_SLOT_COUNT, PLY_IGNORED = PLY_SLOT_COUNT };
+
+struct PlyProperty
+{
+	std::string	name;
+	PlyType		type = PlyType::NONE;
+	PlyType		count_type = PlyType::NONE;	// not NONE for lists
+	int			slot = PLY_IGNORED;
+};
+
+struct PlyElement
+{
+	std::string					name;
+	size_t						count = 0;
+	std::vector<PlyProperty>	properties;
+	size_t						record_size = 0;	// binary size if there are no lists, 0 otherwise
+};
+
+size_t plySize(PlyType type)
+{
+	switch (type) {
+	case PlyType::INT8: case PlyType::UINT8: return 1;
+	case PlyType::INT16: case PlyType::UINT16: return 2;
+	case PlyType::INT32: case PlyType::UINT32: case PlyType::FLOAT32: return 4;
+	case PlyType::FLOAT64: return 8;
+	default: return 0;
+	}
+}
+
+PlyType plyType(const std::string& name)
+{
+	if (name == "char"   || name == "int8")		return PlyType::INT8;
+	if (name == "uchar"  || name == "uint8")	return PlyType::UINT8;
+	if (name == "short"  || name == "int16")	return PlyType::INT16;
+	if (name == "ushort" || name == "uint16")	return PlyType::UINT16;
+	if (name == "int"    || name == "int32")	return PlyType::INT32;
+	if (name == "uint"   || name == "uint32")	return PlyType::UINT32;
+	if (name == "float"  || name == "float32")	return PlyType::FLOAT32;
+	if (name == "double" || name == "float64")	return PlyType::FLOAT64;
+	return PlyType::NONE;
+}
+
+int plySlot(const std::string& name)
+{
+	static const char* const names[][3] = { { "x" }, { "y" }, { "z" }, { "nx" }, { "ny" }, { "nz" },
+		{ "u", "s", "texture_u" }, { "v", "t", "texture_v" }, { "red", "r" }, { "green", "g" }, { "blue", "b" }, { "alpha", "a" } };
+	for (int slot = 0; slot < PLY_SLOT_COUNT; ++slot)
+		for (const char* alias : names[slot])
+			if (alias && name == alias) return slot;
+	return PLY_IGNORED;
+}
+
+//Integer color channels are normalized, everything else is taken as it is
+float plyNormalizeColor(PlyType type, double value)
+{
+	switch (type) {
+	case PlyType::UINT8:	return static_cast<float>(value / 255.0);
+	case PlyType::UINT16:	return static_cast<float>(value / 65535.0);
+	default:				return static_cast<float>(value);
+	}
+}
+
+class PlyReader
+{
+public:
+	PlyReader(const char* begin, const char* end, const MeshLoadSettings& settings) : _begin(begin), _end(end), _settings(settings) {}
+
+	MeshStreams read()
+	{
+		if (!readHeader()) return fail();
+		const char* p = _data;
+		for (const PlyElement& element : _elements)
+		{
+			if (element.name == "vertex")		p = readVertices(element, p);
+			else if (element.name == "face")	p = readFaces(element, p);
+			else								p = skipElement(element, p);
+			if (p == nullptr) return fail();
+		}
+		for (uint32_t index : _result.indices)
+			if (index >= _result.positions.size()) {
+				_error = "parsePly: vertex index " + std::to_string(index) + " is out of range.\n";
+				return fail();
+			}
+		return std::move(_result);
+	}
+
+private:
+	MeshStreams fail()
+	{
+		MeshStreams failed;
+		failed.error = _error;
+		return failed;
+	}
+
+	bool readHeader()
+	{
+		const char* p = _begin;
+		auto word = [&](const char*& q) {
+			q = skipBlanks(q, _end);
+			const char* start = q;
+			while (q < _end && !isBlank(*q) && *q != '\n') ++q;
+			return std::string(start, q);
+		};
+		if (word(p) != "ply") { _error = "parsePly: not a PLY file.\n"; return false; }
+		for (p = nextLine(p, _end); p < _end; p = nextLine(p, _end))
+		{
+			const char* q = p;
+			const std::string keyword = word(q);
+			if (keyword == "format") {
+				const std::string format = word(q);
+				if (format == "ascii")						_format = PlyFormat::ASCII;
+				else if (format == "binary_little_endian")	_format = PlyFormat::BINARY_LITTLE_ENDIAN;
+				else if (format == "binary_big_endian")		_format = PlyFormat::BINARY_BIG_ENDIAN;
+				else { _error = "parsePly: unknown format " + format + ".\n"; return false; }
+			}
+			else if (keyword == "element") {
+				PlyElement element;
+				element.name = word(q);
+				int64_t count = 0;
+				if (parseInt(q, _end, count) == nullptr || count < 0) { _error = "parsePly: bad element line.\n"; return false; }
+				element.count = static_cast<size_t>(count);
+				_elements.push_back(element);
+			}
+			else if (keyword == "property") {
+				if (_elements.empty()) { _error = "parsePly: property outside of an element.\n"; return false; }
+				PlyProperty property;
+				std::string type = word(q);
+				if (type == "list") {
+					property.count_type = plyType(word(q));
+					if (property.count_type == PlyType::NONE) { _error = "parsePly: bad property \"" + lineAt(p, _end) + "\"\n"; return false; }
+					type = word(q);
+				}
+				property.type = plyType(type);
+				property.name = word(q);
+				if (property.type == PlyType::NONE || property.name.empty()) {
+					_error = "parsePly: bad property \"" + lineAt(p, _end) + "\"\n";
+					return false;
+				}
+				if (_elements.back().name == "vertex" && property.count_type == PlyType::NONE) property.slot = plySlot(property.name);
+				_elements.back().properties.push_back(property);
+			}
+			else if (keyword == "end_header") {
+				_data = nextLine(p, _end);
+				for (PlyElement& element : _elements) {
+					for (const PlyProperty& property : element.properties) element.record_size += plySize(property.type);
+					for (const PlyProperty& property : element.properties) if (property.count_type != PlyType::NONE) element.record_size = 0;
+				}
+				return true;
+			}
+		}
+		_error = "parsePly: the header has no end.\n";
+		return false;
+	}
+
+	//One binary value, nullptr if the data ends
+	const char* readBinary(const char* p, PlyType type, double& out) const
+	{
+		const size_t size = plySize(type);
+		if (static_cast<size_t>(_end - p) < size) return nullptr;
+		unsigned char bytes[8];
+		std::memcpy(bytes, p, size);
+		if (_format == PlyFormat::BINARY_BIG_ENDIAN) std::reverse(bytes, bytes + size);	// everything Dragonfly runs on is little endian
+		switch (type) {
+		case PlyType::INT8:		{ int8_t v;   std::memcpy(&v, bytes, 1); out = v; break; }
+		case PlyType::UINT8:	{ uint8_t v;  std::memcpy(&v, bytes, 1); out = v; break; }
+		case PlyType::INT16:	{ int16_t v;  std::memcpy(&v, bytes, 2); out = v; break; }
+		case PlyType::UINT16:	{ uint16_t v; std::memcpy(&v, bytes, 2); out = v; break; }
+		case PlyType::INT32:	{ int32_t v;  std::memcpy(&v, bytes, 4); out = v; break; }
+		case PlyType::UINT32:	{ uint32_t v; std::memcpy(&v, bytes, 4); out = v; break; }
+		case PlyType::FLOAT32:	{ float v;    std::memcpy(&v, bytes, 4); out = v; break; }
+		case PlyType::FLOAT64:	{ double v;   std::memcpy(&v, bytes, 8); out = v; break; }
+		default: return nullptr;
+		}
+		return p + size;
+	}
+
+	//One value of either format, integers are read as integers (indices above 2^24 do not fit a float)
+	const char* readValue(const char* p, PlyType type, double& out) const
+	{
+		if (_format != PlyFormat::ASCII) return readBinary(p, type, out);
+		if (type == PlyType::FLOAT32 || type == PlyType::FLOAT64) {
+			float value;
+			p = parseFloat(p, _end, value);
+			out = value;
+			return p;
+		}
+		int64_t value;
+		p = parseInt(p, _end, value);
+		out = static_cast<double>(value);
+		return p;
+	}
+
+	//Start of the line after the next 'count' lines (ascii)
+	const char* skipLines(const char* p, size_t count) const
+	{
+		for (size_t i = 0; i < count && p < _end; ++i) p = nextLine(p, _end);
+		return p;
+	}
+
+	//Reads one record's non-list properties into 'slots', skips lists. Returns the end of the record.
+	const char* readRecord(const PlyElement& element, const char* p, float* slots) const
+	{
+		for (const PlyProperty& property : element.properties) {
+			double value = 0;
+			if (property.count_type != PlyType::NONE) {
+				if ((p = readValue(p, property.count_type, value)) == nullptr) return nullptr;
+				for (size_t i = 0; i < static_cast<size_t>(value) && p; ++i) { double item; p = readValue(p, property.type, item); }
+				if (p == nullptr) return nullptr;
+				continue;
+			}
+			if ((p = readValue(p, property.type, value)) == nullptr) return nullptr;
+			if (property.slot == PLY_IGNORED) continue;
+			slots[property.slot] = property.slot >= PLY_R ? plyNormalizeColor(property.type, value) : static_cast<float>(value);
+		}
+		return p;
+	}
+
+	const char* readVertices(const PlyElement& element, const char* p)
+	{
+		bool has[PLY_SLOT_COUNT] = {};
+		for (const PlyProperty& property : element.properties) if (property.slot != PLY_IGNORED) has[property.slot] = true;
+		if (!has[PLY_X] || !has[PLY_Y] || !has[PLY_Z]) { _error = "parsePly: the vertices have no positions.\n"; return nullptr; }
+		const bool normals = has[PLY_NX] && has[PLY_NY] && has[PLY_NZ], texcoords = has[PLY_U] && has[PLY_V], colors = has[PLY_R] && has[PLY_G] && has[PLY_B];
+
+		const size_t count = element.count;
+		_result.positions.resize(count);
+		if (normals)	_result.normals.resize(count);
+		if (texcoords)	_result.texcoords.resize(count);
+		if (colors)		_result.colors.resize(count);
+
+		// records start at fixed offsets in binary files, ascii ones at line starts
+		std::vector<const char*> line_starts;
+		const char* section_end = p + element.record_size * count;
+		if (_format == PlyFormat::ASCII) {
+			const size_t lines_per_job = 1 << 14;
+			for (size_t i = 0; i < count; ++i, p = nextLine(p, _end)) {
+				if (i % lines_per_job == 0) line_starts.push_back(p);
+				if (p == _end) { _error = "parsePly: the file ends in the vertices.\n"; return nullptr; }
+			}
+			line_starts.push_back(section_end = p);
+		}
+		else if (element.record_size == 0) { _error = "parsePly: list properties of binary vertices are not supported.\n"; return nullptr; }
+		else if (static_cast<size_t>(_end - p) < element.record_size * count) { _error = "parsePly: the file ends in the vertices.\n"; return nullptr; }
+
+		const size_t block = 1 << 14;
+		const size_t job_count = (count + block - 1) / block;
+		std::vector<char> failed(job_count, 0);
+		detail::parallelFor(job_count, [&](size_t job)
+		{
+			const char* q = _format == PlyFormat::ASCII ? line_starts[job] : p + job * block * element.record_size;
+			for (size_t i = job * block; i < std::min(count, (job + 1) * block); ++i) {
+				float slots[PLY_SLOT_COUNT] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1 };
+				const char* record_end = readRecord(element, q, slots);
+				if (record_end == nullptr) { failed[job] = 1; return; }
+				q = _format == PlyFormat::ASCII ? nextLine(record_end, _end) : record_end;
+				_result.positions[i] = glm::vec3(slots[PLY_X], slots[PLY_Y], slots[PLY_Z]);
+				if (normals)	_result.normals[i] = glm::vec3(slots[PLY_NX], slots[PLY_NY], slots[PLY_NZ]);
+				if (texcoords)	_result.texcoords[i] = glm::vec2(slots[PLY_U], slots[PLY_V]);
+				if (colors)		_result.colors[i] = glm::vec4(slots[PLY_R], slots[PLY_G], slots[PLY_B], slots[PLY_A]);
+			}
+		}, _settings.threads);
+		if (std::find(failed.begin(), failed.end(), 1) != failed.end()) { _error = "parsePly: cannot parse the vertices.\n"; return nullptr; }
+		return section_end;
+	}
+
+	const char* readFaces(const PlyElement& element, const char* p)
+	{
+		auto list = std::find_if(element.properties.begin(), element.properties.end(), [](const PlyProperty& property) {
+			return property.count_type != PlyType::NONE && (property.name == "vertex_indices" || property.name == "vertex_index"); });
+		if (list == element.properties.end()) { _error = "parsePly: the faces have no vertex_indices.\n"; return nullptr; }
+
+		auto readFace = [&](const char* q, std::vector<uint32_t>& indices) -> const char* {
+			for (auto property = element.properties.begin(); property != element.properties.end() && q; ++property) {
+				double value;
+				if (property->count_type == PlyType::NONE) { q = readValue(q, property->type, value); continue; }
+				if ((q = readValue(q, property->count_type, value)) == nullptr) return nullptr;
+				const size_t corners = static_cast<size_t>(value);
+				uint32_t first = 0, previous = 0;
+				for (size_t k = 0; k < corners && q; ++k) {
+					if ((q = readValue(q, property->type, value)) == nullptr || property != list) continue;
+					const uint32_t index = static_cast<uint32_t>(value);
+					if (k == 0) first = index;
+					else if (k >= 2) indices.insert(indices.end(), { first, previous, index });
+					previous = index;
+				}
+			}
+			return q;
+		};
+
+		if (_format != PlyFormat::ASCII)
+		{	// variable sized binary records, one pass
+			_result.indices.reserve(3 * element.count);
+			for (size_t i = 0; i < element.count && p; ++i) p = readFace(p, _result.indices);
+			if (p == nullptr) _error = "parsePly: the file ends in the faces.\n";
+			return p;
+		}
+
+		const char* begin = p;
+		p = skipLines(p, element.count);
+		const auto chunks = splitLines(begin, p, _settings.chunk_size);
+		std::vector<std::vector<uint32_t>> indices(chunks.size());
+		std::vector<char> failed(chunks.size(), 0);
+		detail::parallelFor(chunks.size(), [&](size_t c) {
+			for (const char* q = chunks[c].first; q < chunks[c].second && !failed[c]; ) {
+				const char* face_end = readFace(q, indices[c]);
+				if (face_end == nullptr) failed[c] = 1;
+				else q = nextLine(face_end, chunks[c].second);
+			}
+		}, _settings.threads);
+		if (std::find(failed.begin(), failed.end(), 1) != failed.end()) { _error = "parsePly: cannot parse the faces.\n"; return nullptr; }
+		size_t total = 0;
+		for (const auto& chunk : indices) total += chunk.size();
+		_result.indices.reserve(total);
+		for (const auto& chunk : indices) _result.indices.insert(_result.indices.end(), chunk.begin(), chunk.end());
+		return p;
+	}
+
+	const char* skipElement(const PlyElement& element, const char* p)
+	{
+		if (_format == PlyFormat::ASCII) return skipLines(p, element.count);
+		if (element.record_size > 0) {
+			if (static_cast<size_t>(_end - p) < element.record_size * element.count) { _error = "parsePly: the file ends in " + element.name + ".\n"; return nullptr; }
+			return p + element.record_size * element.count;
+		}
+		float slots[PLY_SLOT_COUNT];
+		for (size_t i = 0; i < element.count && p; ++i) p = readRecord(element, p, slots);
+		if (p == nullptr) _error = "parsePly: the file ends in " + element.name + ".\n";
+		return p;
+	}
+
+	const char *_begin, *_end, *_data = nullptr;
+	const MeshLoadSettings& _settings;
+	PlyFormat _format = PlyFormat::ASCII;
+	std::vector<PlyElement> _elements;
+	MeshStreams _result;
+	std::string _error;
+};
+
+} //namespace
+
+/****************************************************************************
+ *						OBJ													*/
+
+MeshStreams df::parseObj(const char* begin, const char* end, const MeshLoadSettings& settings)
+{
+	MeshStreams result;
+	const auto ranges = splitLines(begin, end, settings.chunk_size);
+	std::vector<ObjChunk> chunks(ranges.size());
+	detail::parallelFor(ranges.size(), [&](size_t c) { parseObjChunk(ranges[c].first, ranges[c].second, chunks[c]); }, settings.threads);
+	for (const ObjChunk& chunk : chunks)
+		if (!chunk.error.empty()) { result.error = chunk.error; return result; }
+
+	const std::vector<size_t> position_offsets = prefixSums(chunks, &ObjChunk::positions);
+	const std::vector<size_t> texcoord_offsets = prefixSums(chunks, &ObjChunk::texcoords);
+	const std::vector<size_t> normal_offsets = prefixSums(chunks, &ObjChunk::normals);
+	const std::vector<size_t> corner_offsets = prefixSums(chunks, &ObjChunk::corners);
+	const size_t counts[3] = { position_offsets.back(), texcoord_offsets.back(), normal_offsets.back() };
+	if (counts[0] >= ~0u || corner_offsets.back() >= ~0u) { result.error = "parseObj: the mesh does not fit 32 bit indices.\n"; return result; }
+
+	// resolve the indices to global zero based ones (~0u: missing), and find out which attributes the faces use
+	std::vector<uint32_t> corners(3 * corner_offsets.back());
+	std::vector<char> failed(chunks.size(), 0), uses_texcoords(chunks.size(), 0), uses_normals(chunks.size(), 0);
+	detail::parallelFor(chunks.size(), [&](size_t c)
+	{
+		const size_t bases[3] = { position_offsets[c], texcoord_offsets[c], normal_offsets[c] };
+		uint32_t* out = corners.data() + 3 * corner_offsets[c];
+		for (const ObjCorner& corner : chunks[c].corners) {
+			const int64_t indices[3] = { corner.v, corner.vt, corner.vn };
+			for (int k = 0; k < 3; ++k, ++out) {
+				int64_t index = indices[k];
+				if (index == missing_index) { *out = ~0u; failed[c] |= k == 0; continue; }
+				if (index >= relative_tag / 2) index += static_cast<int64_t>(bases[k]) - relative_tag;
+				if (index < 0 || index >= static_cast<int64_t>(counts[k])) { failed[c] = 1; *out = ~0u; continue; }
+				*out = static_cast<uint32_t>(index);
+			}
+			uses_texcoords[c] |= corner.vt != missing_index;
+			uses_normals[c] |= corner.vn != missing_index;
+		}
+		std::vector<ObjCorner>().swap(chunks[c].corners);
+	}, settings.threads);
+	if (std::find(failed.begin(), failed.end(), 1) != failed.end()) { result.error = "parseObj: a face index is out of range.\n"; return result; }
+	const bool has_texcoords = std::find(uses_texcoords.begin(), uses_texcoords.end(), 1) != uses_texcoords.end();
+	const bool has_normals = std::find(uses_normals.begin(), uses_normals.end(), 1) != uses_normals.end();
+	const bool has_colors = std::any_of(chunks.begin(), chunks.end(), [](const ObjChunk& chunk) { return !chunk.colors.empty(); });
+	if (has_colors)
+		for (ObjChunk& chunk : chunks) if (chunk.colors.empty()) chunk.colors.assign(chunk.positions.size(), glm::vec4(1));
+
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> texcoords;
+	std::vector<glm::vec4> colors;
+	concatenate(positions, chunks, &ObjChunk::positions, position_offsets, settings.threads);
+	if (has_colors)		concatenate(colors, chunks, &ObjChunk::colors, position_offsets, settings.threads);
+	if (has_texcoords)	concatenate(texcoords, chunks, &ObjChunk::texcoords, texcoord_offsets, settings.threads);
+	if (has_normals)	concatenate(normals, chunks, &ObjChunk::normals, normal_offsets, settings.threads);
+	chunks.clear();
+
+	const size_t corner_count = corners.size() / 3;
+	if (!has_texcoords && !has_normals)
+	{	// positions are the vertices
+		result.indices.resize(corner_count);
+		for (size_t i = 0; i < corner_count; ++i) result.indices[i] = corners[3 * i];
+		result.positions = std::move(positions);
+		result.colors = std::move(colors);
+		return result;
+	}
+
+	std::vector<uint32_t> unique_corners;	// v, vt, vn of every output vertex
+	if (settings.deduplicate) {
+		CornerTable table(std::max({ counts[0], counts[1], counts[2] }));
+		result.indices.resize(corner_count);
+		for (size_t i = 0; i < corner_count; ++i) result.indices[i] = table.insert(&corners[3 * i]);
+		unique_corners = table.keys();
+	}
+	else {
+		result.indices.resize(corner_count);
+		for (size_t i = 0; i < corner_count; ++i) result.indices[i] = static_cast<uint32_t>(i);
+		unique_corners.swap(corners);
+	}
+
+	const size_t vertex_count = unique_corners.size() / 3;
+	result.positions.resize(vertex_count);
+	if (has_colors)		result.colors.resize(vertex_count);
+	if (has_texcoords)	result.texcoords.resize(vertex_count);
+	if (has_normals)	result.normals.resize(vertex_count);
+	const size_t block = 1 << 16;
+	detail::parallelFor((vertex_count + block - 1) / block, [&](size_t b) {
+		for (size_t i = b * block; i < std::min(vertex_count, (b + 1) * block); ++i) {
+			const uint32_t* c = &unique_corners[3 * i];
+			result.positions[i] = positions[c[0]];
+			if (has_colors)		result.colors[i] = colors[c[0]];
+			if (has_texcoords)	result.texcoords[i] = c[1] != ~0u ? texcoords[c[1]] : glm::vec2(0);
+			if (has_normals)	result.normals[i] = c[2] != ~0u ? normals[c[2]] : glm::vec3(0);
+		}
+	}, settings.threads);
+	return result;
+}
+
+/****************************************************************************
+ *						PLY													*/
+
+MeshStreams df::parsePly(const char* begin, const char* end, const MeshLoadSettings& settings)
+{
+	return PlyReader(begin, end, settings).read();
+}
+
+/****************************************************************************
+ *						Files and interleaving								*/
+
+MeshStreams df::loadMeshStreams(const std::string& path, const MeshLoadSettings& settings)
+{
+	std::string extension = std::filesystem::path(path).extension().generic_string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+	MeshStreams result;
+	if (extension != ".obj" && extension != ".ply") {
+		result.error = "loadMesh: unknown mesh format : " + path + '\n';
+		return result;
+	}
+	MappedFile file(path);
+	if (!file.IsOpen()) {
+		result.error = file.GetErrors();
+		return result;
+	}
+	const char* begin = file.GetData();
+	result = extension == ".obj" ? parseObj(begin, begin + file.GetSize(), settings) : parsePly(begin, begin + file.GetSize(), settings);
+	if (!result.error.empty()) result.error = path + " : " + result.error;
+	return result;
+}
+
+void df::detail::gatherAttrib(float* dst, int components, const MeshStreams& streams, VertexSemantic semantic, size_t first, size_t count)
+{
+	const float* src = nullptr;
+	int src_components = 0;
+	glm::vec4 fill(0, 0, 0, 1);
+	switch (semantic) {
+	case VertexSemantic::POSITION:	src = reinterpret_cast<const float*>(streams.positions.data());	src_components = streams.positions.empty() ? 0 : 3;	break;
+	case VertexSemantic::NORMAL:	src = reinterpret_cast<const float*>(streams.normals.data());	src_components = streams.normals.empty() ? 0 : 3;	fill.w = 0;	break;
+	case VertexSemantic::TEXCOORD:	src = reinterpret_cast<const float*>(streams.texcoords.data());	src_components = streams.texcoords.empty() ? 0 : 2;	fill.w = 0;	break;
+	case VertexSemantic::COLOR:		src = reinterpret_cast<const float*>(streams.colors.data());	src_components = streams.colors.empty() ? 0 : 4;	fill = glm::vec4(1);	break;
+	default:						fill.w = 0;	break;
+	}
+	const int copied = std::min(components, src_components);
+	for (size_t i = 0; i < count; ++i, dst += components) {
+		for (int k = 0; k < copied; ++k) dst[k] = src[(first + i) * src_components + k];
+		for (int k = copied; k < components; ++k) dst[k] = fill[k];
+	}
+}
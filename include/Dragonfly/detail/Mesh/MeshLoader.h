@@ -0,0 +1,168 @@
+#pragma once
+#include "../../config.h"
+#include "../vao.h"
+#include "Parallel.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace df
+{
+
+/****************************************************************************
+ *						Mesh loading										*
+ ****************************************************************************/
+// Wavefront OBJ and PLY (ascii and binary) loading for large files. The file is memory mapped and
+// cut into chunks at line boundaries that are parsed in parallel, OBJ v/vt/vn triples are merged
+// into unique vertices with a hash table. The result is a triangle list (polygons are fanned).
+//	auto mesh = df::loadMesh<glm::vec3, eltecg::ogl::snorm_2_10_10_10_t, df::half2>("bunny.obj");	// position, normal, texcoord
+//	if (!mesh.error.empty()) ...
+//	vbo.constructImmutable(mesh.vertices);	vao.addVBO<glm::vec3, eltecg::ogl::snorm_2_10_10_10_t, df::half2>(vbo);
+//	ibo.constructImmutable(mesh.indices);	vao.addIBO(ibo);
+// OBJ groups, materials and smoothing groups are ignored. 'v x y z r g b' vertex colors are read.
+
+enum class VertexSemantic { POSITION, NORMAL, TEXCOORD, COLOR, NONE };
+
+struct MeshLoadSettings
+{
+	bool		deduplicate = true;		// OBJ: one vertex per distinct v/vt/vn triple, otherwise one per face corner
+	size_t		chunk_size = 1 << 22;	// bytes parsed by one job
+	unsigned	threads = 0;			// 0: hardware concurrency
+};
+
+//Vertex attributes one after the other. The ones the file does not have are empty.
+struct MeshStreams
+{
+	std::vector<glm::vec3>	positions;
+	std::vector<glm::vec3>	normals;
+	std::vector<glm::vec2>	texcoords;
+	std::vector<glm::vec4>	colors;
+	std::vector<uint32_t>	indices;	// triangle list
+	std::string				error;		// empty on success
+
+	size_t vertexCount() const { return positions.size(); }
+};
+
+//Picks the parser from the extension (.obj or .ply)
+MeshStreams loadMeshStreams(const std::string& path, const MeshLoadSettings& settings = MeshLoadSettings());
+MeshStreams parseObj(const char* begin, const char* end, const MeshLoadSettings& settings = MeshLoadSettings());
+MeshStreams parsePly(const char* begin, const char* end, const MeshLoadSettings& settings = MeshLoadSettings());
+
+//Interleaved vertices in the layout of addVBO<T_vertex_types...>, ready for Buffer::constructImmutable
+struct InterleavedMesh
+{
+	std::vector<uint8_t>	vertices;
+	std::vector<uint32_t>	indices;
+	size_t					vertex_count = 0;
+	GLsizei					stride = 0;
+	std::string				error;
+};
+
+//The semantics of a type list when none are given: position, normal, texcoord, color, then nothing
+template<typename ... T_vertex_types>
+std::array<VertexSemantic, sizeof...(T_vertex_types)> defaultSemantics();
+
+//Writes streams.vertexCount() vertices with the layout of addVBO<T_vertex_types...> to 'dst', converting to the
+//packed types of VertexPacking.h where needed. Missing streams are zero (colors and the w of positions are one).
+template<typename ... T_vertex_types>
+void interleaveVertices(void* dst, const MeshStreams& streams,
+	const std::array<VertexSemantic, sizeof...(T_vertex_types)>& semantics = defaultSemantics<T_vertex_types...>(), unsigned threads = 0);
+
+template<typename ... T_vertex_types>
+InterleavedMesh loadMesh(const std::string& path,
+	const std::array<VertexSemantic, sizeof...(T_vertex_types)>& semantics = defaultSemantics<T_vertex_types...>(),
+	const MeshLoadSettings& settings = MeshLoadSettings());
+
+/****************************************************************************
+ *						Implementation										*/
+
+namespace detail {
+	//Writes 'count' vertices from 'first' as 'components' floats each, padded from the semantic's defaults
+	void gatherAttrib(float* dst, int components, const MeshStreams& streams, VertexSemantic semantic, size_t first, size_t count);
+
+	constexpr size_t interleave_block = 1 << 12;	// vertices per job
+
+	template<typename T_attrib>
+	void interleaveAttrib(uint8_t* dst, size_t stride, size_t& offset, const MeshStreams& streams, VertexSemantic semantic,
+		size_t first, size_t count, std::vector<float>& scratch)
+	{
+		using namespace eltecg::ogl;
+		using stored_t = unwrap_attrib_type_t<T_attrib>;
+		const size_t attrib_offset = offset;
+		offset += sizeof(T_attrib);
+		if constexpr (is_dummy_t_v<T_attrib>) return;
+		else
+		{
+			constexpr bool is_packed = ::eltecg::ogl::detail::packed_components<stored_t>::value > 0 && !std::is_same_v<stored_t, glm::vec<::eltecg::ogl::detail::packed_components<stored_t>::value, float>>;
+			constexpr int components = std::is_same_v<stored_t, float> ? 1 : is_packed ? ::eltecg::ogl::detail::packed_components<stored_t>::value : static_cast<int>(sizeof(stored_t) / sizeof(float));
+			static_assert(is_packed || std::is_same_v<stored_t, float> || std::is_same_v<stored_t, glm::vec<components, float>>,
+				"interleaveVertices: the attributes have to be float vectors or packed types of VertexPacking.h.");
+			if (semantic == VertexSemantic::NONE) return;	// the vector is zero filled
+			scratch.resize(count * components);
+			gatherAttrib(scratch.data(), components, streams, semantic, first, count);
+
+			stored_t packed[interleave_block];
+			const float* in = scratch.data();
+			if constexpr (!is_packed)
+				std::memcpy(packed, in, count * sizeof(stored_t));
+			else if constexpr (std::is_same_v<stored_t, snorm_2_10_10_10_t>)	encodeSnorm2_10_10_10(in, 4, packed, count);
+			else if constexpr (std::is_same_v<stored_t, unorm_2_10_10_10_t>)	encodeUnorm2_10_10_10(in, 4, packed, count);
+			else if constexpr (::eltecg::ogl::detail::is_half_v<stored_t>)		encodeHalf(in, reinterpret_cast<uint16_t*>(packed), count * components);
+			else if constexpr (std::is_same_v<stored_t, snorm8_t<components>>)	encodeSnorm8(in, reinterpret_cast<int8_t*>(packed), count * components);
+			else if constexpr (std::is_same_v<stored_t, snorm16_t<components>>)	encodeSnorm16(in, reinterpret_cast<int16_t*>(packed), count * components);
+			else if constexpr (std::is_same_v<stored_t, unorm8_t<components>>)	encodeUnorm8(in, reinterpret_cast<uint8_t*>(packed), count * components);
+			else if constexpr (std::is_same_v<stored_t, unorm16_t<components>>)	encodeUnorm16(in, reinterpret_cast<uint16_t*>(packed), count * components);
+			else static_assert(components < 0, "interleaveVertices: unsupported packed vertex attribute type.");
+
+			uint8_t* out = dst + first * stride + attrib_offset;
+			for (size_t v = 0; v < count; ++v, out += stride)
+				std::memcpy(out, packed + v, sizeof(stored_t));
+		}
+	}
+} //namespace detail
+
+template<typename ... T_vertex_types>
+inline std::array<VertexSemantic, sizeof...(T_vertex_types)> defaultSemantics()
+{
+	std::array<VertexSemantic, sizeof...(T_vertex_types)> semantics;
+	for (size_t i = 0; i < semantics.size(); ++i)
+		semantics[i] = i < 4 ? static_cast<VertexSemantic>(i) : VertexSemantic::NONE;
+	return semantics;
+}
+
+template<typename ... T_vertex_types>
+inline void interleaveVertices(void* dst, const MeshStreams& streams, const std::array<VertexSemantic, sizeof...(T_vertex_types)>& semantics, unsigned threads)
+{
+	constexpr size_t stride = (0 + ... + sizeof(T_vertex_types));
+	const size_t vertex_count = streams.vertexCount();
+	std::memset(dst, 0, vertex_count * stride);
+	detail::parallelFor((vertex_count + detail::interleave_block - 1) / detail::interleave_block, [&](size_t b)
+	{
+		const size_t first = b * detail::interleave_block;
+		const size_t count = std::min(detail::interleave_block, vertex_count - first);
+		std::vector<float> scratch;
+		size_t offset = 0, attrib = 0;
+		(detail::interleaveAttrib<T_vertex_types>(static_cast<uint8_t*>(dst), stride, offset, streams, semantics[attrib++], first, count, scratch), ...);
+	}, threads);
+}
+
+template<typename ... T_vertex_types>
+inline InterleavedMesh loadMesh(const std::string& path, const std::array<VertexSemantic, sizeof...(T_vertex_types)>& semantics, const MeshLoadSettings& settings)
+{
+	MeshStreams streams = loadMeshStreams(path, settings);
+	InterleavedMesh result;
+	result.error = std::move(streams.error);
+	if (!result.error.empty()) return result;
+	result.vertex_count = streams.vertexCount();
+	result.stride = eltecg::ogl::VertexFormat::get<T_vertex_types...>().getStride(0);
+	result.vertices.resize(result.vertex_count * result.stride);
+	interleaveVertices<T_vertex_types...>(result.vertices.data(), streams, semantics, settings.threads);
+	result.indices = std::move(streams.indices);
+	return result;
+}
+
+} //namespace df
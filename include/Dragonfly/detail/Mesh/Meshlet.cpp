@@ -0,0 +1,267 @@
+#include "Meshlet.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace df;
+
+namespace {
+
+//Triangles around each vertex: triangles[offsets[v] .. offsets[v+1])
+struct Adjacency
+{
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> triangles;
+
+	Adjacency(const uint32_t* indices, size_t index_count, size_t vertex_count) : offsets(vertex_count + 1, 0), triangles(index_count)
+	{
+		for (size_t i = 0; i < index_count; ++i) ++offsets[indices[i] + 1];
+		for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] += offsets[v];
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < index_count; ++i) triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+	uint32_t count(uint32_t v) const { return offsets[v + 1] - offsets[v]; }
+};
+
+glm::vec3 positionOf(const float* positions, size_t stride, uint32_t v)
+{
+	const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+	return glm::vec3(p[0], p[1], p[2]);
+}
+
+//Greedy meshlets of one chunk. Meshlet offsets are relative to 'out'.
+void buildChunk(const uint32_t* indices, size_t index_count, const float* positions, size_t stride, [[maybe_unused]] size_t max_vertex_count,
+	const MeshletSettings& settings, MeshletMesh& out)
+{
+	// local vertex numbering, so the per vertex arrays are as small as the chunk
+	std::vector<uint32_t> unique(indices, indices + index_count);
+	std::sort(unique.begin(), unique.end());
+	unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+	ASSERT(unique.back() < max_vertex_count, "buildMeshlets: index out of the vertex range.");
+	std::vector<uint32_t> local(index_count);
+	for (size_t i = 0; i < index_count; ++i)
+		local[i] = static_cast<uint32_t>(std::lower_bound(unique.begin(), unique.end(), indices[i]) - unique.begin());
+
+	const size_t vertex_count = unique.size(), triangle_count = index_count / 3;
+	const Adjacency adjacency(local.data(), index_count, vertex_count);
+	std::vector<uint32_t> live(vertex_count);
+	for (uint32_t v = 0; v < vertex_count; ++v) live[v] = adjacency.count(v);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<uint32_t> owner(vertex_count, ~0u);	// meshlet that already has the vertex
+	std::vector<uint8_t>  slot(vertex_count, 0);		// its index in that meshlet
+	std::vector<uint32_t> members;						// local vertices of the current meshlet
+
+	out.meshlets.reserve(triangle_count / settings.max_triangles + 1);
+	out.vertices.reserve(triangle_count);
+	out.triangles.reserve(index_count);
+	Meshlet current = { 0, 0, 0, 0 };
+	uint32_t current_id = 0;
+	glm::vec3 position_sum(0);	// of the current meshlet's vertices
+
+	auto newVertices = [&](uint32_t t) {
+		return (owner[local[3 * t]] != current_id) + (owner[local[3 * t + 1]] != current_id) + (owner[local[3 * t + 2]] != current_id);
+	};
+	auto flush = [&]() {
+		out.meshlets.push_back(current);
+		current = { static_cast<uint32_t>(out.vertices.size()), static_cast<uint32_t>(out.triangles.size() / 3), 0, 0 };
+		members.clear();
+		position_sum = glm::vec3(0);
+		++current_id;
+	};
+	auto add = [&](uint32_t t) {
+		for (int k = 0; k < 3; ++k) {
+			const uint32_t v = local[3 * t + k];
+			if (owner[v] != current_id) {
+				owner[v] = current_id;
+				slot[v] = static_cast<uint8_t>(current.vertex_count++);
+				out.vertices.push_back(unique[v]);
+				members.push_back(v);
+				position_sum += positionOf(positions, stride, unique[v]);
+			}
+			out.triangles.push_back(slot[v]);
+			--live[v];
+		}
+		emitted[t] = true;
+		++current.triangle_count;
+	};
+
+	// the triangle around 'v' that needs the fewest new vertices, ties go to the one closest to the meshlet's center
+	uint32_t best = ~0u, best_new = 4;
+	float best_distance = INFINITY;
+	glm::vec3 center(0);
+	auto distanceOf = [&](uint32_t t) {	// of the triangle's centroid from 'center', times 9
+		const glm::vec3 d = positionOf(positions, stride, indices[3 * t]) + positionOf(positions, stride, indices[3 * t + 1])
+			+ positionOf(positions, stride, indices[3 * t + 2]) - 3.0f * center;
+		return glm::dot(d, d);
+	};
+	auto consider = [&](uint32_t v) {
+		for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; ++i) {
+			const uint32_t t = adjacency.triangles[i];
+			if (emitted[t]) continue;
+			const uint32_t new_vertices = newVertices(t);
+			if (new_vertices > best_new) continue;
+			const float distance = distanceOf(t);
+			if (new_vertices < best_new || distance < best_distance) {
+				best = t; best_new = new_vertices; best_distance = distance;
+			}
+		}
+	};
+
+	size_t cursor = 0;
+	uint32_t last = ~0u;
+	for (size_t done = 0; done < triangle_count; ++done)
+	{
+		best = ~0u; best_new = 4; best_distance = INFINITY;
+		if (current.vertex_count > 0) center = position_sum / static_cast<float>(current.vertex_count);
+		if (last != ~0u)
+			for (int k = 0; k < 3; ++k) consider(local[3 * last + k]);
+		if (best_new > 0)	// nothing closes a gap next to the last triangle, look around the whole meshlet
+			for (uint32_t v : members) if (live[v] > 0) consider(v);
+		if (best == ~0u) {	// nothing adjacent is left, continue with the closest of the next unused triangles in input order
+			while (emitted[cursor]) ++cursor;
+			best = static_cast<uint32_t>(cursor);
+			if (current.triangle_count > 0) {
+				const size_t window = 64;	// keeps triangle soups linear
+				best_distance = distanceOf(best);
+				for (size_t t = cursor + 1, seen = 1; t < triangle_count && seen < window; ++t) {
+					if (emitted[t]) continue;
+					++seen;
+					const float distance = distanceOf(static_cast<uint32_t>(t));
+					if (distance < best_distance) { best = static_cast<uint32_t>(t); best_distance = distance; }
+				}
+			}
+			best_new = newVertices(best);
+		}
+		if (current.vertex_count + best_new > settings.max_vertices || current.triangle_count + 1 > settings.max_triangles)
+			flush();
+		add(best);
+		last = best;
+	}
+	if (current.triangle_count > 0) out.meshlets.push_back(current);
+}
+
+//Ritter's bounding sphere
+void boundingSphere(const uint32_t* indices, size_t index_count, const float* positions, size_t stride, glm::vec3& center, float& radius)
+{
+	auto farthestFrom = [&](const glm::vec3& p) {
+		glm::vec3 result = p;	float max_dist = -1;
+		for (size_t i = 0; i < index_count; ++i) {
+			const glm::vec3 q = positionOf(positions, stride, indices[i]);
+			const float dist = glm::dot(q - p, q - p);
+			if (dist > max_dist) { max_dist = dist; result = q; }
+		}
+		return result;
+	};
+	const glm::vec3 a = farthestFrom(positionOf(positions, stride, indices[0]));
+	const glm::vec3 b = farthestFrom(a);
+	center = 0.5f * (a + b);
+	radius = 0.5f * glm::length(b - a);
+	for (size_t i = 0; i < index_count; ++i) {
+		const glm::vec3 q = positionOf(positions, stride, indices[i]);
+		const float dist = glm::length(q - center);
+		if (dist > radius) {	// move the sphere towards q just enough to contain it
+			const float new_radius = 0.5f * (radius + dist);
+			center += (new_radius - radius) / dist * (q - center);
+			radius = new_radius;
+		}
+	}
+}
+
+} //namespace
+
+/****************************************************************************
+ *						Bounds												*/
+
+MeshletBounds df::computeMeshletBounds(const uint32_t* indices, size_t index_count, const float* positions, size_t position_stride)
+{
+	MeshletBounds bounds = { glm::vec3(0), 0, glm::vec3(0, 0, 1), 1 };
+	if (index_count < 3) return bounds;
+	boundingSphere(indices, index_count, positions, position_stride, bounds.center, bounds.radius);
+
+	std::vector<glm::vec3> normals;
+	normals.reserve(index_count / 3);
+	glm::vec3 sum(0);
+	for (size_t i = 0; i + 2 < index_count; i += 3) {
+		const glm::vec3 a = positionOf(positions, position_stride, indices[i]);
+		const glm::vec3 n = glm::cross(positionOf(positions, position_stride, indices[i + 1]) - a, positionOf(positions, position_stride, indices[i + 2]) - a);
+		const float area = glm::length(n);
+		if (area <= 1e-30f) continue;	// degenerate triangles face every way
+		normals.push_back(n / area);
+		sum += n / area;
+	}
+	const float sum_length = glm::length(sum);
+	if (normals.empty() || sum_length <= 1e-6f) return bounds;
+	bounds.cone_axis = sum / sum_length;
+
+	float min_dot = 1;
+	for (const glm::vec3& n : normals) min_dot = std::min(min_dot, glm::dot(n, bounds.cone_axis));
+	// wider than ~84 degrees is practically never culled, keep cutoff = 1 then
+	if (min_dot > 0.1f) bounds.cone_cutoff = std::sqrt(1 - min_dot * min_dot);
+	return bounds;
+}
+
+/****************************************************************************
+ *						Builder												*/
+
+MeshletMesh df::buildMeshlets(const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+	size_t position_stride, const MeshletSettings& settings)
+{
+	ASSERT(index_count % 3 == 0, "buildMeshlets: the index count has to be a multiple of 3.");
+	ASSERT(3 <= settings.max_vertices && settings.max_vertices <= 256, "buildMeshlets: max_vertices has to be in [3, 256].");
+	ASSERT(1 <= settings.max_triangles, "buildMeshlets: max_triangles has to be positive.");
+	ASSERT(settings.chunk_triangles > 0, "buildMeshlets: chunk_triangles has to be positive.");
+	MeshletMesh result;
+	if (index_count == 0) return result;
+
+	const size_t triangle_count = index_count / 3;
+	const size_t chunk_count = (triangle_count + settings.chunk_triangles - 1) / settings.chunk_triangles;
+	std::vector<MeshletMesh> chunks(chunk_count);
+	detail::parallelFor(chunk_count, [&](size_t c)
+	{
+		const size_t first = c * settings.chunk_triangles;
+		const size_t count = std::min(settings.chunk_triangles, triangle_count - first);
+		buildChunk(indices + 3 * first, 3 * count, positions, position_stride, vertex_count, settings, chunks[c]);
+	}, settings.threads);
+
+	size_t meshlet_total = 0, vertex_total = 0;
+	for (const MeshletMesh& chunk : chunks) { meshlet_total += chunk.meshlets.size(); vertex_total += chunk.vertices.size(); }
+	result.meshlets.reserve(meshlet_total);
+	result.vertices.reserve(vertex_total);
+	result.triangles.reserve(index_count);
+	for (MeshletMesh& chunk : chunks) {
+		const uint32_t vertex_base = static_cast<uint32_t>(result.vertices.size());
+		const uint32_t triangle_base = static_cast<uint32_t>(result.triangles.size() / 3);
+		for (Meshlet m : chunk.meshlets) {
+			m.vertex_offset += vertex_base;
+			m.triangle_offset += triangle_base;
+			result.meshlets.push_back(m);
+		}
+		result.vertices.insert(result.vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+		result.triangles.insert(result.triangles.end(), chunk.triangles.begin(), chunk.triangles.end());
+		chunk = MeshletMesh();
+	}
+
+	result.bounds.resize(result.meshlets.size());
+	const size_t block = 1 << 10;
+	detail::parallelFor((result.meshlets.size() + block - 1) / block, [&](size_t b)
+	{
+		std::vector<uint32_t> meshlet_indices;
+		for (size_t i = b * block; i < std::min(result.meshlets.size(), (b + 1) * block); ++i) {
+			const Meshlet& m = result.meshlets[i];
+			meshlet_indices.resize(3 * m.triangle_count);
+			for (size_t k = 0; k < meshlet_indices.size(); ++k)
+				meshlet_indices[k] = result.vertices[m.vertex_offset + result.triangles[3 * m.triangle_offset + k]];
+			result.bounds[i] = computeMeshletBounds(meshlet_indices.data(), meshlet_indices.size(), positions, position_stride);
+		}
+	}, settings.threads);
+	return result;
+}
+
+std::vector<uint32_t> MeshletMesh::expandIndices() const
+{
+	std::vector<uint32_t> result(triangles.size());
+	for (const Meshlet& m : meshlets)
+		for (size_t k = 0; k < 3 * m.triangle_count; ++k)
+			result[3 * m.triangle_offset + k] = vertices[m.vertex_offset + triangles[3 * m.triangle_offset + k]];
+	return result;
+}
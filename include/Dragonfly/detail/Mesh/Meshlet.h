@@ -0,0 +1,65 @@
+#pragma once
+#include "../../config.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace df
+{
+
+/****************************************************************************
+ *						Meshlets											*
+ ****************************************************************************/
+// Splits an indexed triangle list into small clusters (meshlets) that can be culled one by one on the GPU,
+// see MeshletCuller. Each meshlet has at most 'max_vertices' distinct vertices and 'max_triangles' triangles,
+// a bounding sphere and a normal cone for backface culling.
+// The builder follows the input order and grows each meshlet over the neighbouring triangles, so run
+// optimizeVertexCache (IndexOptimizer.h) on the indices first for tighter meshlets.
+//	df::MeshletMesh meshlets = df::buildMeshlets(indices.data(), indices.size(), &vertices[0].pos.x, vertices.size(), sizeof(Vertex));
+//	std::vector<uint32_t> cluster_indices = meshlets.expandIndices();	// the element buffer to draw from
+
+struct Meshlet
+{
+	uint32_t vertex_offset;		// first element in MeshletMesh::vertices
+	uint32_t triangle_offset;	// first triangle in MeshletMesh::triangles (3 bytes each) and in expandIndices()
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+};
+
+struct MeshletBounds
+{
+	glm::vec3 center;	float radius;		// bounding sphere
+	glm::vec3 cone_axis;	float cone_cutoff;	// every triangle faces away from a viewer at 'eye' if
+	// dot(center - eye, cone_axis) >= cone_cutoff * length(center - eye) + radius. cone_cutoff == 1 never culls.
+};
+
+struct MeshletMesh
+{
+	std::vector<Meshlet>		meshlets;
+	std::vector<MeshletBounds>	bounds;		// one for each meshlet
+	std::vector<uint32_t>		vertices;	// index of the meshlet's vertices in the original vertex buffer
+	std::vector<uint8_t>		triangles;	// 3 meshlet local vertex indices per triangle
+
+	//Original vertex indices of the triangles, meshlet after meshlet. Meshlet i is the range
+	//[3 * triangle_offset, 3 * (triangle_offset + triangle_count)) of it.
+	std::vector<uint32_t> expandIndices() const;
+	size_t triangleCount() const { return triangles.size() / 3; }
+};
+
+struct MeshletSettings
+{
+	unsigned	max_vertices = 64;		// at most 256 (local indices are bytes)
+	unsigned	max_triangles = 124;	// 124 keeps the local triangle list of a meshlet in 372 + 4 bytes
+	size_t		chunk_triangles = 1 << 18;		// triangles per parallel job, meshlets never cross chunks
+	unsigned	threads = 0;					// 0: hardware concurrency
+};
+
+//'positions' points to the first float3 position, consecutive positions are 'position_stride' bytes apart.
+MeshletMesh buildMeshlets(const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+	size_t position_stride, const MeshletSettings& settings = MeshletSettings());
+
+//Bounding sphere and normal cone of the triangles (counter-clockwise front faces)
+MeshletBounds computeMeshletBounds(const uint32_t* indices, size_t index_count, const float* positions, size_t position_stride);
+
+} //namespace df
@@ -0,0 +1,114 @@
+#include "MeshletCuller.h"
+#include "../File/File.h"
+#include "../Program/Program.h"
+#include "../Uniform/Uniform.h"
+#include "../Events/Camera.h"
+
+using namespace df;
+using namespace eltecg::ogl;
+
+namespace {
+
+const char* const cull_shader_source = R"GLSL(
+layout(local_size_x = 64) in;
+
+struct Meshlet		{ vec4 sphere; vec4 cone; uvec4 range; };	// range: first index, index count
+struct DrawCommand	{ uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };
+
+layout(std430, binding = 0) readonly  buffer MeshletBuffer	{ Meshlet meshlets[]; };
+layout(std430, binding = 1) writeonly buffer DrawBuffer		{ DrawCommand draws[]; };
+layout(std430, binding = 2)			  buffer DrawCountBuffer	{ uint draw_count; };
+
+uniform mat4 u_mvp;			// object space to clip space
+uniform vec3 u_eye;			// camera position in object space
+uniform uint u_meshlet_count;
+uniform int  u_base_vertex;
+uniform uint u_cone_culling;
+
+bool inFrustum(vec3 center, float radius)
+{
+	mat4 rows = transpose(u_mvp);	// Gribb-Hartmann planes, in object space because of the model matrix
+	vec4 planes[6] = vec4[6](rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]);
+	for (int i = 0; i < 6; ++i)
+		if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) return false;
+	return true;
+}
+
+void main()
+{
+	uint id = gl_GlobalInvocationID.x;
+	if (id >= u_meshlet_count) return;
+	Meshlet m = meshlets[id];
+	if (!inFrustum(m.sphere.xyz, m.sphere.w)) return;
+	vec3 view = m.sphere.xyz - u_eye;
+	if (u_cone_culling != 0u && dot(view, m.cone.xyz) >= m.cone.w * length(view) + m.sphere.w) return;
+	draws[atomicAdd(draw_count, 1u)] = DrawCommand(m.range.y, 1u, m.range.x, u_base_vertex, 0u);
+}
+)GLSL";
+
+} //namespace
+
+class MeshletCuller::CullProgram : public ComputeProgram
+{
+public:
+	CullProgram() : ComputeProgram("Meshlet culling") {
+		static_assert(MeshletCuller::WORKGROUP_SIZE == 64, "Update local_size_x in the culling shader too.");
+		this->comp << SFile::FromSource("MeshletCuller.comp", cull_shader_source, 430);
+	}
+};
+
+MeshletCuller::MeshletCuller() : _program(std::make_unique<CullProgram>())
+{
+	_valid = _program->Link();
+	WARNING(!_valid, ("MeshletCuller: the culling shader did not link.\n" + _program->GetErrors()).c_str());
+	_draw_count.allocateImmutable(sizeof(GLuint), BufferFlags::DYNAMIC_STORAGE_BIT);
+}
+
+MeshletCuller::~MeshletCuller() {}
+
+const std::string& MeshletCuller::GetErrors() const
+{
+	return _program->GetErrors();
+}
+
+void MeshletCuller::Upload(const MeshletMesh& mesh, GLuint first_index, GLint base_vertex)
+{
+	std::vector<MeshletCullData> data(mesh.meshlets.size());
+	for (size_t i = 0; i < data.size(); ++i) {
+		const Meshlet& m = mesh.meshlets[i];
+		const MeshletBounds& b = mesh.bounds[i];
+		data[i] = { glm::vec4(b.center, b.radius), glm::vec4(b.cone_axis, b.cone_cutoff), first_index + 3 * m.triangle_offset, 3 * m.triangle_count, { 0, 0 } };
+	}
+	_meshlets.clear();
+	_meshlets.append(data);
+	_base_vertex = base_vertex;
+}
+
+void MeshletCuller::Cull(const Camera& camera, DrawElementsIndirectRecorder& recorder, const glm::mat4& world)
+{
+	const GLuint meshlet_count = static_cast<GLuint>(_meshlets.size());
+	ASSERT(recorder._ibo == GL_UNSIGNED_INT, "MeshletCuller: the meshlet indices are 32 bit.");
+	auto& draws = recorder.GetBuffer();
+	if (!_valid || meshlet_count == 0) {	// nothing to draw
+		draws.clear();
+		recorder.SetCountBuffer(0);
+		return;
+	}
+	draws.resize(meshlet_count);
+	recorder.SetCountBuffer(_draw_count, 0, static_cast<GLsizei>(meshlet_count));
+
+	glClearNamedBufferSubData(_draw_count, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	if (!recorder.UsesCountBuffer())	// every slot is drawn, so the tail has to be empty commands
+		glClearNamedBufferSubData(draws, GL_R32UI, 0, draws.getSizeInBytes(), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+	const glm::vec4 eye = glm::inverse(world) * glm::vec4(camera.GetEye(), 1);
+	*_program << "u_mvp" << camera.GetViewProj() * world << "u_eye" << glm::vec3(eye) / eye.w << "u_meshlet_count" << meshlet_count
+		<< "u_base_vertex" << _base_vertex << "u_cone_culling" << static_cast<GLuint>(_cone_culling);
+	_bindings.setBuffer(0, _meshlets.getBuffer(), 0, _meshlets.getSizeInBytes())
+		.setBuffer(BufferType::SHADER_STORAGE_BUFFER, 1, draws, 0, draws.getSizeInBytes())
+		.setBuffer(2, _draw_count);
+	_bindings.bind();
+	glDispatchCompute((meshlet_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+	// the draw reads the commands and the count (GL_PARAMETER_BUFFER) as indirect commands
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
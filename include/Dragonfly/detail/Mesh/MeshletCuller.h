@@ -0,0 +1,72 @@
+#pragma once
+#include "../../config.h"
+#include "Meshlet.h"
+#include "../Buffer/BindingTable.h"
+#include "../Vao/DrawIndirect.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+
+namespace df
+{
+
+class Camera;
+
+//One meshlet as the culling shader reads it (std430, 48 bytes)
+struct MeshletCullData
+{
+	glm::vec4	sphere;		// center, radius
+	glm::vec4	cone;		// axis, cutoff (see MeshletBounds)
+	GLuint		first_index;
+	GLuint		index_count;
+	GLuint		_pad[2];
+};
+
+// Culls meshlets against the camera frustum and their normal cones with a compute shader, and writes
+// the visible ones into a DrawElementsIndirectRecorder as a compacted list. The number of draws stays
+// on the GPU (SetCountBuffer), so there is no CPU side visibility work or readback at all.
+//	df::MeshletMesh meshlets = df::buildMeshlets(...);
+//	element_buffer.constructImmutable(meshlets.expandIndices());
+//	df::MeshletCuller culler;	culler.Upload(meshlets);
+//	df::DrawElementsIndirectRecorder draws(vao, GL_TRIANGLES);
+//	... every frame:
+//	culler.Cull(cam, draws, model);
+//	program << "model" << model << draws;
+// Without ARB_indirect_parameters every meshlet gets a command slot, the culled ones draw nothing.
+class MeshletCuller
+{
+public:
+	static constexpr GLuint WORKGROUP_SIZE = 64;
+
+	MeshletCuller();	//Compiles the culling shader, needs a GL context
+	~MeshletCuller();
+
+	MeshletCuller(const MeshletCuller&) = delete;
+	MeshletCuller& operator=(const MeshletCuller&) = delete;
+
+	//Replaces the meshlets. mesh.expandIndices() has to be in the element buffer from 'first_index' (counted in indices),
+	//'base_vertex' is added to every index (see VaoElements).
+	void Upload(const MeshletMesh& mesh, GLuint first_index = 0, GLint base_vertex = 0);
+
+	//Dispatches the culling for a mesh drawn with the 'world' matrix and points the recorder's commands and count at the result
+	void Cull(const Camera& camera, DrawElementsIndirectRecorder& recorder, const glm::mat4& world = glm::mat4(1));
+
+	//Frustum culling only when off (eg. for two sided materials)
+	void SetConeCulling(bool enabled) { _cone_culling = enabled; }
+
+	size_t Size() const { return _meshlets.size(); }
+	bool IsValid() const { return _valid; }
+	const std::string& GetErrors() const;
+
+private:
+	class CullProgram;
+	std::unique_ptr<CullProgram> _program;
+	eltecg::ogl::GpuVector<MeshletCullData, eltecg::ogl::BufferType::SHADER_STORAGE_BUFFER> _meshlets;
+	eltecg::ogl::ShaderStorageBuffer _draw_count;
+	eltecg::ogl::BindingTable _bindings;
+	GLint _base_vertex = 0;
+	bool _cone_culling = true;
+	bool _valid = false;
+};
+
+} //namespace df
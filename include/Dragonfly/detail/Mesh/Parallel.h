@@ -0,0 +1,33 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace df
+{
+namespace detail
+{
+
+//Calls job(i) for every i in [0, count) on up to 'threads' threads (0: hardware concurrency).
+//Jobs are handed out one by one, so uneven job sizes balance out. Runs inline for a single job.
+template<typename Job_T>
+void parallelFor(size_t count, Job_T&& job, unsigned threads = 0)
+{
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+	if (threads <= 1) {
+		for (size_t i = 0; i < count; ++i) job(i);
+		return;
+	}
+	std::atomic<size_t> next{ 0 };
+	auto worker = [&]() { for (size_t i = next++; i < count; i = next++) job(i); };
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+	for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+	worker();
+	for (std::thread& t : pool) t.join();
+}
+
+} //namespace detail
+} //namespace df
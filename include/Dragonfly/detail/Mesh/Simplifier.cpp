@@ -0,0 +1,296 @@
+#include "Simplifier.h"
+#include "IndexOptimizer.h"
+#include "../Events/Camera.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace df;
+
+namespace {
+
+//Sum of squared distances from weighted planes: p^T A p + 2 b^T p + c, A symmetric
+struct Quadric
+{
+	double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+	double b0 = 0, b1 = 0, b2 = 0, c = 0;
+	double weight = 0;	// area the error is averaged over
+
+	void addPlane(const glm::vec3& n, float d, double w) {
+		a00 += w * n.x * n.x;	a01 += w * n.x * n.y;	a02 += w * n.x * n.z;
+		a11 += w * n.y * n.y;	a12 += w * n.y * n.z;	a22 += w * n.z * n.z;
+		b0 += w * n.x * d;		b1 += w * n.y * d;		b2 += w * n.z * d;		c += w * d * d;
+	}
+	Quadric& operator+=(const Quadric& q) {
+		a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+		b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; weight += q.weight;
+		return *this;
+	}
+	double eval(const glm::vec3& p) const {
+		const double x = p.x, y = p.y, z = p.z;
+		return a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a01 * x * y + a02 * x * z + a12 * y * z)
+			+ 2 * (b0 * x + b1 * y + b2 * z) + c;
+	}
+};
+
+//Distance like error of moving the surface of 'q' to 'p'
+float quadricError(const Quadric& q, const glm::vec3& p)
+{
+	return static_cast<float>(std::sqrt(std::max(0.0, q.eval(p)) / std::max(q.weight, 1e-30)));
+}
+
+//Triangles around each vertex: triangles[offsets[v] .. offsets[v+1])
+struct Adjacency
+{
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> triangles;
+
+	Adjacency(const uint32_t* indices, size_t index_count, size_t vertex_count) : offsets(vertex_count + 1, 0), triangles(index_count)
+	{
+		for (size_t i = 0; i < index_count; ++i) ++offsets[indices[i] + 1];
+		for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] += offsets[v];
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < index_count; ++i) triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+};
+
+uint64_t edgeKey(uint32_t a, uint32_t b) { return (static_cast<uint64_t>(a) << 32) | b; }
+
+//Half-edge collapses in passes: each pass sorts the candidate edges by cost and collapses the cheapest
+//ones that do not touch a vertex changed in the same pass, then removes the degenerate triangles.
+struct Simplifier
+{
+	std::vector<uint32_t>	indices;
+	std::vector<glm::vec3>	positions;
+	std::vector<Quadric>	quadrics;
+	std::vector<bool>		locked;		// seam vertices
+	float					error = 0;	// largest collapse error so far
+
+	Simplifier(const uint32_t* indices_, size_t index_count, const float* positions_, size_t vertex_count, size_t stride)
+		: indices(indices_, indices_ + index_count), positions(vertex_count), quadrics(vertex_count), locked(vertex_count, false)
+	{
+		std::vector<bool> used(vertex_count, false);
+		for (uint32_t v : indices) used[v] = true;
+		for (size_t v = 0; v < vertex_count; ++v)
+			std::memcpy(&positions[v], reinterpret_cast<const char*>(positions_) + v * stride, 3 * sizeof(float));
+
+		// vertices at the same position are seams, they stay where they are
+		struct PositionHash { size_t operator()(const glm::vec3& p) const {
+			uint32_t bits[3];	std::memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		} };
+		struct PositionEqual { bool operator()(const glm::vec3& a, const glm::vec3& b) const { return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0; } };
+		std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> first_at;
+		first_at.reserve(vertex_count);
+		for (uint32_t v = 0; v < vertex_count; ++v) {
+			if (!used[v]) continue;
+			auto inserted = first_at.emplace(positions[v], v);
+			if (!inserted.second) locked[v] = locked[inserted.first->second] = true;
+		}
+
+		std::unordered_set<uint64_t> edges;
+		edges.reserve(index_count);
+		for (size_t i = 0; i < index_count; i += 3)
+			for (int k = 0; k < 3; ++k) edges.insert(edgeKey(indices[i + k], indices[i + (k + 1) % 3]));
+
+		for (size_t i = 0; i < index_count; i += 3) {
+			const uint32_t* t = &indices[i];
+			glm::vec3 n = glm::cross(positions[t[1]] - positions[t[0]], positions[t[2]] - positions[t[0]]);
+			const float area = glm::length(n);
+			if (area <= 0) continue;
+			n = n / area;
+			for (int k = 0; k < 3; ++k) {
+				quadrics[t[k]].addPlane(n, -glm::dot(n, positions[t[0]]), area);
+				quadrics[t[k]].weight += area;
+			}
+			// open borders get a plane perpendicular to the triangle, so collapses keep the outline
+			for (int k = 0; k < 3; ++k) {
+				const uint32_t a = t[k], b = t[(k + 1) % 3];
+				if (edges.count(edgeKey(b, a))) continue;
+				const glm::vec3 edge = positions[b] - positions[a];
+				const float length = glm::length(edge);
+				if (length <= 0) continue;
+				const glm::vec3 m = glm::normalize(glm::cross(edge, n));
+				quadrics[a].addPlane(m, -glm::dot(m, positions[a]), 10.0 * length * length);
+				quadrics[b].addPlane(m, -glm::dot(m, positions[a]), 10.0 * length * length);
+			}
+		}
+	}
+
+	size_t triangleCount() const { return indices.size() / 3; }
+
+	//Collapses until the index count is at most 'target_index_count' or the next collapse costs more than 'max_error'
+	void run(size_t target_index_count, float max_error)
+	{
+		const size_t vertex_count = positions.size();
+		std::vector<uint32_t> remap(vertex_count);
+		for (uint32_t v = 0; v < vertex_count; ++v) remap[v] = v;
+		std::vector<bool> border(vertex_count), touched(vertex_count);
+		std::unordered_set<uint64_t> edges;
+		struct Collapse { uint32_t from, to; float cost; };
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> from_ring, to_ring;
+
+		while (indices.size() > target_index_count)
+		{
+			edges.clear();
+			edges.reserve(indices.size());
+			for (size_t i = 0; i < indices.size(); i += 3)
+				for (int k = 0; k < 3; ++k) edges.insert(edgeKey(indices[i + k], indices[i + (k + 1) % 3]));
+			auto isBorderEdge = [&](uint32_t a, uint32_t b) { return !edges.count(edgeKey(a, b)) || !edges.count(edgeKey(b, a)); };
+			std::fill(border.begin(), border.end(), false);
+			for (size_t i = 0; i < indices.size(); i += 3)
+				for (int k = 0; k < 3; ++k) {
+					const uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+					if (!edges.count(edgeKey(b, a))) border[a] = border[b] = true;
+				}
+
+			// a border vertex may only slide along its border
+			auto allowed = [&](uint32_t from, uint32_t to) { return !locked[from] && (!border[from] || isBorderEdge(from, to)); };
+			auto cost = [&](uint32_t from, uint32_t to) { Quadric q = quadrics[from]; q += quadrics[to]; return quadricError(q, positions[to]); };
+			collapses.clear();
+			for (size_t i = 0; i < indices.size(); i += 3)
+				for (int k = 0; k < 3; ++k) {
+					const uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+					if (a > b && edges.count(edgeKey(b, a))) continue;	// inner edges are listed from both sides
+					const float ab = allowed(a, b) ? cost(a, b) : INFINITY;
+					const float ba = allowed(b, a) ? cost(b, a) : INFINITY;
+					if (ab == INFINITY && ba == INFINITY) continue;
+					collapses.push_back(ab <= ba ? Collapse{ a, b, ab } : Collapse{ b, a, ba });
+				}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+			const Adjacency adjacency(indices.data(), indices.size(), vertex_count);
+			std::fill(touched.begin(), touched.end(), false);
+			const size_t to_remove = (indices.size() - target_index_count + 2) / 3;
+			size_t removed = 0, applied = 0;
+			for (const Collapse& c : collapses)
+			{
+				if (c.cost > max_error) break;
+				if (touched[c.from] || touched[c.to]) continue;
+				// the triangles that stay must not flip or turn by more than ~75 degrees
+				bool flips = false;
+				size_t vanishing = 0;
+				for (uint32_t i = adjacency.offsets[c.from]; i < adjacency.offsets[c.from + 1] && !flips; ++i) {
+					const uint32_t* t = &indices[3 * adjacency.triangles[i]];
+					const uint32_t v[3] = { remap[t[0]], remap[t[1]], remap[t[2]] };
+					if (v[0] == c.to || v[1] == c.to || v[2] == c.to) { ++vanishing; continue; }
+					glm::vec3 p[3] = { positions[v[0]], positions[v[1]], positions[v[2]] };
+					const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+					for (int k = 0; k < 3; ++k) if (v[k] == c.from) p[k] = positions[c.to];
+					const glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+					flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+				}
+				if (flips) continue;
+				// link condition: the two vertices may only share the neighbours of the vanishing triangles, otherwise the surface folds
+				auto gatherNeighbours = [&](uint32_t v, std::vector<uint32_t>& out) {
+					out.clear();
+					for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; ++i)
+						for (int k = 0; k < 3; ++k) {
+							const uint32_t w = remap[indices[3 * adjacency.triangles[i] + k]];
+							if (w != c.from && w != c.to) out.push_back(w);
+						}
+					std::sort(out.begin(), out.end());
+					out.erase(std::unique(out.begin(), out.end()), out.end());
+				};
+				gatherNeighbours(c.from, from_ring);
+				gatherNeighbours(c.to, to_ring);
+				size_t shared = 0;
+				for (size_t i = 0, j = 0; i < from_ring.size() && j < to_ring.size(); )
+					if (from_ring[i] < to_ring[j]) ++i; else if (to_ring[j] < from_ring[i]) ++j; else { ++shared; ++i; ++j; }
+				if (shared > vanishing) continue;
+				remap[c.from] = c.to;
+				touched[c.from] = touched[c.to] = true;
+				quadrics[c.to] += quadrics[c.from];
+				error = std::max(error, c.cost);
+				++applied;
+				if ((removed += vanishing) >= to_remove) break;
+			}
+			if (applied == 0) break;
+
+			size_t write = 0;
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				const uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+				if (a == b || b == c || c == a) continue;
+				indices[write++] = a;	indices[write++] = b;	indices[write++] = c;
+			}
+			indices.resize(write);
+			for (uint32_t v = 0; v < vertex_count; ++v) remap[v] = v;
+		}
+	}
+};
+
+} //namespace
+
+/****************************************************************************
+ *						Simplification										*/
+
+size_t df::simplifyMesh(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+	size_t position_stride, size_t target_index_count, float max_error, float* result_error)
+{
+	ASSERT(index_count % 3 == 0, "simplifyMesh: the index count has to be a multiple of 3.");
+	Simplifier simplifier(indices, index_count, positions, vertex_count, position_stride);
+	simplifier.run(target_index_count, max_error);
+	std::copy(simplifier.indices.begin(), simplifier.indices.end(), dst);
+	if (result_error) *result_error = simplifier.error;
+	return simplifier.indices.size();
+}
+
+/****************************************************************************
+ *						LOD chain											*/
+
+LodChain df::buildLodChain(const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+	size_t position_stride, const LodSettings& settings)
+{
+	ASSERT(index_count % 3 == 0, "buildLodChain: the index count has to be a multiple of 3.");
+	LodChain chain;
+	if (index_count == 0) return chain;
+
+	auto addLevel = [&](const std::vector<uint32_t>& level, float error) {
+		const uint32_t first = static_cast<uint32_t>(chain.indices.size());
+		chain.indices.insert(chain.indices.end(), level.begin(), level.end());
+		if (settings.optimize_vertex_cache)
+			optimizeVertexCache(&chain.indices[first], &chain.indices[first], level.size(), vertex_count);
+		chain.levels.push_back({ first, static_cast<uint32_t>(level.size()), error });
+	};
+
+	// the levels are snapshots of one simplification, so the errors are measured from the original
+	Simplifier simplifier(indices, index_count, positions, vertex_count, position_stride);
+	addLevel(simplifier.indices, 0);
+	for (float ratio : settings.ratios) {
+		const size_t target = 3 * static_cast<size_t>(ratio * (index_count / 3));
+		simplifier.run(target, settings.max_error);
+		if (simplifier.indices.size() >= chain.levels.back().index_count || simplifier.indices.empty()) break;
+		addLevel(simplifier.indices, simplifier.error);
+	}
+
+	glm::vec3 lo(INFINITY), hi(-INFINITY);
+	for (size_t i = 0; i < index_count; ++i) {
+		lo = glm::min(lo, simplifier.positions[indices[i]]);	hi = glm::max(hi, simplifier.positions[indices[i]]);
+	}
+	chain.center = 0.5f * (lo + hi);
+	for (size_t i = 0; i < index_count; ++i)
+		chain.radius = std::max(chain.radius, glm::length(simplifier.positions[indices[i]] - chain.center));
+	return chain;
+}
+
+size_t LodChain::selectLevel(Camera& camera, const glm::mat4& world, float max_pixel_error) const
+{
+	if (levels.empty()) return 0;
+	const glm::vec4 center_world = world * glm::vec4(center, 1);
+	const float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])) });
+	// distance to the closest point of the bounding sphere, and the size of one pixel there
+	const float distance = std::max(glm::length(glm::vec3(center_world) / center_world.w - camera.GetEye()) - radius * scale, camera.GetNearFarClips().x);
+	const float pixel_size = distance * camera.GetTanPixelFow();
+	size_t level = 0;
+	while (level + 1 < levels.size() && levels[level + 1].error * scale <= max_pixel_error * pixel_size) ++level;
+	return level;
+}
+
+VaoElements LodChain::draw(GLuint vao, size_t level, GLuint first_index, GLint base_vertex, GLenum mode) const
+{
+	ASSERT(level < levels.size(), "LodChain: invalid level.");
+	return VaoElements(vao, mode, static_cast<GLsizei>(levels[level].index_count), GL_UNSIGNED_INT, 1, 0, first_index + levels[level].first_index, base_vertex);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "../../config.h"
+#include "../Vao/Vao.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <cfloat>
+#include <vector>
+
+namespace df
+{
+
+class Camera;
+
+/****************************************************************************
+ *						Simplification and LOD chains						*
+ ****************************************************************************/
+// Quadric error (Garland-Heckbert) edge collapses that only produce a new index list: every vertex of the
+// result is an original vertex, so all the levels of detail can share one vertex buffer.
+// Vertices that share their position with another vertex (uv or normal seams) are kept in place, so the
+// seams do not open up. Open borders only collapse along themselves.
+//	df::LodChain lods = df::buildLodChain(indices.data(), indices.size(), &vertices[0].pos.x, vertices.size(), sizeof(Vertex));
+//	element_buffer.constructImmutable(lods.indices);	// every level one after the other
+//	... per draw:
+//	program << "model" << model << lods.draw(vao, lods.selectLevel(cam, model));
+
+//Simplifies until 'target_index_count' or until the next collapse would move the surface more than 'max_error'
+//(object space distance). Returns the new index count, 'dst' needs room for 'index_count' indices and may be 'indices'.
+size_t simplifyMesh(uint32_t* dst, const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+	size_t position_stride, size_t target_index_count, float max_error = FLT_MAX, float* result_error = nullptr);
+
+struct LodLevel
+{
+	uint32_t	first_index;	// in LodChain::indices
+	uint32_t	index_count;
+	float		error;			// object space distance from the original surface
+};
+
+struct LodSettings
+{
+	std::vector<float>	ratios = { 0.5f, 0.25f, 0.125f, 0.0625f };	// target triangle counts of the levels after the original
+	float				max_error = FLT_MAX;		// levels stop here, so there can be fewer levels than ratios
+	bool				optimize_vertex_cache = true;
+};
+
+struct LodChain
+{
+	std::vector<uint32_t>	indices;	// every level, the finest (the original) first
+	std::vector<LodLevel>	levels;
+	glm::vec3				center = glm::vec3(0);	// bounding sphere of the mesh
+	float					radius = 0;
+
+	//The coarsest level whose error is at most 'max_pixel_error' pixels on the screen when drawn with 'world'
+	size_t selectLevel(Camera& camera, const glm::mat4& world = glm::mat4(1), float max_pixel_error = 1) const;
+	//Draw of one level, 'first_index' is where 'indices' starts in the element buffer
+	VaoElements draw(GLuint vao, size_t level, GLuint first_index = 0, GLint base_vertex = 0, GLenum mode = GL_TRIANGLES) const;
+};
+
+LodChain buildLodChain(const uint32_t* indices, size_t index_count, const float* positions, size_t vertex_count,
+	size_t position_stride, const LodSettings& settings = LodSettings());
+
+} //namespace df
@@ -1,4 +1,6 @@
 #include "Program.inl"
+#include "ProgramCache.h"
+#include <algorithm>
 #include <vector>
 
 using namespace df;
@@ -30,13 +32,18 @@ ProgramLowLevelBase::ProgramLowLevelBase()
 }
 
 ProgramLowLevelBase::~ProgramLowLevelBase(){
+	cancelAsyncLink();
+	unwatchFiles();
 	if (program_id != 0)
 		glDeleteProgram(program_id);
 }
 
 ProgramLowLevelBase::ProgramLowLevelBase(ProgramLowLevelBase && rhs)
 {
+	rhs.cancelAsyncLink();	// the poll callback belongs to rhs
+	rhs.unwatchFiles();		// so does the reload callback, this one subscribes on its next Link
 	program_id = rhs.program_id;
+	linked_sources = rhs.linked_sources;
 	error_msg = std::move(rhs.error_msg);
 
 	rhs.program_id = 0;
@@ -46,8 +53,13 @@ ProgramLowLevelBase & ProgramLowLevelBase::operator=(ProgramLowLevelBase && rhs)
 {
 	if (&rhs == this)
 		return *this;
+	cancelAsyncLink();
+	rhs.cancelAsyncLink();
+	unwatchFiles();
+	rhs.unwatchFiles();
 
 	program_id = rhs.program_id;
+	linked_sources = rhs.linked_sources;
 	error_msg = std::move(rhs.error_msg);
 
 	rhs.program_id = 0;
@@ -58,3 +70,112 @@ ProgramLowLevelBase & ProgramLowLevelBase::operator=(ProgramLowLevelBase && rhs)
 const std::string& ProgramLowLevelBase::getErrors() const {
 	return error_msg;
 }
+
+void ProgramLowLevelBase::watchFiles(FileWatcher::Callback&& reload)
+{
+	if (watching) return;
+	FileWatcher::Subscribe(this, std::move(reload));
+	watching = true;
+}
+
+void ProgramLowLevelBase::unwatchFiles()
+{
+	if (watching) FileWatcher::Unsubscribe(this);
+	watching = false;
+}
+
+bool ProgramLowLevelBase::isAttached(GLuint program, GLuint shader)
+{
+	GLuint attached[6];
+	GLsizei count = 0;
+	glGetAttachedShaders(program, 6, &count, attached);
+	return std::find(attached, attached + count, shader) != attached + count;
+}
+
+GLuint ProgramLowLevelBase::beginAsyncLink(std::function<void()>&& poll, uint64_t sources, uint64_t cache_key)
+{
+	static bool threads_set = false;
+	if (!threads_set && GLEW_KHR_parallel_shader_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);	// as many as the driver likes
+	threads_set = true;
+
+	cancelAsyncLink();
+	pending_program_id = glCreateProgram();
+	pending_sources = sources;
+	pending_cache_key = cache_key;
+	pending_start = std::chrono::steady_clock::now();
+	// the executable is moved into program_id with glGetProgramBinary when it is done
+	glProgramParameteri(pending_program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	s_async_links()[this] = std::move(poll);
+	return pending_program_id;
+}
+
+bool ProgramLowLevelBase::isAsyncLinkDone() const
+{
+	if (pending_program_id == 0 || !GLEW_KHR_parallel_shader_compile) return true;
+	GLint done = GL_FALSE;
+	glGetProgramiv(pending_program_id, GL_COMPLETION_STATUS_KHR, &done);
+	return done == GL_TRUE;
+}
+
+bool ProgramLowLevelBase::adoptAsyncLink()
+{
+	ASSERT(pending_program_id != 0, "No pending link.");
+	GLint linked = GL_FALSE, loglen = 0, errlen = 0;
+	glGetProgramiv(pending_program_id, GL_LINK_STATUS, &linked);
+	glGetProgramiv(pending_program_id, GL_INFO_LOG_LENGTH, &loglen);
+	if (loglen > 1) {
+		std::vector<char> error_message(loglen);
+		glGetProgramInfoLog(pending_program_id, loglen, &errlen, error_message.data());
+		this->error_msg.append(error_message.data(), error_message.data() + errlen);
+	}
+	bool adopted = false;
+	if (linked == GL_TRUE) {
+		linked_sources = 0;	// both ways below replace the live executable
+		GLint length = 0;
+		glGetProgramiv(pending_program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length > 0) {	// a single call replaces the executable, the previous one is used until here
+			std::vector<char> binary(length);
+			GLenum format = 0;
+			glGetProgramBinary(pending_program_id, length, &length, &format, binary.data());
+			glProgramBinary(program_id, format, binary.data(), length);
+			GLint result = GL_FALSE;
+			glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+			adopted = result == GL_TRUE;
+		}
+		if (!adopted) {	// no binary formats: relink the live program from the already compiled shaders
+			GLuint shaders[6];
+			GLsizei count = 0;
+			glGetAttachedShaders(pending_program_id, 6, &count, shaders);
+			for (GLsizei i = 0; i < count; ++i)
+				if (!isAttached(program_id, shaders[i])) glAttachShader(program_id, shaders[i]);
+			adopted = link();
+		}
+		if (adopted) linked_sources = pending_sources;
+		if (adopted && pending_cache_key != 0)
+			ProgramCache::Store(pending_program_id, pending_cache_key,
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pending_start).count());
+	}
+	cancelAsyncLink();
+	return adopted;
+}
+
+void ProgramLowLevelBase::cancelAsyncLink()
+{
+	if (pending_program_id != 0) glDeleteProgram(pending_program_id);
+	pending_program_id = 0;
+	pending_sources = 0;
+	pending_cache_key = 0;
+	s_async_links().erase(this);
+}
+
+void ProgramLowLevelBase::PollAsyncLinks()
+{
+	auto& links = s_async_links();
+	for (auto it = links.begin(); it != links.end();) {
+		auto next = std::next(it);	// a finished poll erases its own entry, so it runs from a copy
+		const std::function<void()> poll = it->second;
+		poll();
+		it = next;
+	}
+}
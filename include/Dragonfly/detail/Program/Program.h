@@ -3,6 +3,7 @@
 #include <string>
 #include <deque>
 #include "../Vao/Vao.h"
+#include "../Vao/DrawIndirect.h"
 #include "../Program/ProgramFwd.h"
 #include "../Shader/Shader.h"
 #include "../Uniform/Subroutines.h"
@@ -25,6 +26,13 @@ public:
 	~Program() = default;
 
 	bool Link();
+	//Submits the compiles and the link without waiting for them, the program is swapped in by the first PollLink after the
+	//driver finished (df::Sample::Run polls every frame). Draws keep using the previous program until then.
+	//Errors show up in GetErrors after the swap would have happened. Without KHR_parallel_shader_compile the first poll waits.
+	bool LinkAsync();
+	//Finishes a LinkAsync if the driver is done (or 'wait'), returns false while it is still in progress
+	bool PollLink(bool wait = false);
+	bool IsLinking() const { return this->pending_program_id != 0; }
 	const std::string& GetErrors() const { return this->getErrors(); }
 	
 	//For pushing uniforms
@@ -33,6 +41,9 @@ public:
 	//For rendering
 	Program& operator << (const VaoElements& vao);
 	Program& operator << (const VaoArrays& vao);
+	//Uploads the recorded commands if needed and issues a single glMultiDraw*Indirect
+	template<typename Command_T>
+	Program& operator << (DrawIndirectRecorder<Command_T>& recorder);
 
 	//For adding shader files. Same types will concatenate.
 	LoadState& operator << (const detail::_CompShader& s){ return (this->load_state << s); }
@@ -41,6 +52,7 @@ public:
 	LoadState& operator << (const detail::_GeomShader& s){ return (this->load_state << s); }
 	LoadState& operator << (const detail::_TescShader& s){ return (this->load_state << s); }
 	LoadState& operator << (const detail::_TeseShader& s){ return (this->load_state << s); }
+	LoadState& operator << (const detail::_GeneratedShader& s){ return (this->load_state << s); }
 
 	//Compile shaders and Link the program
 	LoadState& operator << (const typename LoadState::LinkType link) { return (this->load_state << link); }
@@ -56,6 +68,12 @@ protected:
 	typename Shaders_T::TesE tese;
 	std::string program_name;
 	Subroutines_T subroutines;
+private:
+	uint64_t assembleSources();		// hash of every stage's assembled source
+	void submitCompiles();
+	bool finishCompiles();
+	bool compileInterface();		// uniforms and subroutines after a link
+	void reloadFiles(const std::vector<std::string>& changed);	// FileWatcher callback: reloads and relinks with LinkAsync
 };
 
 } //namespace df
@@ -51,6 +51,11 @@ struct NoShader {
 	constexpr GLuint getID() const { return 0; }
 	constexpr const char* GetErrors() const { return ""; }
 	constexpr bool Compile() { return true; }
+	constexpr bool CompileAsync() { return false; }
+	constexpr bool FinishCompile() { return true; }
+	constexpr void Assemble() {}
+	constexpr uint64_t GetSourceHash(uint64_t seed = 0) const { return seed; }
+	constexpr bool Reload(const std::vector<std::string>&) { return false; }
 	void Render(std::string program_name = "default") {}
 	constexpr void Update() {}
 };
@@ -149,6 +154,15 @@ Program<Shaders_T, Uni_T, Subroutines_T>& Program<Shaders_T, Uni_T, Subroutines_
 	return *this;
 }
 
+template<typename Shaders_T, typename Uni_T, typename Subroutines_T>
+template<typename Command_T>
+Program<Shaders_T, Uni_T, Subroutines_T>& Program<Shaders_T, Uni_T, Subroutines_T>::operator<<(DrawIndirectRecorder<Command_T>& recorder)
+{
+	subroutines.SetSubroutines();
+	this->draw(recorder);
+	return *this;
+}
+
 } //namespace df
 
 #include "ProgramCompile.inl"
@@ -2,7 +2,13 @@
 #include "ProgramFwd.h"
 #include "../Framebuffer/FramebufferBase.h"
 #include "../Vao/Vao.h"
+#include "../Vao/DrawIndirect.h"
+#include "../File/FileWatcher.h"
 #include <GL/glew.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <string>
 
 namespace df
@@ -31,28 +37,90 @@ namespace df
 		ProgramLowLevelBase& operator=(ProgramLowLevelBase&& rhs);
 
 		template<typename Shader_t>
-		void attachShader(const Shader_t& sh) {
-			if (sh.getID() != 0) glAttachShader(program_id, sh.getID());
+		void attachShader(const Shader_t& sh, GLuint program = 0) {
+			if (program == 0) program = program_id;
+			if (sh.getID() != 0 && !isAttached(program, sh.getID())) glAttachShader(program, sh.getID());
 		}
+		static bool isAttached(GLuint program, GLuint shader);
+
+		//assembleSources of the executable in program_id (0: none), a Link with the same sources does nothing
+		uint64_t linked_sources = 0;
+
+		//LinkAsync links a second program object, program_id keeps the previous executable until it is done
+		GLuint pending_program_id = 0;
+		uint64_t pending_sources = 0;
+		uint64_t pending_cache_key = 0;		// 0: not cached
+		std::chrono::steady_clock::time_point pending_start;
+		//Creates the pending program (shaders are attached by the caller) and registers 'poll' for PollAsyncLinks
+		GLuint beginAsyncLink(std::function<void()>&& poll, uint64_t sources, uint64_t cache_key);
+		//True if the driver finished the pending link (always true without KHR_parallel_shader_compile)
+		bool isAsyncLinkDone() const;
+		//Moves the pending executable into program_id if it linked, then deletes the pending program
+		bool adoptAsyncLink();
+		void cancelAsyncLink();
+		static std::map<const ProgramLowLevelBase*, std::function<void()>>& s_async_links() {
+			static std::map<const ProgramLowLevelBase*, std::function<void()>> links; return links;
+		}
+		//Subscribes 'reload' to the FileWatcher once, the first Link does it so only linked programs are reloaded
+		bool watching = false;
+		void watchFiles(FileWatcher::Callback&& reload);
+		void unwatchFiles();
 		FramebufferBase framebuffer;
 
 		inline void draw(const VaoElements& vao);
 		inline void draw(const VaoArrays& vao);
+		template<typename Command_T>
+		inline void draw(DrawIndirectRecorder<Command_T>& recorder);
 
 	public:
 		struct LinkType {};	//contains nothing at all
 		const std::string& getErrors() const;
+
+		//Finishes the LinkAsync calls the driver is done with (called by df::Sample::Run at the beginning of each frame)
+		static void PollAsyncLinks();
+		static size_t GetAsyncLinkCount() { return s_async_links().size(); }
 	};
 
 	inline void ProgramLowLevelBase::draw(const VaoArrays& vao)
 	{
 		framebuffer.bind();	this->bind(); vao.bind();
-		glDrawArrays(vao._mode, vao._first, vao._count);
+		if (vao.isInstanced())
+			glDrawArraysInstancedBaseInstance(vao._mode, vao._first, vao._count, vao._instance_count, vao._base_instance);
+		else
+			glDrawArrays(vao._mode, vao._first, vao._count);
 	}
 	inline void ProgramLowLevelBase::draw(const VaoElements& vao)
 	{
 		framebuffer.bind();	this->bind(); vao.bind();
-		glDrawElements(vao._mode, vao._count, vao._ibo, nullptr);
+		if (vao.isInstanced())
+			glDrawElementsInstancedBaseVertexBaseInstance(vao._mode, vao._count, vao._ibo, vao.indexOffset(), vao._instance_count, vao._base_vertex, vao._base_instance);
+		else if (vao._base_vertex != 0)
+			glDrawElementsBaseVertex(vao._mode, vao._count, vao._ibo, vao.indexOffset(), vao._base_vertex);
+		else
+			glDrawElements(vao._mode, vao._count, vao._ibo, vao.indexOffset());
+	}
+
+	template<typename Command_T>
+	inline void ProgramLowLevelBase::draw(DrawIndirectRecorder<Command_T>& recorder)
+	{
+		recorder.Upload();
+		if (recorder.Empty() && !recorder.UsesCountBuffer()) return;
+		framebuffer.bind();	this->bind(); glBindVertexArray(recorder._vao);
+		recorder.GetBuffer().bindBuffer();
+		const GLsizei draw_count = static_cast<GLsizei>(recorder.Size());
+		if (recorder.UsesCountBuffer())
+		{
+			glBindBuffer(GL_PARAMETER_BUFFER_ARB, recorder._count_buffer);
+			const GLsizei max_draw_count = recorder._max_draw_count > 0 ? recorder._max_draw_count : draw_count;
+			if constexpr (DrawIndirectRecorder<Command_T>::IS_ELEMENTS)
+				glMultiDrawElementsIndirectCountARB(recorder._mode, recorder._ibo, nullptr, recorder._count_offset, max_draw_count, 0);
+			else
+				glMultiDrawArraysIndirectCountARB(recorder._mode, nullptr, recorder._count_offset, max_draw_count, 0);
+		}
+		else if constexpr (DrawIndirectRecorder<Command_T>::IS_ELEMENTS)
+			glMultiDrawElementsIndirect(recorder._mode, recorder._ibo, nullptr, draw_count, 0);
+		else
+			glMultiDrawArraysIndirect(recorder._mode, nullptr, draw_count, 0);
 	}
 
 } //namespace df
@@ -0,0 +1,166 @@
+#include "ProgramCache.h"
+#include "../File/Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace df;
+
+namespace {
+
+struct ProgramCacheHeader
+{
+	static constexpr uint32_t VERSION = 1;
+	char		magic[8];		// "DFPROG" and zeros
+	uint32_t	version;
+	uint32_t	format;			// binary format of glGetProgramBinary
+	uint64_t	key;			// the full key, the file name may collide
+	uint64_t	size;			// of the binary after the header
+	uint64_t	binary_hash;	// hashBytes of the binary, truncated files are not handed to the driver
+};
+
+const char cache_magic[8] = { 'D', 'F', 'P', 'R', 'O', 'G', 0, 0 };
+
+std::string glString(GLenum name)
+{
+	const GLubyte* str = glGetString(name);
+	return str ? reinterpret_cast<const char*>(str) : "";
+}
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} //namespace
+
+std::string ProgramCacheStats::ToString() const
+{
+	char str[256];
+	snprintf(str, sizeof(str), "Program cache: %zu hits (%.1f ms), %zu misses, %zu rejected, %zu stored (%.1f ms compiling)\n",
+		hits, load_ms, misses, rejected, stored, compile_ms);
+	return str;
+}
+
+void ProgramCache::Configure(const ProgramCacheSettings& settings)
+{
+	s_settings() = settings;
+	s_driver_hash() = 0;
+}
+
+bool ProgramCache::IsEnabled()
+{
+	if (!s_settings().enabled) return false;
+	if (s_format_count() < 0) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+		s_format_count() = count;
+	}
+	return s_format_count() > 0;
+}
+
+uint64_t ProgramCache::GetKey(uint64_t sources_hash)
+{
+	if (s_driver_hash() == 0) {
+		uint64_t hash = hashString(glString(GL_VENDOR));
+		hash = hashString(glString(GL_RENDERER), hash);
+		hash = hashString(glString(GL_VERSION), hash);
+		hash = hashString(glString(GL_SHADING_LANGUAGE_VERSION), hash);
+		s_driver_hash() = hashString(s_settings().defines, hash) | 1;	// never 0
+	}
+	return hashBytes(&sources_hash, sizeof(sources_hash), s_driver_hash());
+}
+
+std::string ProgramCache::GetCachePath(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.dfprog", static_cast<unsigned long long>(key));
+	return (std::filesystem::path(s_settings().directory) / name).generic_string();
+}
+
+bool ProgramCache::Load(GLuint program, uint64_t key)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const std::string path = GetCachePath(key);
+	std::error_code error;
+	const uint64_t file_size = std::filesystem::file_size(path, error);
+	std::ifstream in(path, std::ifstream::binary);
+	if (error || !in.is_open()) { ++s_stats().misses; return false; }
+
+	ProgramCacheHeader header;
+	std::vector<char> binary;
+	bool valid = file_size >= sizeof(header) && in.read(reinterpret_cast<char*>(&header), sizeof(header)).good()
+		&& std::equal(cache_magic, cache_magic + 8, header.magic) && header.version == ProgramCacheHeader::VERSION
+		&& header.key == key && header.size == file_size - sizeof(header);
+	if (valid) {
+		binary.resize(header.size);
+		valid = in.read(binary.data(), binary.size()).good() && hashBytes(binary.data(), binary.size()) == header.binary_hash;
+	}
+	in.close();
+	GLint linked = GL_FALSE;
+	if (valid) {
+		glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	}
+	if (linked == GL_FALSE) {
+		// stale or broken, it is replaced after the program compiles
+		std::filesystem::remove(path, error);
+		++s_stats().rejected;
+		++s_stats().misses;
+		return false;
+	}
+	++s_stats().hits;
+	s_stats().load_ms += msSince(start);
+	return true;
+}
+
+void ProgramCache::PrepareLink(GLuint program)
+{
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ProgramCache::Store(GLuint program, uint64_t key, double compile_ms)
+{
+	s_stats().compile_ms += compile_ms;
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return false;
+
+	ProgramCacheHeader header = {};
+	std::copy(cache_magic, cache_magic + 8, header.magic);
+	header.version = ProgramCacheHeader::VERSION;
+	header.key = key;
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+	binary.resize(length);
+	header.format = format;
+	header.size = binary.size();
+	header.binary_hash = hashBytes(binary.data(), binary.size());
+
+	// written next to the cache and renamed, so an interrupted write never leaves a broken binary behind
+	const std::string path = GetCachePath(key);
+	const std::string temp_path = path + ".tmp";
+	std::error_code error;
+	std::filesystem::create_directories(s_settings().directory, error);
+	bool written = false;
+	{
+		std::ofstream out(temp_path, std::ofstream::binary | std::ofstream::trunc);
+		if (out.is_open()) {
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(binary.data(), binary.size());
+			written = out.good();
+		}
+	}
+	if (written) {
+		std::filesystem::rename(temp_path, path, error);
+		written = !error;
+	}
+	if (!written) std::filesystem::remove(temp_path, error);
+	WARNING(!written, ("ProgramCache: could not write " + path).c_str());
+	s_stats().stored += written;
+	return written;
+}
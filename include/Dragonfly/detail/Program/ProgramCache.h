@@ -0,0 +1,70 @@
+#pragma once
+#include "../../config.h"
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+
+namespace df
+{
+
+/****************************************************************************
+ *						Program binary cache								*
+ ****************************************************************************/
+// Program::Link keys every program by the hash of its assembled sources, the driver (GL vendor, renderer and version
+// strings) and the defines of the settings. A linked program is stored with glGetProgramBinary, the next launch
+// restores it with glProgramBinary and skips compiling and linking. A binary the driver rejects (eg. after a driver
+// update with the same version string) is deleted and the program is compiled from source.
+//	df::ProgramCache::Configure({ "shader_cache", "#define QUALITY 2" });	// optional, before the first Link
+//	program << "a.vert"_vert << "a.frag"_frag << df::LinkProgram;		// uses the cache
+//	std::cout << df::ProgramCache::GetStats().ToString();
+// Does nothing if the driver supports no binary formats.
+
+struct ProgramCacheSettings
+{
+	std::string	directory = "shader_cache";	// created on the first store
+	std::string	defines;					// anything else that changes the compiled code, it is part of the key
+	bool		enabled = true;
+};
+
+struct ProgramCacheStats
+{
+	size_t hits = 0;		// restored from a binary
+	size_t misses = 0;		// no binary, compiled from source
+	size_t rejected = 0;	// a binary was found, but the driver did not accept it
+	size_t stored = 0;
+	double load_ms = 0;		// time spent restoring the hits
+	double compile_ms = 0;	// time spent compiling and linking the stored misses
+	std::string ToString() const;
+};
+
+class ProgramCache
+{
+public:
+	ProgramCache() = delete;
+
+	static void Configure(const ProgramCacheSettings& settings);
+	static const ProgramCacheSettings& GetSettings() { return s_settings(); }
+	//False if disabled or the driver has no program binary formats
+	static bool IsEnabled();
+
+	//The key of a program whose stages hash to 'sources_hash' (see ShaderLowLevelBase::GetSourceHash)
+	static uint64_t GetKey(uint64_t sources_hash);
+	//glProgramBinary of the cached binary, true if the program is linked from it
+	static bool Load(GLuint program, uint64_t key);
+	//Call before glLinkProgram so the driver keeps the binary
+	static void PrepareLink(GLuint program);
+	//Stores the binary of a successfully linked program, 'compile_ms' is only used for the statistics
+	static bool Store(GLuint program, uint64_t key, double compile_ms = 0);
+	static std::string GetCachePath(uint64_t key);
+
+	static const ProgramCacheStats& GetStats() { return s_stats(); }
+	static void ResetStats() { s_stats() = ProgramCacheStats(); }
+
+private:
+	static ProgramCacheSettings& s_settings() { static ProgramCacheSettings settings; return settings; }
+	static ProgramCacheStats& s_stats() { static ProgramCacheStats stats; return stats; }
+	static uint64_t& s_driver_hash() { static uint64_t hash = 0; return hash; }	// GL strings and defines, 0: not queried yet
+	static int& s_format_count() { static int count = -1; return count; }		// -1: not queried yet
+};
+
+} //namespace df
@@ -1,6 +1,8 @@
 #pragma once
 #include "../../config.h"
 #include "../Program/Program.h"
+#include "ProgramCache.h"
+#include <chrono>
 
 // ========================= Program Base Classes ==============================
 
@@ -33,6 +35,7 @@ public:
 	LoadState& operator << (const detail::_GeomShader& s);
 	LoadState& operator << (const detail::_TescShader& s);
 	LoadState& operator << (const detail::_TeseShader& s);
+	LoadState& operator << (const detail::_GeneratedShader& s);
 	LoadState& operator << (const ProgramLowLevelBase::LinkType &andCompile);
 private:
 	LoadState(Prog&that) : that(that) {}
@@ -101,44 +104,129 @@ inline typename Program<S, U, R>::LoadState& Program<S, U, R>::LoadState::operat
 	return *this;
 }
 template<typename S, typename U, typename R>
+inline typename Program<S, U, R>::LoadState& Program<S, U, R>::LoadState::operator<<(const detail::_GeneratedShader & s) {
+	bool added = true;
+	switch (s.stage) {
+	case GL_COMPUTE_SHADER:			if constexpr (!std::is_same_v<typename S::Comp, NoShader>) that.comp.AddSource(s.name, s.code, s.version); else added = false; break;
+	case GL_FRAGMENT_SHADER:		if constexpr (!std::is_same_v<typename S::Frag, NoShader>) that.frag.AddSource(s.name, s.code, s.version); else added = false; break;
+	case GL_VERTEX_SHADER:			if constexpr (!std::is_same_v<typename S::Vert, NoShader>) that.vert.AddSource(s.name, s.code, s.version); else added = false; break;
+	case GL_GEOMETRY_SHADER:		if constexpr (!std::is_same_v<typename S::Geom, NoShader>) that.geom.AddSource(s.name, s.code, s.version); else added = false; break;
+	case GL_TESS_CONTROL_SHADER:	if constexpr (!std::is_same_v<typename S::TesC, NoShader>) that.tesc.AddSource(s.name, s.code, s.version); else added = false; break;
+	case GL_TESS_EVALUATION_SHADER:	if constexpr (!std::is_same_v<typename S::TesE, NoShader>) that.tese.AddSource(s.name, s.code, s.version); else added = false; break;
+	default: added = false;
+	}
+	ASSERT(added, ("Program: the program has no stage for the generated shader " + s.name).c_str());
+	return *this;
+}
+template<typename S, typename U, typename R>
 inline typename Program<S, U, R>::LoadState& Program<S, U, R>::LoadState::operator<<(const ProgramLowLevelBase::LinkType &andCompile) {
 	that.Link();		return *this;
 }
 
 template<typename S, typename U, typename R>
-inline bool	Program<S, U, R>::Link()
-{	//TODO make it smart, only compile when something changed. Not sure how...
-	this->error_msg.clear();
-	if (!this->comp.Compile()) {
+inline uint64_t Program<S, U, R>::assembleSources()
+{
+	this->comp.Assemble(); this->frag.Assemble(); this->vert.Assemble();
+	this->geom.Assemble(); this->tesc.Assemble(); this->tese.Assemble();
+	uint64_t sources = this->comp.GetSourceHash();
+	sources = this->frag.GetSourceHash(sources);
+	sources = this->vert.GetSourceHash(sources);
+	sources = this->geom.GetSourceHash(sources);
+	sources = this->tesc.GetSourceHash(sources);
+	return this->tese.GetSourceHash(sources);
+}
+
+template<typename S, typename U, typename R>
+inline void Program<S, U, R>::submitCompiles()
+{	// every stage is submitted before the first status query, so a driver with parallel compilation overlaps them
+	this->comp.CompileAsync(); this->frag.CompileAsync(); this->vert.CompileAsync();
+	this->geom.CompileAsync(); this->tesc.CompileAsync(); this->tese.CompileAsync();
+}
+
+template<typename S, typename U, typename R>
+inline bool Program<S, U, R>::finishCompiles()
+{
+	if (!this->comp.FinishCompile()) {
 		this->error_msg += "\nCompute Shader did not compile.\n";
 		this->error_msg += this->comp.GetErrors();
 		return false;
 	}
-	if (!this->frag.Compile()) {
+	if (!this->frag.FinishCompile()) {
 		this->error_msg += "\nFragment Shader did not compile.\n";
 		this->error_msg += this->frag.GetErrors();
 		return false;
 	}
-	if (!this->vert.Compile()){
+	if (!this->vert.FinishCompile()){
 		this->error_msg += "\nVertex Shader did not compile.\n";
 		this->error_msg += this->vert.GetErrors();
 		return false;
 	}
-	if (!this->geom.Compile()){
+	if (!this->geom.FinishCompile()){
 		this->error_msg += "\nGeometry Shader did not compile.\n";
 		this->error_msg += this->geom.GetErrors();
 		return false;
 	}
-	if (!this->tesc.Compile()){
+	if (!this->tesc.FinishCompile()){
 		this->error_msg += "\nTessellation Control Shader did not compile.\n";
 		this->error_msg += this->tesc.GetErrors();
 		return false;
 	}
-	if (!this->tese.Compile()){
+	if (!this->tese.FinishCompile()){
 		this->error_msg += "\nTessellation Evaluation Shader did not compile.\n";
 		this->error_msg += this->tese.GetErrors();
 		return false;
 	}
+	return true;
+}
+
+template<typename S, typename U, typename R>
+inline bool Program<S, U, R>::compileInterface()
+{
+	if (!this->uniforms.Compile()) {
+		this->error_msg += "\n Weird error with uniforms. Uniforms class did not Compile.\n";
+		return false;
+	}
+	if (!this->subroutines.Compile()) {
+		this->error_msg += "\n Weird error with subroutines. Subroutines class did not Compile.\n";
+		return false;
+	}
+	return true;
+}
+
+template<typename S, typename U, typename R>
+inline void Program<S, U, R>::reloadFiles(const std::vector<std::string>& changed)
+{	// the files including a changed one count as changed, the incremental LinkAsync recompiles only the stages whose source did
+	const std::vector<std::string> affected = ShaderIncludes::GetDependents(changed);
+	bool reloaded = comp.Reload(affected);
+	reloaded = frag.Reload(affected) || reloaded;
+	reloaded = vert.Reload(affected) || reloaded;
+	reloaded = geom.Reload(affected) || reloaded;
+	reloaded = tesc.Reload(affected) || reloaded;
+	reloaded = tese.Reload(affected) || reloaded;
+	if (reloaded) this->LinkAsync();
+}
+
+template<typename S, typename U, typename R>
+inline bool	Program<S, U, R>::Link()
+{	// Only the stages whose source changed are compiled, nothing is linked if none did
+	this->cancelAsyncLink();
+	this->watchFiles([this](const std::vector<std::string>& changed) { this->reloadFiles(changed); });
+	this->error_msg.clear();
+	const uint64_t sources = this->assembleSources();
+	if (sources == this->linked_sources) return true;
+	const bool use_cache = ProgramCache::IsEnabled();
+	const uint64_t cache_key = use_cache ? ProgramCache::GetKey(sources) : 0;
+	if (use_cache && ProgramCache::Load(this->program_id, cache_key)) {
+		this->linked_sources = sources;
+		if (!this->compileInterface()) return false;
+#ifdef _DEBUG
+		std::cout << "Program loaded from the binary cache.\n";
+#endif // _DEBUG
+		return true;
+	}
+	const auto compile_start = std::chrono::steady_clock::now();
+	this->submitCompiles();
+	if (!this->finishCompiles()) return false;
 	GL_CHECK;
 	this->attachShader(comp);
 	this->attachShader(frag);
@@ -147,19 +235,71 @@ inline bool	Program<S, U, R>::Link()
 	this->attachShader(tesc);
 	this->attachShader(tese);
 	GL_CHECK;
+	if (use_cache) ProgramCache::PrepareLink(this->program_id);
+	this->linked_sources = 0;
 	if (!this->link()){
 		this->error_msg += "\nShader Program did not Link.\n";
 		return false;
 	}
-	if (!this->uniforms.Compile()) {
-		this->error_msg += "\n Weird error with uniforms. Uniforms class did not Compile.\n";
-		return false;
-	}
-	if (!this->subroutines.Compile()) {
-		this->error_msg += "\n Weird error with subroutines. Subroutines class did not Compile.\n";
-		return false;
+	this->linked_sources = sources;
+	if (!this->compileInterface()) return false;
+	if (use_cache) ProgramCache::Store(this->program_id, cache_key, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compile_start).count());
+	GL_CHECK;
+#ifdef _DEBUG
+	std::cout << "Program compilation was succesful.\n";
+#endif // _DEBUG
+	return true;
+}
+
+template<typename S, typename U, typename R>
+inline bool Program<S, U, R>::LinkAsync()
+{
+	this->cancelAsyncLink();
+	this->watchFiles([this](const std::vector<std::string>& changed) { this->reloadFiles(changed); });
+	this->error_msg.clear();
+	const uint64_t sources = this->assembleSources();
+	if (sources == this->linked_sources) return true;	// nothing changed, nothing to wait for
+	const bool use_cache = ProgramCache::IsEnabled();
+	const uint64_t cache_key = use_cache ? ProgramCache::GetKey(sources) : 0;
+	if (use_cache)
+	{	// loaded into the pending program, a rejected binary would leave the live one without an executable
+		const GLuint loaded = this->beginAsyncLink([this]() { this->PollLink(); }, sources, 0);
+		if (ProgramCache::Load(loaded, cache_key)) {
+			if (!this->adoptAsyncLink()) {
+				this->error_msg += "\nShader Program did not Link.\n";
+				return false;
+			}
+			return this->compileInterface();
+		}
+		this->cancelAsyncLink();
 	}
+	this->submitCompiles();
+	const GLuint pending = this->beginAsyncLink([this]() { this->PollLink(); }, sources, cache_key);
+	this->attachShader(comp, pending);
+	this->attachShader(frag, pending);
+	this->attachShader(vert, pending);
+	this->attachShader(geom, pending);
+	this->attachShader(tesc, pending);
+	this->attachShader(tese, pending);
+	glLinkProgram(pending);
 	GL_CHECK;
+	return true;
+}
+
+template<typename S, typename U, typename R>
+inline bool Program<S, U, R>::PollLink(bool wait)
+{
+	if (!this->IsLinking()) return true;
+	if (!wait && !this->isAsyncLinkDone()) return false;
+	if (!this->finishCompiles()) {
+		this->cancelAsyncLink();	// the previous program stays
+		return true;
+	}
+	if (!this->adoptAsyncLink()) {
+		this->error_msg += "\nShader Program did not Link.\n";
+		return true;
+	}
+	this->compileInterface();
 #ifdef _DEBUG
 	std::cout << "Program compilation was succesful.\n";
 #endif // _DEBUG
@@ -27,7 +27,10 @@ inline void ProgramEditor<S, U, R>::Render()
 	{
 		if (ImGui::Button("Compile & Link"))
 		{
-			this->Link();
+			this->LinkAsync();
+		}
+		if (this->IsLinking()) {
+			ImGui::SameLine();	ImGui::TextUnformatted("Compiling...");
 		}
 		if (ImGui::BeginTabBar("ProgramTabBar", 0)) {
 			if constexpr (std::is_same_v<typename S::Frag, NoShader>) {
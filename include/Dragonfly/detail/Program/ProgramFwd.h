@@ -1,5 +1,7 @@
 #pragma once
 #include "../Shader/ShaderFwd.h"
+#include <GL/glew.h>
+#include <string>
 
 namespace df
 {
@@ -25,6 +27,8 @@ namespace df
 		struct _GeomShader { const char* path; };
 		struct _TescShader { const char* path; };
 		struct _TeseShader { const char* path; };
+		//Code generated by the framework for one stage (eg. VertexPuller::Vert)
+		struct _GeneratedShader { GLenum stage; std::string name; std::string code; int version = 430; };
 	}
 
 } //namespace df
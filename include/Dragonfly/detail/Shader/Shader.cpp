@@ -1,6 +1,7 @@
 #include "Shader.h"
 #include "Shader.inl"
 #include "../File/File.h"
+#include "../File/Hash.h"
 
 using namespace df;
 
@@ -34,12 +35,26 @@ ShaderLowLevelBase::~ShaderLowLevelBase()
 bool ShaderLowLevelBase::Compile()
 {
 	ASSERT(type == GL_COMPUTE_SHADER || type == GL_FRAGMENT_SHADER || type == GL_VERTEX_SHADER || type == GL_GEOMETRY_SHADER || type == GL_TESS_CONTROL_SHADER || type == GL_TESS_EVALUATION_SHADER, "Invalid shader type");
-	ASSERT(source_strs.size() > 1 && source_strs.size() == source_lens.size(), "Invalid source.");
 	GPU_ASSERT(glIsShader(shader_id), "Invalid shader");
 
+	submitCompile();
+	return finishCompile();
+}
+
+bool ShaderLowLevelBase::submitCompile()
+{
+	ASSERT(source_strs.size() > 1 && source_strs.size() == source_lens.size(), "Invalid source.");
+	const uint64_t hash = GetSourceHash();
+	if (hash == compiled_hash) return false;	// the shader object still has the result (and log) of this source
+	compiled_hash = hash;
 	error_msg.clear();
 	glShaderSource(shader_id, (GLsizei)source_strs.size(), source_strs.data(), source_lens.data());
 	glCompileShader(shader_id);
+	return true;
+}
+
+bool ShaderLowLevelBase::finishCompile()
+{
 	GLint result = 0, loglen = 0, errlen = 0;
 	glGetShaderiv(shader_id, GL_COMPILE_STATUS, &result);
 	glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &loglen);
@@ -50,3 +65,11 @@ bool ShaderLowLevelBase::Compile()
 	}
 	return result;
 }
+
+uint64_t ShaderLowLevelBase::GetSourceHash(uint64_t seed) const
+{
+	uint64_t hash = hashBytes(&type, sizeof(type), seed);
+	for (size_t i = 0; i < source_strs.size(); ++i)
+		hash = hashBytes(source_strs[i], source_lens[i], hash);
+	return hash;
+}
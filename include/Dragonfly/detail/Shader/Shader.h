@@ -28,9 +28,13 @@ class Shader : public ShaderBase<File_t>
 	static_assert(std::is_base_of_v<SFile, File_t>,"File_t must be derived from SFile");
 private:
 	std::vector<std::string> extra_lines;
+	std::vector<std::string> expanded;		// code of the files with #include, empty for the others
 	friend class ProgramLowLevelBase;
+	//The file's path in source_files and the include graph: normalized (see FileWatcher), the name for generated code
+	static std::string sourceKey(const File_t& file);
 protected:
 	std::vector<File_t> shaders;
+	std::vector<std::string> source_files;	// path of each GLSL source string number (index + 1), see ShaderIncludes
 	Shader() = delete;
 public:
 	Shader(GLenum type);
@@ -39,6 +43,8 @@ public:
 	//Push a shader file 
 	Shader& operator <<(File_t &&sfile);
 	Shader& operator <<(const std::string& path);
+	//Push code generated in memory, 'name' only shows up in the error messages
+	Shader& AddSource(const std::string& name, const std::string& code, int version_number = 430);
 
 	//Delete a shader
 	void PopShader();
@@ -47,8 +53,20 @@ public:
 	//You can only read this data
 	inline const File_t&	  GetShader(size_t idx) const { ASSERT(idx < shaders.size() && idx < 0, "Invalid index"); return shaders[idx]; }
 
+	//Paths of the source string numbers (index + 1) in the driver's messages, as of the last Assemble
+	inline const std::vector<std::string>& GetSourceFiles() const { return source_files; }
+
+	//Gathers source code from added shaders without compiling, #include lines are expanded (see ShaderIncludes)
+	void Assemble();
 	//Gathers source code from added shaders and compiles (does not "relaod" shaders)
 	bool Compile();
+	//Same as Compile, but returns without waiting for the driver. FinishCompile gets the result.
+	//Both only call glCompileShader if the assembled source changed, CompileAsync returns true if it did.
+	bool CompileAsync();
+	bool FinishCompile();
+	//Loads the files whose path is in 'changed' (see FileWatcher), files with unsaved edits are kept.
+	//True if any other file is in it, generated code is in it if something it includes changed (see ShaderIncludes::GetDependents).
+	bool Reload(const std::vector<std::string>& changed);
 
 	//This class doesn't (really) implement these features:
 	void Render(std::string name = "") {}	void Update();
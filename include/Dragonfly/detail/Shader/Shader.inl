@@ -1,6 +1,9 @@
 #pragma once
+#include <algorithm>
 #include <type_traits>
 #include "Shader.h"
+#include "../File/FileWatcher.h"
+#include "ShaderIncludes.h"
 
 namespace df
 {
@@ -16,6 +19,7 @@ private:
 	const GLenum type = 0;
 	const std::string type_str;
 	std::string error_msg;
+	uint64_t compiled_hash = 0;	// GetSourceHash of the last submitted source, 0: never compiled
 
 	ShaderLowLevelBase() = delete;
 protected:
@@ -30,8 +34,14 @@ protected:
 	inline const std::string& getTypeStr() const { return type_str; }
 
 	bool Compile();
+	//Compile split in two: submit does not wait for the driver, finish queries the status (and waits if needed)
+	//Submit skips glCompileShader if the source is the same as last time and returns false
+	bool submitCompile();
+	bool finishCompile();
 public:
 	inline const std::string& GetErrors() const { return error_msg; }
+	//Hash of the type and the assembled source, chained from 'seed'
+	uint64_t GetSourceHash(uint64_t seed = 0) const;
 };
 
 template<typename File_t>
@@ -48,28 +58,63 @@ template<typename File_t> df::Shader<File_t>::Shader(GLenum type) : df::ShaderBa
 template<typename File_t> df::Shader<File_t>::~Shader(){}
 
 template<typename File_t>
-bool df::Shader<File_t>::Compile(){
+std::string df::Shader<File_t>::sourceKey(const File_t& file) {
+	return file.IsGenerated() ? file.GetPath() : FileWatcher::Normalize(file.GetPath());
+}
+
+template<typename File_t>
+void df::Shader<File_t>::Assemble(){
 	this->source_strs.resize(2*shaders.size() + 1);
 	this->source_lens.resize(2*shaders.size() + 1);
 	extra_lines.resize(shaders.size());
+	expanded.resize(shaders.size());
+	source_files.clear();
 	int ver_num = 110;		//smallest possible version number
+	for (const File_t& file : shaders)
+		ver_num = ver_num > file.GetVersionNumber() ? ver_num : file.GetVersionNumber();
 	for (size_t i = 0; i < shaders.size(); ++i)	{
-		extra_lines[i] = "/*************************************************\n" + shaders[i].GetPath() + "\n*************************************************/\n";
+		// every file is its own source string, the #line directives make the driver report lines of the file
+		const std::string &path = shaders[i].GetPath();
+		const std::string key = sourceKey(shaders[i]);
+		extra_lines[i] = "/*************************************************\n" + path + "\n*************************************************/\n";
+		expanded[i].clear();
+		const std::string *code = &expanded[i];
+		if (std::find(source_files.begin(), source_files.end(), key) != source_files.end())
+			extra_lines[i] += "// already included\n";	// an earlier file of this stage includes it, like a second #include would
+		else {
+			const int source = ShaderIncludes::GetSourceNumber(source_files, key);
+			extra_lines[i] += ShaderIncludes::LineDirective(shaders[i].GetFirstLine(), source, ver_num);
+			if (!ShaderIncludes::Expand(key, shaders[i].GetCode(), shaders[i].GetFirstLine(), source, ver_num, source_files, expanded[i]))
+				code = &shaders[i].GetCode();
+		}
 		const std::string &line0 = extra_lines[i];
 		this->source_strs[2 * i + 1] = line0.c_str();
 		this->source_lens[2 * i + 1] = (GLint)line0.length();
-
-		const std::string &code = shaders[i].GetCode();
-		this->source_strs[2 * i + 2] = code.c_str();
-		this->source_lens[2 * i + 2] = (GLint)code.length();
-		ver_num = ver_num > this->shaders[i].GetVersionNumber() ? ver_num : this->shaders[i].GetVersionNumber();
+		this->source_strs[2 * i + 2] = code->c_str();
+		this->source_lens[2 * i + 2] = (GLint)code->length();
 	}
 	this->version_str = "#version " + std::to_string(ver_num) + '\n';
 	this->source_strs[0] = this->version_str.c_str();
 	this->source_lens[0] = (GLint)this->version_str.length();
+}
+
+template<typename File_t>
+bool df::Shader<File_t>::Compile(){
+	Assemble();
 	return ShaderLowLevelBase::Compile();
 }
 
+template<typename File_t>
+bool df::Shader<File_t>::CompileAsync(){
+	Assemble();
+	return ShaderLowLevelBase::submitCompile();
+}
+
+template<typename File_t>
+bool df::Shader<File_t>::FinishCompile(){
+	return ShaderLowLevelBase::finishCompile();
+}
+
 template<typename File_t>
 df::Shader<File_t>& df::Shader<File_t>::operator <<(File_t &&sfile){
 	shaders.emplace_back(std::move(sfile));
@@ -80,6 +125,11 @@ df::Shader<File_t>& df::Shader<File_t>::operator <<(const std::string& path){
 	shaders.emplace_back(path);
 	return *this;
 }
+template<typename File_t>
+df::Shader<File_t>& df::Shader<File_t>::AddSource(const std::string& name, const std::string& code, int version_number){
+	shaders.emplace_back(File_t::FromSource(name, code, version_number));
+	return *this;
+}
 
 template<typename File_t>
 void df::Shader<File_t>::PopShader() {
@@ -90,6 +140,17 @@ void df::Shader<File_t>::EraseShader(size_t idx) {
 	ASSERT(idx < shaders.size() && idx >= 0,"Invalid index");	shaders.erase(shaders.begin() + idx);
 }
 
+template<typename File_t>
+bool df::Shader<File_t>::Reload(const std::vector<std::string>& changed) {
+	bool reloaded = false;
+	for (File_t& file : shaders)
+		if (!file.isDirty() && std::binary_search(changed.begin(), changed.end(), sourceKey(file))) {
+			file.Load();	// a failed load shows up as a compile error, generated code stays
+			reloaded = true;
+		}
+	return reloaded;
+}
+
 template<typename File_t> void df::Shader<File_t>::Update() {
 	for (auto& s : this->shaders) s.Update();
 }
\ No newline at end of file
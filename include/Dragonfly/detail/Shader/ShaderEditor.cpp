@@ -3,6 +3,8 @@
 #include <fstream>
 #include <string>
 #include <regex>
+#include <sstream>
+#include <cstdio>
 #include "../../config.h"
 #include "Shader.h"
 #include "Shader.inl"
@@ -80,6 +82,12 @@ bool ShaderEditor<File_t>::Compile()
 	bool b = Shader<File_t>::Compile(); onCompile(); return b;
 }
 
+template<typename File_t>
+bool ShaderEditor<File_t>::FinishCompile()
+{	// the files may have been edited since CompileAsync, the error view shows the current sources
+	bool b = Shader<File_t>::FinishCompile(); this->Assemble(); onCompile(); return b;
+}
+
 template<typename File_t>
 void ShaderEditor<File_t>::Render(std::string program_name){
 	
@@ -290,32 +298,50 @@ template<> void setMarkersImpl<FileEditor>(FileEditor& sfile, const TextEditor::
 template<typename File_t>
 void ShaderEditor<File_t>::onCompile() {
 	//set text
-	error_handling.generated.SetText("");
-	error_handling.generated.SetReadOnly(false);
-	std::vector<int> line_numbers(this->source_strs.size());
-	for (int i = 0; i < this->source_strs.size(); ++i) {
-		error_handling.generated.InsertText(this->source_strs[i]);
-		line_numbers[i] = error_handling.generated.GetTotalLines();
+	std::string generated_code;
+	for (size_t i = 0; i < this->source_strs.size(); ++i)
+		generated_code.append(this->source_strs[i], this->source_lens[i]);
+	error_handling.generated.SetText(generated_code);
+	//line of the generated code for each (source string, line) pair, following the #line directives
+	std::map<std::pair<int, int>, int> generated_lines;
+	{
+		const int line_offset = std::stoi(this->version_str.substr(9)) < 330 ? 1 : 0;	// see ShaderIncludes::LineDirective
+		int source = 0, line = 1, generated_line = 1, directive_line, directive_source;
+		std::istringstream generated_stream(generated_code);
+		for (std::string text; std::getline(generated_stream, text); ++generated_line) {
+			if (std::sscanf(text.c_str(), "#line %d %d", &directive_line, &directive_source) == 2) {
+				line = directive_line + line_offset;
+				source = directive_source;
+			}
+			else generated_lines.emplace(std::make_pair(source, line++), generated_line);
+		}
 	}
-	error_handling.generated.SetReadOnly(true);
 	//helper functions
 	auto parseError = [](const std::string &line) -> ErrorLine {
 		static std::regex r_i("((?:ERROR)|(?:WARNING)):\\s*(\\d+):(\\d+):\\s*(.*?)\\s*", std::regex::flag_type::optimize);						//intel compiler
 		static std::regex r_n("(.*?)\\((\\d+)\\)\\s*:\\s*((?:error)|(?:warning))\\s*C(\\d{4}):\\s*(.*?)\\s*",std::regex::flag_type::optimize);	//nvidia compiler
+		static std::regex r_m("(\\d+):(\\d+)\\((\\d+)\\):\\s*(?:\\w+\\s+)?((?:error)|(?:warning)):\\s*(.*?)\\s*", std::regex::flag_type::optimize);	//mesa compiler
 		//static std::regex r_a("((?:ERROR)|(?:WARNING)):\\s*(\\d+):(\\d+):\\s*(.*?)\\s*",std::regex::flag_type::optimize);						//amd compiler
 		std::smatch m; ErrorLine ret;
 		if (std::regex_match(line, m, r_i))	{
 			if (m[1] == "ERROR")			ret.type = ErrorLine::Type::ERROR;
 			else if (m[1] == "WARNING")		ret.type = ErrorLine::Type::WARNING;
-			ret.col = std::stoi(m[2]);		ret.line = std::stoi(m[3]);
+			ret.source = std::stoi(m[2]);	ret.line = std::stoi(m[3]);
 			ret.message = m[4];
 		}
 		else if (std::regex_match(line, m, r_n)) {
 			ret.path = m[1];				ret.line = std::stoi(m[2]);
+			if (!ret.path.empty() && ret.path.find_first_not_of("0123456789") == std::string::npos) ret.source = std::stoi(ret.path);
 			if (m[3] == "error")			ret.type = ErrorLine::Type::ERROR;
 			else if (m[3] == "warning")		ret.type = ErrorLine::Type::WARNING;
 			ret.e_code = std::stoi(m[4]);	ret.message = m[5];
 		}
+		else if (std::regex_match(line, m, r_m)) {
+			ret.source = std::stoi(m[1]);	ret.line = std::stoi(m[2]);		ret.col = std::stoi(m[3]);
+			if (m[4] == "error")			ret.type = ErrorLine::Type::ERROR;
+			else if (m[4] == "warning")		ret.type = ErrorLine::Type::WARNING;
+			ret.message = m[5];
+		}
 		else ret.message = line;
 		return ret;
 	};
@@ -325,40 +351,34 @@ void ShaderEditor<File_t>::onCompile() {
 
 	auto addError = [&](const std::string& errline) -> void {
 		ErrorLine err = parseError(errline);
-		if (!(line_numbers.front() <= err.line && err.line <= line_numbers.back())) {
-			ASSERT(false, "Parsing the error probably failed.");
+		if (err.source < 0 || err.line < 0) {	// not about a line (eg. a link error)
 			error_handling.parsed_errors.emplace_back(err);
 			return;
 		}
-		gen_markers.emplace(err.line, err.message);
-
-		//find out which file has that error
-		auto it_src_line_nbr = std::upper_bound(line_numbers.cbegin(), line_numbers.cend(), err.line) - 1;
-		int total_lines_to_src = *it_src_line_nbr;
-		ASSERT(0 <= total_lines_to_src && total_lines_to_src <= err.line, "Error finding exact line of the shader error message in file.");
-		ASSERT(it_src_line_nbr + 1 == line_numbers.cend() || err.line <= *(it_src_line_nbr + 1), "Error finding exact line of the shader error message in file.");
-		size_t which_source = std::distance(line_numbers.cbegin(), it_src_line_nbr);
-		ASSERT(0 <= which_source && which_source < this->source_strs.size(), "Error finding exact line of the shader error message in file.");
-		if (which_source == 0)
+		auto generated_line = generated_lines.find({ err.source, err.line });
+		if (generated_line != generated_lines.end()) gen_markers.emplace(generated_line->second, err.message);
+
+		if (err.source == 0 && err.line > 1)
+		{	// some drivers drop the source string number of semantic errors, the line is still the one in the file
+			err.path = "UNKNOWN FILE";
+		}
+		else if (err.source == 0)
 		{	// problem with version
 			err.path = "WRONG GENERATED VERSION";
 			err.message = "Check the first line of all shader files under compilation externally to this application. (" + err.message + ')';
 		}
-		else
-		{
-			size_t file_id = (which_source - 1) / 2;	// FOUND YOU! (I hope)
-			ASSERT(0 <= file_id && file_id < this->shaders.size(), "Invalid file ID");
-
-			err.path = this->shaders[file_id].GetFolder() + '/' + this->shaders[file_id].GetFilename() + this->shaders[file_id].GetExtension();
-
-			//if(err.type == ErrorLine::Type::ERROR)	gen_markers.emplace(err.line, err.message);
-
-			err.line = which_source % 2 == 1 ? //line number in file
-				err.line - total_lines_to_src + 1:
-				line_numbers[which_source]-1; //last line number of that previous file.
-
-			if constexpr (std::is_same_v<FileEditor, File_t>) if (err.type == ErrorLine::Type::ERROR) file_markers[file_id].emplace(err.line, err.message);
+		else if (err.source <= (int)this->source_files.size())
+		{	// the #line directives name the file (included ones too) and the line in it
+			const std::string &source_path = this->source_files[err.source - 1];
+			const std::string relative = std::filesystem::path(source_path).lexically_relative(std::filesystem::current_path()).generic_string();
+			err.path = relative.empty() ? source_path : relative;
+
+			if constexpr (std::is_same_v<FileEditor, File_t>) if (err.type == ErrorLine::Type::ERROR)
+				for (size_t file_id = 0; file_id < this->shaders.size(); ++file_id)
+					if (FileWatcher::Normalize(this->shaders[file_id].GetPath()) == source_path || this->shaders[file_id].GetPath() == source_path)
+						file_markers[file_id].emplace(err.line - this->shaders[file_id].GetFirstLine() + 1, err.message);	// the editor has no #version line
 		}
+		else ASSERT(false, "Parsing the error probably failed.");
 		error_handling.parsed_errors.emplace_back(err);
 	};
 
@@ -58,6 +58,8 @@ public:
 
 	//Gathers source code from added shaders and compiles (does not reload shaders)
 	bool Compile();
+	//Result of a CompileAsync, updates the error markers
+	bool FinishCompile();
 };
 
 } //namespace df
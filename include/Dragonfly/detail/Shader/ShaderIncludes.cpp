@@ -0,0 +1,220 @@
+#include "ShaderIncludes.h"
+#include "../File/FileWatcher.h"
+#include "../File/Hash.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+
+using namespace df;
+
+namespace {
+
+struct Directive
+{
+	size_t		begin, end;	// of the line in the code, newline included
+	int			line;
+	bool		include;	// false: a #version line, dropped from included files
+	std::string	name;		// as written
+	std::string	target;		// normalized path
+};
+
+struct ParsedFile
+{
+	std::string				code;
+	uint64_t				hash = 0;
+	std::vector<Directive>	directives;
+	bool					stale = true;
+	bool					from_disk = false;	// included, read by us: watched and time stamped
+	std::filesystem::file_time_type time;
+	FileWatcher::Handle		watch;
+};
+
+std::map<std::string, ParsedFile>& s_files() { static std::map<std::string, ParsedFile> files; return files; }
+std::map<std::string, std::set<std::string>>& s_includers() { static std::map<std::string, std::set<std::string>> includers; return includers; }	// file -> the files including it
+
+bool startsWith(const std::string& code, size_t& pos, size_t end, const char* word)
+{
+	const size_t length = std::char_traits<char>::length(word);
+	if (end - pos < length || code.compare(pos, length, word) != 0) return false;
+	pos += length;
+	return true;
+}
+
+void skipSpaces(const std::string& code, size_t& pos, size_t end)
+{
+	while (pos < end && (code[pos] == ' ' || code[pos] == '\t')) ++pos;
+}
+
+std::string resolve(const std::string& includer, const std::string& name)
+{
+	std::error_code error;
+	const std::filesystem::path relative = std::filesystem::path(includer).parent_path() / name;
+	if (std::filesystem::exists(relative, error)) return FileWatcher::Normalize(relative.generic_string());
+	return FileWatcher::Normalize(name);
+}
+
+//Finds the #include and #version lines and updates the dependency graph
+void parse(const std::string& path, ParsedFile& file)
+{
+	for (const Directive& directive : file.directives)
+		if (!directive.target.empty()) s_includers()[directive.target].erase(path);
+	file.directives.clear();
+	file.hash = hashString(file.code);
+	const std::string& code = file.code;
+	int line = 1;
+	for (size_t begin = 0; begin < code.size(); ++line) {
+		const size_t newline = code.find('\n', begin);
+		const size_t end = newline == std::string::npos ? code.size() : newline + 1;
+		size_t pos = begin;
+		skipSpaces(code, pos, end);
+		if (pos < end && code[pos] == '#') {
+			++pos;
+			skipSpaces(code, pos, end);
+			if (startsWith(code, pos, end, "include")) {
+				skipSpaces(code, pos, end);
+				const bool quoted = pos < end && (code[pos] == '"' || code[pos] == '<');
+				const size_t close = quoted ? code.find(code[pos] == '<' ? '>' : '"', pos + 1) : std::string::npos;
+				if (close < end) {
+					const std::string name = code.substr(pos + 1, close - pos - 1);
+					file.directives.push_back({ begin, end, line, true, name, resolve(path, name) });
+				}
+				else	// malformed, becomes an #error
+					file.directives.push_back({ begin, end, line, true, code.substr(pos, code.find_last_not_of("\r\n", end - 1) + 1 - pos), "" });
+			}
+			else if (startsWith(code, pos, end, "version"))
+				file.directives.push_back({ begin, end, line, false, "", "" });
+		}
+		begin = end;
+	}
+	for (const Directive& directive : file.directives)
+		if (!directive.target.empty()) s_includers()[directive.target].insert(path);
+	file.stale = false;
+}
+
+//The code of 'path' given by its SFile, reparsed only if it differs from last time
+const ParsedFile& parseSource(const std::string& path, const std::string& code)
+{
+	ParsedFile& file = s_files()[path];
+	if (!file.stale && !file.from_disk && file.code.size() == code.size() && file.hash == hashString(code)) return file;
+	file.code = code;
+	file.from_disk = false;
+	parse(path, file);
+	return file;
+}
+
+//An included file, read from the disk only if it changed since it was parsed
+const ParsedFile* parseInclude(const std::string& path)
+{
+	static const bool subscribed = (FileWatcher::Subscribe(&s_files(), [](const std::vector<std::string>& changed) {
+		for (const std::string& path : changed) {
+			auto file = s_files().find(path);
+			if (file != s_files().end()) file->second.stale = true;
+		}
+	}, -10), true);	// before the programs reload
+	(void)subscribed;
+
+	std::error_code error;
+	auto found = s_files().find(path);
+	if (found != s_files().end() && found->second.from_disk && !found->second.stale
+		&& (FileWatcher::IsRunning() || std::filesystem::last_write_time(path, error) == found->second.time))
+		return &found->second;
+
+	std::ifstream in(path, std::ifstream::binary);
+	if (!in.is_open()) return nullptr;
+	std::stringstream content;
+	content << in.rdbuf();
+	ParsedFile& file = s_files()[path];
+	if (!file.from_disk) file.watch = FileWatcher::Handle(path);
+	file.from_disk = true;
+	file.time = std::filesystem::last_write_time(path, error);
+	file.code = content.str();
+	file.code.erase(std::remove(file.code.begin(), file.code.end(), '\r'), file.code.end());
+	parse(path, file);
+	return &file;
+}
+
+void expand(const std::string& path, const ParsedFile& file, int first_line, int source, int glsl_version, std::vector<std::string>& files, std::vector<std::string>& chain, std::string& out)
+{
+	chain.push_back(path);
+	size_t pos = 0;
+	for (const Directive& directive : file.directives) {
+		out.append(file.code, pos, directive.begin - pos);
+		pos = directive.end;
+		if (!directive.include) { out += '\n'; continue; }	// every line is replaced by one line, the numbers stay
+		if (directive.target.empty())
+			out += "#error malformed #include " + directive.name + '\n';
+		else if (std::find(chain.begin(), chain.end(), directive.target) != chain.end())
+			out += "#error recursive #include \"" + directive.name + "\"\n";
+		else if (std::find(files.begin(), files.end(), directive.target) != files.end())
+			out += '\n';	// already in this stage
+		else if (const ParsedFile* included = parseInclude(directive.target)) {
+			const int included_source = ShaderIncludes::GetSourceNumber(files, directive.target);
+			out += ShaderIncludes::LineDirective(1, included_source, glsl_version);
+			expand(directive.target, *included, 1, included_source, glsl_version, files, chain, out);
+			out += ShaderIncludes::LineDirective(first_line + directive.line, source, glsl_version);	// the line after the directive
+		}
+		else
+			out += "#error cannot open #include \"" + directive.name + "\"\n";
+	}
+	out.append(file.code, pos, std::string::npos);
+	if (!out.empty() && out.back() != '\n') out += '\n';
+	chain.pop_back();
+}
+
+} //namespace
+
+bool ShaderIncludes::Expand(const std::string& path, const std::string& code, int first_line, int source, int glsl_version, std::vector<std::string>& files, std::string& out)
+{
+	const ParsedFile& file = parseSource(path, code);
+	if (std::none_of(file.directives.begin(), file.directives.end(), [](const Directive& directive) { return directive.include; }))
+		return false;
+	std::vector<std::string> chain;
+	expand(path, file, first_line, source, glsl_version, files, chain, out);
+	return true;
+}
+
+int ShaderIncludes::GetSourceNumber(std::vector<std::string>& files, const std::string& path)
+{
+	auto found = std::find(files.begin(), files.end(), path);
+	if (found == files.end()) found = files.insert(files.end(), path);
+	return static_cast<int>(found - files.begin()) + 1;	// 0 is the #version line
+}
+
+std::string ShaderIncludes::LineDirective(int line, int source, int glsl_version)
+{
+	return "#line " + std::to_string(glsl_version < 330 ? line - 1 : line) + ' ' + std::to_string(source) + '\n';
+}
+
+std::vector<std::string> ShaderIncludes::GetDependents(const std::vector<std::string>& changed)
+{
+	std::set<std::string> dependents(changed.begin(), changed.end());
+	std::vector<std::string> queue(changed.begin(), changed.end());
+	while (!queue.empty()) {
+		const std::string path = std::move(queue.back());
+		queue.pop_back();
+		auto includers = s_includers().find(path);
+		if (includers == s_includers().end()) continue;
+		for (const std::string& includer : includers->second)
+			if (dependents.insert(includer).second) queue.push_back(includer);
+	}
+	return std::vector<std::string>(dependents.begin(), dependents.end());
+}
+
+std::vector<std::string> ShaderIncludes::GetIncludes(const std::string& path)
+{
+	std::vector<std::string> includes;
+	auto file = s_files().find(FileWatcher::Normalize(path));
+	if (file != s_files().end())
+		for (const Directive& directive : file->second.directives)
+			if (!directive.target.empty()) includes.push_back(directive.target);
+	return includes;
+}
+
+void ShaderIncludes::Clear()
+{
+	s_files().clear();
+	s_includers().clear();
+}
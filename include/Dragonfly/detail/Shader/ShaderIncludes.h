@@ -0,0 +1,48 @@
+#pragma once
+#include "../../config.h"
+#include <string>
+#include <vector>
+
+namespace df
+{
+
+/****************************************************************************
+ *						GLSL #include										*
+ ****************************************************************************/
+// Shader::Assemble expands the #include "path" (or <path>) lines of the shader files, paths are relative to the
+// including file (or the working directory). A file is included once per shader stage, like with #pragma once.
+//	// Shaders/common.glsl
+//	vec3 toSRGB(vec3 c) { return pow(c, vec3(1.0 / 2.2)); }
+//	// Shaders/mesh.frag
+//	#include "common.glsl"
+//	void main() { fs_out_col = vec4(toSRGB(color), 1); }
+// Every file is parsed once. The FileWatcher invalidates the files that change (or their time stamp does at the next
+// Link if the watcher is not running) and hot reload relinks every program that includes them, directly or not.
+// Each file is its own GLSL source string with #line directives, so compile errors (and the ShaderEditor error list)
+// name the file and the line in it. A missing or recursive include turns into an #error at its line.
+// The #version lines of included files are dropped, the stage uses the highest version of the files added to it.
+
+class ShaderIncludes
+{
+public:
+	ShaderIncludes() = delete;
+
+	//Appends 'code' (of the file at 'path' from its line 'first_line', source string number 'source') to 'out' with its includes expanded.
+	//'files' holds the paths of the source string numbers (index + 1), the included files are added to it.
+	//'path' is the one in 'files': normalized (see FileWatcher) for files on the disk, the name of generated code.
+	//Returns false and leaves 'out' alone if 'code' includes nothing.
+	static bool Expand(const std::string& path, const std::string& code, int first_line, int source, int glsl_version, std::vector<std::string>& files, std::string& out);
+	//Source string number of 'path' in 'files', added if it is not there yet
+	static int GetSourceNumber(std::vector<std::string>& files, const std::string& path);
+	//Makes the next line be 'line' of source string 'source' (GLSL before 3.30 counts from the line of the directive)
+	static std::string LineDirective(int line, int source, int glsl_version);
+
+	//The 'changed' paths (normalized, see FileWatcher) and every file that includes one of them, directly or not. Sorted.
+	static std::vector<std::string> GetDependents(const std::vector<std::string>& changed);
+	//Normalized paths of the files 'path' includes directly, as of its last expansion
+	static std::vector<std::string> GetIncludes(const std::string& path);
+	//Drops the parsed files and the dependency graph
+	static void Clear();
+};
+
+} //namespace df
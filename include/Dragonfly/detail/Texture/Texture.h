@@ -75,7 +75,7 @@ protected:
 	GLuint _layers = 0; // array
 	bool _hasStorage = false;
 
-	TextureLowLevelBase() { glGenTextures(1, &texture_id); }
+	explicit TextureLowLevelBase(GLenum target) { glCreateTextures(target, 1, &texture_id); }
 	~TextureLowLevelBase() { glDeleteTextures(1, &texture_id); }
 
 	TextureLowLevelBase(const TextureLowLevelBase&) = delete;
@@ -98,7 +98,7 @@ class Texture{
 template<TextureType TexType, typename InternalFormat_>
 class TextureBase : public TextureLowLevelBase {
 protected:
-	TextureBase() {}
+	TextureBase() : TextureLowLevelBase(static_cast<GLenum>(TexType)) {}
 	~TextureBase() {}
 
 	TextureBase(const TextureBase&) = delete;
@@ -152,6 +152,9 @@ Texture<NewTexType, NewInternalFormat> TextureBase<TexType, InternalFormat_>::_M
 	if (this->_hasStorage) {
 		constexpr GLenum iFormat = detail::getInternalFormat<InternalFormat_>();
 		static_assert(sizeof(InternalFormat_) == sizeof(NewInternalFormat), "Texture: Internal formats must be of the same size class");
+		// glTextureView needs a name that was never bound, but the view's name is already created (DSA)
+		glDeleteTextures(1, &view.texture_id);
+		glGenTextures(1, &view.texture_id);
 		glTextureView(view.texture_id, static_cast<GLenum>(NewTexType), this->texture_id, iFormat, levels.min, levels.num, layers.min, layers.num);
 		GL_CHECK;
 		view._width = std::max((GLuint)1, this->_width >> levels.min);
@@ -172,8 +175,7 @@ void TextureBase<TexType, InternalFormat_>::bind() const {
 template<TextureType TexType, typename InternalFormat_>
 void TextureBase<TexType, InternalFormat_>::bind(GLuint hwSamplerUnit) const {
 	ASSERT(hwSamplerUnit < 256, "Texture or sampler units you can attach your texture to start from 0 (and go to 96 minimum in OpenGL 4.5.)");
-	glActiveTexture(GL_TEXTURE0 + hwSamplerUnit);
-	this->bind();
+	glBindTextureUnit(hwSamplerUnit, this->texture_id);
 }
 
 inline TextureLowLevelBase& df::TextureLowLevelBase::operator=(TextureLowLevelBase&& _o) {
@@ -72,9 +72,9 @@ void Texture<TextureType::TEX_2D, InternalFormat_>::LoadFromSDLSurface(SDL_Surfa
 		ASSERT(ret == 0, "Texture2D: Failed to invert image");
 	}
 
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, this->_width, this->_height, sdl_channels, sdl_pxformat, static_cast<void*>(img->pixels));
+	glTextureSubImage2D(this->texture_id, 0, 0, 0, this->_width, this->_height, sdl_channels, sdl_pxformat, static_cast<void*>(img->pixels));
 
-	glGenerateMipmap(GL_TEXTURE_2D);
+	glGenerateTextureMipmap(this->texture_id);
 
 	SDL_FreeSurface(img);
 }
@@ -129,9 +129,8 @@ void Texture<TextureType::TEX_2D, InternalFormat_>::InitTexture(GLuint width, GL
 		this->_levels = numLevels;
 		this->_layers = 1;
 		ASSERT(width >= 1 && height >= 1 && numLevels >= 1 && numLevels <= log2(width > height ? width : height) + 1, "Texture2D: Invalid dimensions");
-		this->bind(); // todo named
 		constexpr GLenum iFormat = detail::getInternalFormat<InternalFormat_>();
-		glTexStorage2D(GL_TEXTURE_2D, numLevels, iFormat, width, height);
+		glTextureStorage2D(this->texture_id, numLevels, iFormat, width, height);
 		this->_hasStorage = true;
 	}
 }
@@ -147,7 +146,6 @@ Texture<TextureType::TEX_2D, InternalFormat_>& Texture<TextureType::TEX_2D, Inte
 	}
 	else {
 		ASSERT(this->_width == loaded_img->w && this->_height == loaded_img->h, "Texture2D: cannot change texture's size after the storage has been set");
-		this->bind();
 	}
 	LoadFromSDLSurface(loaded_img);
 
@@ -160,8 +158,6 @@ Texture<TextureType::TEX_2D, InternalFormat_>& Texture<TextureType::TEX_2D, Inte
 {
 	ASSERT(this->_hasStorage, "Texture2D: you can only load data to a texture if it has its size set (Init)");
 	if (this->_hasStorage) {
-		this->bind();
-
 		constexpr GLenum pxFormat = detail::getInternalChannel<Format>();
 		constexpr GLenum pxType   = detail::getInternalBaseType<Format>();
 
@@ -169,10 +165,10 @@ Texture<TextureType::TEX_2D, InternalFormat_>& Texture<TextureType::TEX_2D, Inte
 		if (this->_width * this->_height > data.size())
 			return *this;
 
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, this->_width, this->_height, pxFormat, pxType, static_cast<const void*>(&data[0]));
+		glTextureSubImage2D(this->texture_id, 0, 0, 0, this->_width, this->_height, pxFormat, pxType, static_cast<const void*>(&data[0]));
 
 		if (genMipmap)
-			glGenerateMipmap(GL_TEXTURE_2D);
+			glGenerateTextureMipmap(this->texture_id);
 	}
 	return *this;
 }
@@ -72,9 +72,8 @@ void Texture<TextureType::TEX_2D_ARRAY, InternalFormat_>::InitTexture(GLuint wid
 		this->_levels = numLevels;
 		this->_layers = numLayers;
 		ASSERT(width >= 1 && height >= 1 && numLevels >= 1 && numLevels <= log2(width > height ? width : height) + 1 && numLayers >= 1, "Texture2DArray: Invalid dimensions");
-		this->bind(); // todo named
 		constexpr GLenum iFormat = detail::getInternalFormat<InternalFormat_>();
-		glTexStorage3D(GL_TEXTURE_2D_ARRAY, numLevels, iFormat, width, height, numLayers);
+		glTextureStorage3D(this->texture_id, numLevels, iFormat, width, height, numLayers);
 		this->_hasStorage = true;
 	}
 }
@@ -85,8 +84,6 @@ Texture<TextureType::TEX_2D_ARRAY, InternalFormat_>& Texture<TextureType::TEX_2D
 {
 	ASSERT(this->_hasStorage, "Texture2DArray: you can only load data to a texture if it has its size set (Init)");
 	if (this->_hasStorage) {
-		this->bind();
-
 		constexpr GLenum pxFormat = detail::getInternalChannel<Format>();
 		constexpr GLenum pxType   = detail::getInternalBaseType<Format>();
 
@@ -94,10 +91,10 @@ Texture<TextureType::TEX_2D_ARRAY, InternalFormat_>& Texture<TextureType::TEX_2D
 		if (this->_width * this->_height * this->_layers > data.size())
 			return *this;
 
-		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, this->_width, this->_height, this->_layers, pxFormat, pxType, static_cast<const void*>(&data[0]));
+		glTextureSubImage3D(this->texture_id, 0, 0, 0, 0, this->_width, this->_height, this->_layers, pxFormat, pxType, static_cast<const void*>(&data[0]));
 
 		if (genMipmap)
-			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+			glGenerateTextureMipmap(this->texture_id);
 	}
 	return *this;
 }
@@ -72,9 +72,8 @@ void Texture<TextureType::TEX_3D, InternalFormat_>::InitTexture(GLuint width, GL
 		this->_levels = numLevels;
 		this->_layers = 1;
 		ASSERT(width >= 1 && height >= 1 && depth >= 1 && numLevels >= 1 && numLevels <= log2(width > height ? (depth > width ? depth : width) : height) + 1, "Texture2D: Invalid dimensions");
-		this->bind(); // todo named
 		constexpr GLenum iFormat = detail::getInternalFormat<InternalFormat_>();
-		glTexStorage3D(GL_TEXTURE_3D, numLevels, iFormat, width, height, depth);
+		glTextureStorage3D(this->texture_id, numLevels, iFormat, width, height, depth);
 		this->_hasStorage = true;
 	}
 }
@@ -85,8 +84,6 @@ Texture<TextureType::TEX_3D, InternalFormat_>& Texture<TextureType::TEX_3D, Inte
 {
 	ASSERT(this->_hasStorage, "Texture3D: you can only load data to a texture if it has its size set (Init)");
 	if (this->_hasStorage) {
-		this->bind();
-
 		constexpr GLenum pxFormat = detail::getInternalChannel<Format>();
 		constexpr GLenum pxType   = detail::getInternalBaseType<Format>();
 
@@ -94,10 +91,10 @@ Texture<TextureType::TEX_3D, InternalFormat_>& Texture<TextureType::TEX_3D, Inte
 		if (this->_width * this->_height * this->_depth > data.size())
 			return *this;
 
-		glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, this->_width, this->_height, this->_depth, pxFormat, pxType, static_cast<const void*>(&data[0]));
+		glTextureSubImage3D(this->texture_id, 0, 0, 0, 0, this->_width, this->_height, this->_depth, pxFormat, pxType, static_cast<const void*>(&data[0]));
 
 		if (genMipmap)
-			glGenerateMipmap(GL_TEXTURE_3D);
+			glGenerateTextureMipmap(this->texture_id);
 	}
 	return *this;
 }
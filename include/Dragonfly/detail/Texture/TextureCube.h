@@ -64,7 +64,7 @@ template<typename InternalFormat_>
 void Texture<TextureType::TEX_CUBE_MAP, InternalFormat_>::LoadFromSDLSurface(SDL_Surface* img, TextureType side)
 {
 	ASSERT(detail::IsTextureTypeCubeSide(side), "TextureCube: side must be one of TextureType::TEX_CUBE_{X,Y,Z}_{POS,NEG}");
-	GLenum target = static_cast<GLenum>(side);
+	const GLint face = static_cast<GLint>(side) - static_cast<GLint>(TextureType::TEX_CUBE_X_POS); // DSA addresses cube faces as layers
 
 	GLenum sdl_pxformat = GL_UNSIGNED_BYTE; //todo calculate from format
 	Uint32 sdl_format = img->format->BytesPerPixel == 3 ? SDL_PIXELFORMAT_RGB24 : SDL_PIXELFORMAT_RGBA32;
@@ -76,7 +76,7 @@ void Texture<TextureType::TEX_CUBE_MAP, InternalFormat_>::LoadFromSDLSurface(SDL
 		img = formattedSurf;
 	}
 
-	glTexSubImage2D(target, 0, 0, 0, this->_width, this->_height, sdl_channels, sdl_pxformat, static_cast<void*>(img->pixels));
+	glTextureSubImage3D(this->texture_id, 0, 0, 0, face, this->_width, this->_height, 1, sdl_channels, sdl_pxformat, static_cast<void*>(img->pixels));
 
 	SDL_FreeSurface(img);
 }
@@ -136,7 +136,7 @@ Texture<TextureType::TEX_CUBE_MAP, InternalFormat_>::Texture(const std::string&
 	ASSERT(loaded_img->w == loaded_img->h && this->_width == loaded_img->w, "TextureCube: wrong image size");
 	LoadFromSDLSurface(loaded_img, TextureType::TEX_CUBE_Z_NEG);
 
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	glGenerateTextureMipmap(this->texture_id);
 }
 
 template<typename InternalFormat_>
@@ -156,9 +156,8 @@ void Texture<TextureType::TEX_CUBE_MAP, InternalFormat_>::InitTexture(GLuint siz
 		if (numLevels == ALL) numLevels = static_cast<GLuint>(floor(log2(size))) + 1;
 		this->_levels = numLevels;
 		this->_layers = 6;
-		this->bind();
 		constexpr GLenum iFormat = detail::getInternalFormat<InternalFormat_>();
-		glTexStorage2D(GL_TEXTURE_CUBE_MAP, numLevels, iFormat, size, size);
+		glTextureStorage2D(this->texture_id, numLevels, iFormat, size, size);
 		this->_hasStorage = true;
 	}
 }
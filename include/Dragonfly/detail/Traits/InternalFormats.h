@@ -7,7 +7,7 @@ namespace df {
 	
 template<typename T> struct integral { T t; }; //for integral formats
 
-//dummys: (ieee half float library is coming soon...)
+//IEEE half floats, see eltecg::ogl::encodeHalf/decodeHalf in Vao/VertexPacking.h for conversion
 struct half  { uint16_t dummy[1]; };
 struct half2 { uint16_t dummy[2]; };
 struct half3 { uint16_t dummy[3]; };
@@ -99,10 +99,10 @@ DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(glm::i16vec4, GL_RGBA16_SNORM, GL_RGBA,
 
 // floating point formats
 
-DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(half, GL_R16F, GL_RED, 0) // THIS IS WRONG, TODO: is it possible to upload half floats?
-DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(half2, GL_RG16F, GL_RG, 0)
-DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(half3, GL_RGB16F, GL_RGB, 0)
-DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(half4, GL_RGBA16F, GL_RGBA, 0)
+DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(half, GL_R16F, GL_RED, GL_HALF_FLOAT)
+DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(half2, GL_RG16F, GL_RG, GL_HALF_FLOAT)
+DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(half3, GL_RGB16F, GL_RGB, GL_HALF_FLOAT)
+DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(half4, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT)
 
 DEFINE_CPP_TO_INERNAL_FORMAT_CONVERSION(r11g11b10, GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV)
 
@@ -128,6 +128,7 @@ DEF_CPP2OGL_TYPE(glm::dmat4x3, GL_DOUBLE_MAT4x3)
 
 //not uniforms:
 DEF_CPP2OGL_TYPE(GLchar, GL_BYTE)
+DEF_CPP2OGL_TYPE(GLbyte, GL_BYTE)
 DEF_CPP2OGL_TYPE(GLubyte, GL_UNSIGNED_BYTE)
 DEF_CPP2OGL_TYPE(GLshort, GL_SHORT)
 DEF_CPP2OGL_TYPE(GLushort, GL_UNSIGNED_SHORT)
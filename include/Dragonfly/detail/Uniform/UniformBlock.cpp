@@ -0,0 +1,46 @@
+#include "UniformBlock.h"
+
+using namespace df;
+
+bool detail::ValidateBlockLayout(GLuint program, BlockLayout layout, const std::string& block_name, size_t size, const std::vector<BlockLeaf>& leaves)
+{
+	GPU_ASSERT(program != 0 && glIsProgram(program), "Invalid shader program");
+	const GLenum block_interface = layout == BlockLayout::STD140 ? GL_UNIFORM_BLOCK : GL_SHADER_STORAGE_BLOCK;
+	const GLenum variable_interface = layout == BlockLayout::STD140 ? GL_UNIFORM : GL_BUFFER_VARIABLE;
+	const GLuint block = glGetProgramResourceIndex(program, block_interface, block_name.c_str());
+	if (block == GL_INVALID_INDEX) {
+		WARNING(true, ("UniformBlock: the block \"" + block_name + "\" is not active in the program.").c_str());
+		return false;
+	}
+	const GLenum block_props[] = { GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+	GLint block_values[2] = { 0, 0 };
+	glGetProgramResourceiv(program, block_interface, block, 2, block_props, 2, nullptr, block_values);
+	bool valid = static_cast<size_t>(block_values[0]) == size;
+	ASSERT(valid, ("UniformBlock: the size of \"" + block_name + "\" is " + std::to_string(block_values[0]) + " bytes in the shader, but " + std::to_string(size) + " bytes on the CPU.").c_str());
+
+	std::vector<GLint> variables(block_values[1]);
+	const GLenum active_variables = GL_ACTIVE_VARIABLES;
+	glGetProgramResourceiv(program, block_interface, block, 1, &active_variables, block_values[1], nullptr, variables.data());
+
+	std::vector<char> name(256);
+	for (GLint variable : variables) {
+		const GLenum props[] = { GL_OFFSET, GL_TYPE, GL_ARRAY_SIZE, GL_ARRAY_STRIDE };
+		GLint values[4] = { 0, 0, 0, 0 };
+		glGetProgramResourceiv(program, variable_interface, variable, 4, props, 4, nullptr, values);
+		glGetProgramResourceName(program, variable_interface, variable, static_cast<GLsizei>(name.size()), nullptr, name.data());
+		const std::string variable_name = name.data();
+
+		auto leaf = std::find_if(leaves.begin(), leaves.end(), [&](const BlockLeaf& l) { return l.offset == static_cast<size_t>(values[0]); });
+		if (leaf == leaves.end()) {
+			ASSERT(false, ("UniformBlock: no member of the C++ struct is at the offset of \"" + variable_name + "\" (" + std::to_string(values[0]) + ") in block \"" + block_name + "\".").c_str());
+			valid = false;
+			continue;
+		}
+		const bool same_type = leaf->type == static_cast<GLenum>(values[1]);
+		ASSERT(same_type, ("UniformBlock: \"" + variable_name + "\" in block \"" + block_name + "\" has a different type in the shader (GLenum " + std::to_string(values[1]) + ").").c_str());
+		const bool same_array = values[2] <= 1 || (leaf->array_size == static_cast<size_t>(values[2]) && leaf->array_stride == static_cast<size_t>(values[3]));
+		ASSERT(same_array, ("UniformBlock: the array \"" + variable_name + "\" in block \"" + block_name + "\" has a different size or stride in the shader.").c_str());
+		valid = valid && same_type && same_array;
+	}
+	return valid;
+}
@@ -0,0 +1,324 @@
+#pragma once
+#include "../buffer.h"
+#include "../Traits/UniformTypes.hpp"
+#include <glm/glm.hpp>
+#include <type_traits>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <array>
+#include <tuple>
+
+namespace df
+{
+
+enum class BlockLayout { STD140, STD430 };
+
+namespace detail
+{
+/****************************************************************************
+ *						std140/std430 layout of C++ types					*/
+// Base alignment, size and array stride of a type in a block, computed at compile time.
+// Supported: GLfloat, GLdouble, GLint, GLuint, glm vectors and matrices of these, std::array and
+// C arrays, and structs that list their members in a 'block_fields' tuple (see UniformBlock).
+
+constexpr size_t round_up(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+template<typename T, typename = void> struct has_block_fields : std::false_type {};
+template<typename T> struct has_block_fields<T, std::void_t<decltype(T::block_fields)>> : std::true_type {};
+
+template<typename M> struct member_type;
+template<typename C, typename T> struct member_type<T C::*> { using type = T; };
+template<typename M> using member_type_t = typename member_type<std::decay_t<M>>::type;
+
+// One leaf (non-struct) variable of the block, as the GL reflects it
+struct BlockLeaf { size_t offset; GLenum type; size_t array_size; size_t array_stride; };
+
+template<BlockLayout L, typename T, typename = void>
+struct BlockTypeLayout {
+	static_assert(has_block_fields<T>::value, "UniformBlock: unsupported member type. Use GLfloat, GLdouble, GLint, GLuint, glm vectors, matrices, arrays or structs with 'block_fields'.");
+};
+
+template<BlockLayout L, typename T> // scalars
+struct BlockTypeLayout<L, T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+	static_assert(std::is_same_v<T, GLfloat> || std::is_same_v<T, GLdouble> || std::is_same_v<T, GLint> || std::is_same_v<T, GLuint>, "UniformBlock: scalars can be GLfloat, GLdouble, GLint or GLuint (no bool).");
+	static constexpr size_t align = sizeof(T);
+	static constexpr size_t size = sizeof(T);
+	static void write(char* dst, const T& value) { std::memcpy(dst, &value, sizeof(T)); }
+	static void leaves(std::vector<BlockLeaf>& out, size_t offset) { out.push_back({ offset, getOpenGLType<T>(), 1, 0 }); }
+};
+
+template<BlockLayout L, glm::length_t N, typename T, glm::qualifier Q> // vectors
+struct BlockTypeLayout<L, glm::vec<N, T, Q>> {
+	static_assert(N >= 2 && N <= 4, "UniformBlock: vectors have 2, 3 or 4 components.");
+	static constexpr size_t align = BlockTypeLayout<L, T>::align * (N == 2 ? 2 : 4); // vec3 is aligned as vec4
+	static constexpr size_t size = sizeof(T) * N;
+	static void write(char* dst, const glm::vec<N, T, Q>& value) { std::memcpy(dst, &value[0], size); }
+	static void leaves(std::vector<BlockLeaf>& out, size_t offset) { out.push_back({ offset, getOpenGLType<glm::vec<N, T, glm::defaultp>>(), 1, 0 }); }
+};
+
+// Arrays (and matrix columns): the stride is the element size rounded up to its alignment,
+// and in std140 also to the alignment of a vec4.
+template<BlockLayout L, typename E>
+constexpr size_t block_array_align() { return L == BlockLayout::STD140 ? round_up(BlockTypeLayout<L, E>::align, 16) : BlockTypeLayout<L, E>::align; }
+template<BlockLayout L, typename E>
+constexpr size_t block_array_stride() { return round_up(BlockTypeLayout<L, E>::size, block_array_align<L, E>()); }
+
+template<BlockLayout L, glm::length_t C, glm::length_t R, typename T, glm::qualifier Q> // matrices: array of C column vectors
+struct BlockTypeLayout<L, glm::mat<C, R, T, Q>> {
+	using Column = glm::vec<R, T, Q>;
+	static constexpr size_t column_stride = block_array_stride<L, Column>();
+	static constexpr size_t align = block_array_align<L, Column>();
+	static constexpr size_t size = column_stride * C;
+	static void write(char* dst, const glm::mat<C, R, T, Q>& value) {
+		for (glm::length_t c = 0; c < C; ++c) BlockTypeLayout<L, Column>::write(dst + c * column_stride, value[c]);
+	}
+	static void leaves(std::vector<BlockLeaf>& out, size_t offset) { out.push_back({ offset, getOpenGLType<glm::mat<C, R, T, glm::defaultp>>(), 1, 0 }); }
+};
+
+template<BlockLayout L, typename E, size_t N> // arrays
+struct BlockArrayLayout {
+	static constexpr size_t stride = block_array_stride<L, E>();
+	static constexpr size_t align = block_array_align<L, E>();
+	static constexpr size_t size = stride * N;
+	static void write(char* dst, const E* values) {
+		for (size_t i = 0; i < N; ++i) BlockTypeLayout<L, E>::write(dst + i * stride, values[i]);
+	}
+	static void leaves(std::vector<BlockLeaf>& out, size_t offset) {
+		if constexpr (has_block_fields<E>::value || std::is_array_v<E>) // the GL reflects these element by element
+			for (size_t i = 0; i < N; ++i) BlockTypeLayout<L, E>::leaves(out, offset + i * stride);
+		else {
+			BlockTypeLayout<L, E>::leaves(out, offset);
+			out.back().array_size = N;
+			out.back().array_stride = stride;
+		}
+	}
+};
+template<BlockLayout L, typename E, size_t N>
+struct BlockTypeLayout<L, std::array<E, N>> : BlockArrayLayout<L, E, N> {
+	static void write(char* dst, const std::array<E, N>& value) { BlockArrayLayout<L, E, N>::write(dst, value.data()); }
+};
+template<BlockLayout L, typename E, size_t N>
+struct BlockTypeLayout<L, E[N]> : BlockArrayLayout<L, E, N> {
+	static void write(char* dst, const E(&value)[N]) { BlockArrayLayout<L, E, N>::write(dst, value); }
+};
+
+template<BlockLayout L, typename S> // structs with block_fields
+struct BlockTypeLayout<L, S, std::enable_if_t<has_block_fields<S>::value>> {
+	using Fields = std::decay_t<decltype(S::block_fields)>;
+	static constexpr size_t count = std::tuple_size_v<Fields>;
+	static_assert(count > 0, "UniformBlock: 'block_fields' cannot be empty.");
+	template<size_t I> using field_t = member_type_t<std::tuple_element_t<I, Fields>>;
+
+	template<size_t ... I>
+	static constexpr std::array<size_t, count + 2> compute(std::index_sequence<I...>) {
+		const size_t aligns[] = { BlockTypeLayout<L, field_t<I>>::align ... };
+		const size_t sizes[] = { BlockTypeLayout<L, field_t<I>>::size ... };
+		std::array<size_t, count + 2> result = {}; // offsets..., alignment, size
+		size_t offset = 0, max_align = L == BlockLayout::STD140 ? 16 : 1;
+		for (size_t i = 0; i < count; ++i) {
+			offset = round_up(offset, aligns[i]);
+			result[i] = offset;
+			offset += sizes[i];
+			max_align = max_align > aligns[i] ? max_align : aligns[i];
+		}
+		result[count] = max_align;
+		result[count + 1] = round_up(offset, max_align);
+		return result;
+	}
+	static constexpr std::array<size_t, count + 2> layout = compute(std::make_index_sequence<count>{});
+
+	template<size_t I> static constexpr size_t offset = layout[I];
+	static constexpr size_t align = layout[count];
+	static constexpr size_t size = layout[count + 1];
+
+	template<size_t I> static constexpr size_t field_size = BlockTypeLayout<L, field_t<I>>::size;
+	template<size_t I> static const field_t<I>& get(const S& value) { return value.*std::get<I>(S::block_fields); }
+
+	static void write(char* dst, const S& value) { write(dst, value, std::make_index_sequence<count>{}); }
+	template<size_t ... I>
+	static void write(char* dst, const S& value, std::index_sequence<I...>) {
+		(BlockTypeLayout<L, field_t<I>>::write(dst + offset<I>, get<I>(value)), ...);
+	}
+	static void leaves(std::vector<BlockLeaf>& out, size_t base) { leaves(out, base, std::make_index_sequence<count>{}); }
+	template<size_t ... I>
+	static void leaves(std::vector<BlockLeaf>& out, size_t base, std::index_sequence<I...>) {
+		(BlockTypeLayout<L, field_t<I>>::leaves(out, base + offset<I>), ...);
+	}
+
+	//Index of a member pointer in block_fields (count if it is not listed)
+	template<auto Member, size_t I = 0>
+	static constexpr size_t index_of() {
+		if constexpr (I == count) return count;
+		else {
+			if constexpr (std::is_same_v<std::decay_t<decltype(Member)>, std::tuple_element_t<I, Fields>>)
+				if (std::get<I>(S::block_fields) == Member) return I;
+			return index_of<Member, I + 1>();
+		}
+	}
+};
+
+bool ValidateBlockLayout(GLuint program, BlockLayout layout, const std::string& block_name, size_t size, const std::vector<BlockLeaf>& leaves);
+
+} // namespace detail
+
+/****************************************************************************
+ *						Typed uniform/storage block							*
+ ****************************************************************************/
+// A struct mirrored in a UBO (std140) or SSBO (std430). The offsets and padding of the GPU side
+// are computed at compile time from the member list, so the C++ struct can stay naturally packed:
+//	struct CameraData {
+//		glm::mat4 view_proj;	glm::vec3 eye;	GLfloat time;
+//		static constexpr auto block_fields = std::make_tuple(&CameraData::view_proj, &CameraData::eye, &CameraData::time);
+//	};
+//	UniformBlock<CameraData> camera;
+//	static_assert(UniformBlock<CameraData>::OffsetOf<&CameraData::eye>() == 64);
+//	camera.Validate(program, "Camera");		// once, after linking: compares to the reflected layout
+//	camera.Set<&CameraData::time>(t);		// only marks the bytes of 'time' dirty
+//	camera.Bind(0);							// uploads the dirty ranges, then binds the buffer
+// Assigning a whole struct only marks the members that actually changed.
+template<typename Struct_T, BlockLayout Layout_ = BlockLayout::STD140>
+class UniformBlock
+{
+	static_assert(std::is_trivially_copyable_v<Struct_T>, "UniformBlock: the struct has to be trivially copyable.");
+	static_assert(detail::has_block_fields<Struct_T>::value, "UniformBlock: the struct has to list its members in a static constexpr 'block_fields' tuple of member pointers.");
+public:
+	using Layout = detail::BlockTypeLayout<Layout_, Struct_T>;
+	static constexpr eltecg::ogl::BufferType BUFFER_TYPE = Layout_ == BlockLayout::STD140 ? eltecg::ogl::BufferType::UNIFORM_BUFFER : eltecg::ogl::BufferType::SHADER_STORAGE_BUFFER;
+	using BufferType = eltecg::ogl::Buffer<BUFFER_TYPE>;
+
+	//Size of the block on the GPU in bytes
+	static constexpr size_t SIZE = Layout::size;
+	//Byte offset of a member on the GPU
+	template<auto Member>
+	static constexpr size_t OffsetOf() { static_assert(Layout::template index_of<Member>() < Layout::count, "UniformBlock: the member is not listed in 'block_fields'."); return Layout::template offset<Layout::template index_of<Member>()>; }
+
+	UniformBlock(const Struct_T& value = Struct_T());
+
+	UniformBlock(const UniformBlock&) = delete;
+	UniformBlock& operator=(const UniformBlock&) = delete;
+	UniformBlock(UniformBlock&&) = default;
+	UniformBlock& operator=(UniformBlock&&) = default;
+
+	//Writes one member, marks it dirty if it changed
+	template<auto Member>
+	void Set(const detail::member_type_t<decltype(Member)>& value);
+	//Writes every member, marks the changed ones dirty
+	UniformBlock& operator= (const Struct_T& value);
+
+	const Struct_T& Get() const { return _value; }
+	bool IsDirty() const { return !_dirty.empty(); }
+
+	//Uploads the dirty byte ranges (ranges closer than 'merge_gap' bytes are uploaded together). Returns the uploaded bytes.
+	GLsizeiptr Flush(size_t merge_gap = 64);
+	//Flushes, then binds the block to the indexed binding point
+	void Bind(GLuint index);
+
+	//Compares the compile time layout to the one the program reflects for the named block. Call it after linking.
+	bool Validate(GLuint program, const std::string& block_name) const;
+
+	BufferType& GetBuffer() { return _buffer; }
+
+protected:
+	template<size_t I> void SetField(const typename Layout::template field_t<I>& value);
+	template<size_t ... I> void SetAll(const Struct_T& value, std::index_sequence<I...>);
+	void MarkDirty(size_t begin, size_t end);
+
+	Struct_T _value;
+	std::vector<char> _shadow;		// the GPU layout on the CPU
+	std::vector<std::pair<size_t, size_t>> _dirty;	// [begin, end) byte ranges, not sorted
+	BufferType _buffer;
+};
+
+template<typename Struct_T> using StorageBlock = UniformBlock<Struct_T, BlockLayout::STD430>;
+
+// **** Implementation ****
+
+template<typename Struct_T, BlockLayout Layout_>
+UniformBlock<Struct_T, Layout_>::UniformBlock(const Struct_T& value) : _value(value), _shadow(SIZE, 0)
+{
+	Layout::write(_shadow.data(), _value);
+	_buffer.constructImmutable(_shadow, eltecg::ogl::BufferFlags::DYNAMIC_STORAGE_BIT);
+}
+
+template<typename Struct_T, BlockLayout Layout_>
+template<size_t I>
+void UniformBlock<Struct_T, Layout_>::SetField(const typename Layout::template field_t<I>& value)
+{
+	using Field = typename Layout::template field_t<I>;
+	Field& field = _value.*std::get<I>(Struct_T::block_fields);
+	if (std::memcmp(&field, &value, sizeof(Field)) == 0) return;
+	std::memcpy(&field, &value, sizeof(Field)); // works for C arrays too
+	detail::BlockTypeLayout<Layout_, Field>::write(_shadow.data() + Layout::template offset<I>, field);
+	MarkDirty(Layout::template offset<I>, Layout::template offset<I> + Layout::template field_size<I>);
+}
+
+template<typename Struct_T, BlockLayout Layout_>
+template<auto Member>
+void UniformBlock<Struct_T, Layout_>::Set(const detail::member_type_t<decltype(Member)>& value)
+{
+	constexpr size_t index = Layout::template index_of<Member>();
+	static_assert(index < Layout::count, "UniformBlock: the member is not listed in 'block_fields'.");
+	SetField<index>(value);
+}
+
+template<typename Struct_T, BlockLayout Layout_>
+template<size_t ... I>
+void UniformBlock<Struct_T, Layout_>::SetAll(const Struct_T& value, std::index_sequence<I...>)
+{
+	(SetField<I>(value.*std::get<I>(Struct_T::block_fields)), ...);
+}
+
+template<typename Struct_T, BlockLayout Layout_>
+UniformBlock<Struct_T, Layout_>& UniformBlock<Struct_T, Layout_>::operator=(const Struct_T& value)
+{
+	SetAll(value, std::make_index_sequence<Layout::count>{});
+	return *this;
+}
+
+template<typename Struct_T, BlockLayout Layout_>
+void UniformBlock<Struct_T, Layout_>::MarkDirty(size_t begin, size_t end)
+{
+	for (auto& range : _dirty)
+		if (begin <= range.second && range.first <= end) { // touching an existing range
+			range.first = std::min(range.first, begin);
+			range.second = std::max(range.second, end);
+			return;
+		}
+	_dirty.emplace_back(begin, end);
+}
+
+template<typename Struct_T, BlockLayout Layout_>
+GLsizeiptr UniformBlock<Struct_T, Layout_>::Flush(size_t merge_gap)
+{
+	if (_dirty.empty()) return 0;
+	std::sort(_dirty.begin(), _dirty.end());
+	GLsizeiptr uploaded = 0;
+	for (size_t i = 0; i < _dirty.size(); ) {
+		size_t begin = _dirty[i].first, end = _dirty[i].second;
+		for (++i; i < _dirty.size() && _dirty[i].first <= end + merge_gap; ++i)
+			end = std::max(end, _dirty[i].second);
+		glNamedBufferSubData(_buffer, begin, end - begin, _shadow.data() + begin);
+		uploaded += end - begin;
+	}
+	_dirty.clear();
+	return uploaded;
+}
+
+template<typename Struct_T, BlockLayout Layout_>
+void UniformBlock<Struct_T, Layout_>::Bind(GLuint index)
+{
+	Flush();
+	_buffer.bindBufferRange(index);
+}
+
+template<typename Struct_T, BlockLayout Layout_>
+bool UniformBlock<Struct_T, Layout_>::Validate(GLuint program, const std::string& block_name) const
+{
+	std::vector<detail::BlockLeaf> leaves;
+	Layout::leaves(leaves, 0);
+	return detail::ValidateBlockLayout(program, Layout_, block_name, SIZE, leaves);
+}
+
+} //namespace df
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../../config.h"
+#include "../Buffer/GpuVector.h"
+#include <GL/glew.h>
+#include <vector>
+
+namespace df
+{
+
+//Layouts fixed by the GL spec (glDrawArraysIndirect and glDrawElementsIndirect)
+struct DrawArraysIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount = 1;
+	GLuint first = 0;
+	GLuint baseInstance = 0;
+};
+
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount = 1;
+	GLuint firstIndex = 0;
+	GLint  baseVertex = 0;
+	GLuint baseInstance = 0;
+};
+
+// Records draw commands into a DRAW_INDIRECT_BUFFER and submits them with a single
+// glMultiDraw*Indirect call through Program::operator<<. Every command uses the same VAO,
+// so the meshes have to share their vertex and index buffers (see VertexHeap/IndexHeap).
+//	DrawElementsIndirectRecorder bucket(shared_vao, GL_TRIANGLES, GL_UNSIGNED_INT);
+//	for (const Mesh& m : meshes) bucket.Add({ m.index_count, 1, m.first_index, m.base_vertex, 0 });
+//	program << bucket;	// uploads the commands if they changed, then one draw call
+// With SetCountBuffer the number of draws is read from a GPU buffer (eg. written by a culling
+// compute shader) using glMultiDraw*IndirectCount when ARB_indirect_parameters is available.
+template<typename Command_T>
+class DrawIndirectRecorder
+{
+public:
+	static constexpr bool IS_ELEMENTS = std::is_same_v<Command_T, DrawElementsIndirectCommand>;
+	static_assert(IS_ELEMENTS || std::is_same_v<Command_T, DrawArraysIndirectCommand>, "Unknown indirect command type.");
+
+	DrawIndirectRecorder(GLuint vao, GLenum mode, GLenum ibo_elem_type = GL_UNSIGNED_INT)
+		: _vao(vao), _mode(mode), _ibo(ibo_elem_type) {}
+
+	void Add(const Command_T& command) { _commands.push_back(command); _dirty = true; }
+	void Clear() { _commands.clear(); _dirty = true; }
+	//Direct access to the recorded commands, call MarkDirty after editing them. Upload replaces the GPU side with these.
+	std::vector<Command_T>& GetCommands() { return _commands; }
+	void MarkDirty() { _dirty = true; }
+	//Number of commands on the GPU (after Upload, or after resizing GetBuffer for GPU written commands)
+	size_t Size() const { return _gpu_commands.size(); }
+	bool Empty() const { return _gpu_commands.empty(); }
+
+	//Uploads the commands if they changed since the last upload (called by the draw too)
+	void Upload();
+
+	//Reads the draw count (GLuint) from 'buffer' at 'offset', drawing at most 'max_draw_count' commands. buffer == 0 turns it off.
+	void SetCountBuffer(GLuint buffer, GLintptr offset = 0, GLsizei max_draw_count = 0) { _count_buffer = buffer; _count_offset = offset; _max_draw_count = max_draw_count; }
+	//True if the count buffer is set and the IndirectCount draws are supported
+	bool UsesCountBuffer() const { return _count_buffer != 0 && (GLEW_ARB_indirect_parameters || GLEW_VERSION_4_6); }
+
+	//The commands on the GPU, eg. for a compute shader to write or compact them
+	eltecg::ogl::GpuVector<Command_T, eltecg::ogl::BufferType::DRAW_INDIRECT_BUFFER>& GetBuffer() { return _gpu_commands; }
+
+	const GLuint _vao;
+	const GLenum _mode;
+	const GLenum _ibo;	// ignored for DrawArraysIndirectCommand
+	GLuint		_count_buffer = 0;
+	GLintptr	_count_offset = 0;
+	GLsizei		_max_draw_count = 0;
+protected:
+	std::vector<Command_T> _commands;
+	eltecg::ogl::GpuVector<Command_T, eltecg::ogl::BufferType::DRAW_INDIRECT_BUFFER> _gpu_commands;
+	bool _dirty = false;
+};
+
+using DrawElementsIndirectRecorder = DrawIndirectRecorder<DrawElementsIndirectCommand>;
+using DrawArraysIndirectRecorder = DrawIndirectRecorder<DrawArraysIndirectCommand>;
+
+template<typename Command_T>
+inline void DrawIndirectRecorder<Command_T>::Upload()
+{
+	if (!_dirty) return;
+	_gpu_commands.clear();
+	_gpu_commands.append(_commands);
+	_dirty = false;
+}
+
+}
@@ -0,0 +1,9 @@
+#include "Vao.h"
+#include "../vao.h"
+
+using namespace df;
+
+GLuint df::NoVao::emptyVertexArray()
+{
+	return eltecg::ogl::VertexArray::getShared(eltecg::ogl::VertexFormat());
+}
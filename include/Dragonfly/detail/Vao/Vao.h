@@ -2,6 +2,8 @@
 
 #include "../../config.h"
 #include <GL/glew.h>
+#include <cstdint>
+#include <cstddef>
 
 namespace df
 {
@@ -12,25 +14,43 @@ struct VaoBase
 	const GLuint _id;
 	const GLenum _mode;
 	const GLenum _count;
+	const GLsizei _instance_count;	// 1: not instanced
+	const GLuint _base_instance;	// offsets the per-instance attributes (gl_InstanceID is not affected)
 	void bind() const {glBindVertexArray(_id);}
-	VaoBase(GLuint id, GLenum mode, GLsizei count) : _id(id), _mode(mode), _count(count) {}
+	bool isInstanced() const { return _instance_count != 1 || _base_instance != 0; }
+	VaoBase(GLuint id, GLenum mode, GLsizei count, GLsizei instance_count = 1, GLuint base_instance = 0)
+		: _id(id), _mode(mode), _count(count), _instance_count(instance_count), _base_instance(base_instance) {}
 };
 
+//For meshes packed into shared buffers: 'first_index' is counted in indices (not bytes) and 'base_vertex' is added to every index
 struct VaoElements : public VaoBase
 {
 	const GLenum _ibo;
-	VaoElements(GLuint id, GLenum mode, GLsizei count, GLenum ibo_elem_type) : VaoBase(id, mode, count), _ibo(ibo_elem_type) {}
+	const GLuint _first_index;
+	const GLint  _base_vertex;
+	VaoElements(GLuint id, GLenum mode, GLsizei count, GLenum ibo_elem_type, GLsizei instance_count = 1, GLuint base_instance = 0, GLuint first_index = 0, GLint base_vertex = 0)
+		: VaoBase(id, mode, count, instance_count, base_instance), _ibo(ibo_elem_type), _first_index(first_index), _base_vertex(base_vertex) {}
+	//Byte offset of the first index in the element buffer
+	const void* indexOffset() const {
+		const size_t index_size = _ibo == GL_UNSIGNED_BYTE ? 1 : _ibo == GL_UNSIGNED_SHORT ? 2 : 4;
+		return reinterpret_cast<const void*>(static_cast<uintptr_t>(_first_index * index_size));
+	}
 };
 
 struct VaoArrays : public VaoBase
 {
 	const GLint _first;
-	VaoArrays(GLuint id, GLenum mode, GLsizei count, GLint first) : VaoBase(id, mode, count), _first(first) {}
+	VaoArrays(GLuint id, GLenum mode, GLsizei count, GLint first, GLsizei instance_count = 1, GLuint base_instance = 0)
+		: VaoBase(id, mode, count, instance_count, base_instance), _first(first) {}
 };
 
+//Draws without vertex attributes (eg. vertex pulling, fullscreen triangles). The core profile has no default VAO, so an empty one is bound.
 struct NoVao : public VaoArrays
 {
-	NoVao(GLenum mode, GLsizei count, GLint first = 0) : VaoArrays(0, mode, count, first) {}
+	NoVao(GLenum mode, GLsizei count, GLint first = 0, GLsizei instance_count = 1, GLuint base_instance = 0)
+		: VaoArrays(emptyVertexArray(), mode, count, first, instance_count, base_instance) {}
+	//The shared VAO of the empty format
+	static GLuint emptyVertexArray();
 };
 
 
@@ -0,0 +1,221 @@
+#include "VertexPacking.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+	#define DF_VERTEX_PACKING_SSE2
+	#include <emmintrin.h>
+	#if defined(__F16C__) || defined(__AVX2__)
+		#define DF_VERTEX_PACKING_F16C
+		#include <immintrin.h>
+	#endif
+#endif
+
+using namespace eltecg::ogl;
+
+namespace {
+
+/****************************************************************************
+ *						Scalar reference versions							*/
+
+inline uint32_t asUint(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+inline float asFloat(uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+// Round to nearest even, overflow to infinity, NaN stays NaN (after F. Giesen's float_to_half_fast3_rtne)
+inline uint16_t floatToHalf(float value)
+{
+	const uint32_t f32infty = 255u << 23;
+	const uint32_t f16max = (127u + 16u) << 23;
+	const uint32_t denorm_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+	uint32_t f = asUint(value);
+	const uint32_t sign = f & 0x80000000u;
+	f ^= sign;
+	uint32_t o;
+	if (f >= f16max)
+		o = f > f32infty ? 0x7e00u : 0x7c00u;
+	else if (f < (113u << 23))	// subnormal or zero
+		o = asUint(asFloat(f) + asFloat(denorm_magic)) - denorm_magic;
+	else
+	{
+		const uint32_t mant_odd = (f >> 13) & 1u;
+		f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu;
+		f += mant_odd;
+		o = f >> 13;
+	}
+	return static_cast<uint16_t>(o | (sign >> 16));
+}
+
+template<typename T_int>
+inline T_int quantize(float value, float lo, float scale)
+{
+	return static_cast<T_int>(std::lrint(std::min(std::max(value, lo), 1.0f) * scale));
+}
+
+template<typename T_int>
+void quantizeScalar(const float* src, T_int* dst, size_t count, float lo, float scale)
+{
+	for (size_t i = 0; i < count; ++i) dst[i] = quantize<T_int>(src[i], lo, scale);
+}
+
+#ifdef DF_VERTEX_PACKING_SSE2
+/****************************************************************************
+ *						SSE2 versions										*/
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+
+//Same as floatToHalf on 4 values, result is in the low 16 bits of each lane
+inline __m128i floatToHalf4(__m128 value)
+{
+	const __m128i f16max = _mm_set1_epi32((127 + 16) << 23);
+	const __m128i f32infty = _mm_set1_epi32(255 << 23);
+	const __m128i denorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	__m128i f = _mm_castps_si128(value);
+	const __m128i sign = _mm_and_si128(f, _mm_set1_epi32(static_cast<int>(0x80000000u)));
+	f = _mm_xor_si128(f, sign);	// positive now, so the signed compares are fine
+
+	const __m128i is_infnan = _mm_cmpgt_epi32(f, _mm_sub_epi32(f16max, _mm_set1_epi32(1)));
+	const __m128i is_nan = _mm_cmpgt_epi32(f, f32infty);
+	const __m128i infnan = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, _mm_set1_epi32(0x0200)));
+
+	const __m128i is_subnormal = _mm_cmplt_epi32(f, _mm_set1_epi32(113 << 23));
+	const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(f), _mm_castsi128_ps(denorm_magic))), denorm_magic);
+
+	const __m128i mant_odd = _mm_and_si128(_mm_srli_epi32(f, 13), _mm_set1_epi32(1));
+	__m128i normal = _mm_add_epi32(f, _mm_set1_epi32(static_cast<int>((static_cast<uint32_t>(15 - 127) << 23) + 0xfffu)));
+	normal = _mm_srli_epi32(_mm_add_epi32(normal, mant_odd), 13);
+
+	__m128i o = select(is_subnormal, subnormal, normal);
+	o = select(is_infnan, infnan, o);
+	return _mm_or_si128(o, _mm_srli_epi32(sign, 16));
+}
+
+//Packs the low 16 bits of 8 lanes without saturation
+inline __m128i pack16(__m128i a, __m128i b)
+{
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+	return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32)), bias16);
+}
+
+//Clamps to [lo, 1], scales and rounds to nearest (the default MXCSR rounding)
+inline __m128i quantize4(const float* src, __m128 lo, __m128 scale)
+{
+	const __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), lo), _mm_set1_ps(1.0f));
+	return _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+}
+#endif
+
+} //namespace
+
+/****************************************************************************
+ *						Encoders											*/
+
+void eltecg::ogl::encodeHalf(const float* src, uint16_t* dst, size_t count)
+{
+	size_t i = 0;
+#if defined(DF_VERTEX_PACKING_F16C)
+	for (; i + 8 <= count; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(DF_VERTEX_PACKING_SSE2)
+	for (; i + 8 <= count; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pack16(floatToHalf4(_mm_loadu_ps(src + i)), floatToHalf4(_mm_loadu_ps(src + i + 4))));
+#endif
+	for (; i < count; ++i) dst[i] = floatToHalf(src[i]);
+}
+
+float eltecg::ogl::decodeHalf(uint16_t h)
+{
+	const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+	const uint32_t exponent = (h >> 10) & 0x1fu;
+	const uint32_t mantissa = h & 0x3ffu;
+	if (exponent == 0)	// zero or subnormal
+		return asFloat(sign | asUint(static_cast<float>(mantissa) * (1.0f / 16777216.0f)));
+	if (exponent == 31)	// inf or NaN
+		return asFloat(sign | 0x7f800000u | (mantissa << 13));
+	return asFloat(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+}
+
+void eltecg::ogl::encodeSnorm8(const float* src, int8_t* dst, size_t count)
+{
+	size_t i = 0;
+#ifdef DF_VERTEX_PACKING_SSE2
+	const __m128 lo = _mm_set1_ps(-1.0f), scale = _mm_set1_ps(127.0f);
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i a = _mm_packs_epi32(quantize4(src + i, lo, scale), quantize4(src + i + 4, lo, scale));
+		const __m128i b = _mm_packs_epi32(quantize4(src + i + 8, lo, scale), quantize4(src + i + 12, lo, scale));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi16(a, b));
+	}
+#endif
+	quantizeScalar(src + i, dst + i, count - i, -1.0f, 127.0f);
+}
+
+void eltecg::ogl::encodeSnorm16(const float* src, int16_t* dst, size_t count)
+{
+	size_t i = 0;
+#ifdef DF_VERTEX_PACKING_SSE2
+	const __m128 lo = _mm_set1_ps(-1.0f), scale = _mm_set1_ps(32767.0f);
+	for (; i + 8 <= count; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(quantize4(src + i, lo, scale), quantize4(src + i + 4, lo, scale)));
+#endif
+	quantizeScalar(src + i, dst + i, count - i, -1.0f, 32767.0f);
+}
+
+void eltecg::ogl::encodeUnorm8(const float* src, uint8_t* dst, size_t count)
+{
+	size_t i = 0;
+#ifdef DF_VERTEX_PACKING_SSE2
+	const __m128 lo = _mm_setzero_ps(), scale = _mm_set1_ps(255.0f);
+	for (; i + 16 <= count; i += 16)
+	{	// values are in [0, 255], the signed 32->16 pack cannot saturate them
+		const __m128i a = _mm_packs_epi32(quantize4(src + i, lo, scale), quantize4(src + i + 4, lo, scale));
+		const __m128i b = _mm_packs_epi32(quantize4(src + i + 8, lo, scale), quantize4(src + i + 12, lo, scale));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+	}
+#endif
+	quantizeScalar(src + i, dst + i, count - i, 0.0f, 255.0f);
+}
+
+void eltecg::ogl::encodeUnorm16(const float* src, uint16_t* dst, size_t count)
+{
+	size_t i = 0;
+#ifdef DF_VERTEX_PACKING_SSE2
+	const __m128 lo = _mm_setzero_ps(), scale = _mm_set1_ps(65535.0f);
+	for (; i + 8 <= count; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pack16(quantize4(src + i, lo, scale), quantize4(src + i + 4, lo, scale)));
+#endif
+	quantizeScalar(src + i, dst + i, count - i, 0.0f, 65535.0f);
+}
+
+namespace {
+	//x, y, z to 10 bits and w to 2 bits, 'lo' is -1 (snorm) or 0 (unorm)
+	template<typename Packed_T>
+	void encode2_10_10_10(const float* src, int src_components, Packed_T* dst, size_t count, float lo, float scale_xyz, float scale_w)
+	{
+		for (size_t i = 0; i < count; ++i, src += src_components)
+		{
+			float v[4] = { src[0], src[1], src[2], src_components == 4 ? src[3] : 0.0f };
+			int32_t q[4];
+#ifdef DF_VERTEX_PACKING_SSE2
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(q), quantize4(v, _mm_set1_ps(lo), _mm_setr_ps(scale_xyz, scale_xyz, scale_xyz, scale_w)));
+#else
+			for (int c = 0; c < 4; ++c) q[c] = quantize<int32_t>(v[c], lo, c < 3 ? scale_xyz : scale_w);
+#endif
+			dst[i].bits = (static_cast<uint32_t>(q[0]) & 0x3ffu) | ((static_cast<uint32_t>(q[1]) & 0x3ffu) << 10)
+				| ((static_cast<uint32_t>(q[2]) & 0x3ffu) << 20) | ((static_cast<uint32_t>(q[3]) & 0x3u) << 30);
+		}
+	}
+} //namespace
+
+void eltecg::ogl::encodeSnorm2_10_10_10(const float* src, int src_components, snorm_2_10_10_10_t* dst, size_t count)
+{
+	ASSERT(src_components == 3 || src_components == 4, "encodeSnorm2_10_10_10: the source has to have 3 or 4 components.");
+	encode2_10_10_10(src, src_components, dst, count, -1.0f, 511.0f, 1.0f);
+}
+
+void eltecg::ogl::encodeUnorm2_10_10_10(const float* src, int src_components, unorm_2_10_10_10_t* dst, size_t count)
+{
+	ASSERT(src_components == 3 || src_components == 4, "encodeUnorm2_10_10_10: the source has to have 3 or 4 components.");
+	encode2_10_10_10(src, src_components, dst, count, 0.0f, 1023.0f, 3.0f);
+}
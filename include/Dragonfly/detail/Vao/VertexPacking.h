@@ -0,0 +1,100 @@
+#pragma once
+#include "../Traits/InternalFormats.h"	// df::half, df::half2, ...
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include <type_traits>
+
+//namespace for opengl classes
+namespace eltecg { namespace ogl {
+
+/****************************************************************************
+ *						Packed vertex attribute types						*
+ ****************************************************************************/
+// These can be used directly in VertexArray::addVBO / VertexFormat::addBinding type lists.
+// The shader sees them as float vectors:
+//	df::half .. df::half4		GL_HALF_FLOAT, 1-4 components
+//	snorm8_t<N>, snorm16_t<N>	GL_BYTE/GL_SHORT normalized to [-1,1]
+//	unorm8_t<N>, unorm16_t<N>	GL_UNSIGNED_BYTE/GL_UNSIGNED_SHORT normalized to [0,1]
+//	snorm_2_10_10_10_t			GL_INT_2_10_10_10_REV normalized, xyz: 10 bits, w: 2 bits (normals, tangents with handedness)
+//	unorm_2_10_10_10_t			GL_UNSIGNED_INT_2_10_10_10_REV normalized
+// Keep attribute offsets and strides multiples of 4 bytes (eg. snorm8_t<4> instead of <3>), some drivers fall back to slow paths otherwise.
+
+template<int N> using snorm8_t  = glm::vec<N, int8_t>;
+template<int N> using snorm16_t = glm::vec<N, int16_t>;
+template<int N> using unorm8_t  = glm::vec<N, uint8_t>;
+template<int N> using unorm16_t = glm::vec<N, uint16_t>;
+
+struct snorm_2_10_10_10_t { uint32_t bits; };
+struct unorm_2_10_10_10_t { uint32_t bits; };
+
+/****************************************************************************
+ *						CPU encoders										*
+ ****************************************************************************/
+// Convert float data to the packed types above (SSE2, F16C for halves when the compiler targets it).
+// Values are clamped to the representable range and rounded to nearest.
+// The raw versions work on 'count' scalars, except the 2_10_10_10 ones that encode 'count' vectors
+// read from 'src' with 'src_components' (3 or 4, w = 0 if 3) floats each.
+
+void encodeHalf(const float* src, uint16_t* dst, size_t count);
+void encodeSnorm8(const float* src, int8_t* dst, size_t count);
+void encodeSnorm16(const float* src, int16_t* dst, size_t count);
+void encodeUnorm8(const float* src, uint8_t* dst, size_t count);
+void encodeUnorm16(const float* src, uint16_t* dst, size_t count);
+void encodeSnorm2_10_10_10(const float* src, int src_components, snorm_2_10_10_10_t* dst, size_t count);
+void encodeUnorm2_10_10_10(const float* src, int src_components, unorm_2_10_10_10_t* dst, size_t count);
+
+float decodeHalf(uint16_t h);
+
+//Encodes a whole float attribute stream, eg. encodeAttrib<df::half4>(positions) or encodeAttrib<snorm_2_10_10_10_t>(normals)
+template<typename Packed_T, typename Container>
+std::vector<Packed_T> encodeAttrib(const Container& src);
+
+/****************************************************************************
+ *						Implementation										*/
+
+namespace detail {
+	template<typename T> struct packed_components : std::integral_constant<int, 0> {};
+	template<> struct packed_components<df::half>  : std::integral_constant<int, 1> {};
+	template<> struct packed_components<df::half2> : std::integral_constant<int, 2> {};
+	template<> struct packed_components<df::half3> : std::integral_constant<int, 3> {};
+	template<> struct packed_components<df::half4> : std::integral_constant<int, 4> {};
+	template<int N, typename T> struct packed_components<glm::vec<N, T>> : std::integral_constant<int, N> {};
+	template<> struct packed_components<snorm_2_10_10_10_t> : std::integral_constant<int, 4> {};
+	template<> struct packed_components<unorm_2_10_10_10_t> : std::integral_constant<int, 4> {};
+
+	template<typename T> constexpr bool is_half_v = std::is_same_v<T, df::half> || std::is_same_v<T, df::half2> || std::is_same_v<T, df::half3> || std::is_same_v<T, df::half4>;
+} //namespace detail
+
+template<typename Packed_T, typename Container>
+inline std::vector<Packed_T> encodeAttrib(const Container& src)
+{
+	using source_t = std::decay_t<decltype(*src.data())>;
+	constexpr size_t src_components = sizeof(source_t) / sizeof(float);
+	constexpr int components = detail::packed_components<Packed_T>::value;
+	static_assert(components > 0, "Not a packed vertex attribute type.");
+	static_assert(sizeof(source_t) % sizeof(float) == 0, "The source has to consist of floats.");
+
+	std::vector<Packed_T> result(src.size());
+	const float* in = reinterpret_cast<const float*>(src.data());
+	if constexpr (std::is_same_v<Packed_T, snorm_2_10_10_10_t>)
+		encodeSnorm2_10_10_10(in, static_cast<int>(src_components), result.data(), src.size());
+	else if constexpr (std::is_same_v<Packed_T, unorm_2_10_10_10_t>)
+		encodeUnorm2_10_10_10(in, static_cast<int>(src_components), result.data(), src.size());
+	else
+	{
+		static_assert(src_components == components, "The source and the packed type must have the same number of components.");
+		const size_t count = src.size() * components;
+		void* out = result.data();
+		if constexpr (detail::is_half_v<Packed_T>)
+			encodeHalf(in, static_cast<uint16_t*>(out), count);
+		else if constexpr (std::is_same_v<Packed_T, snorm8_t<components>>)	encodeSnorm8(in, static_cast<int8_t*>(out), count);
+		else if constexpr (std::is_same_v<Packed_T, snorm16_t<components>>)	encodeSnorm16(in, static_cast<int16_t*>(out), count);
+		else if constexpr (std::is_same_v<Packed_T, unorm8_t<components>>)	encodeUnorm8(in, static_cast<uint8_t*>(out), count);
+		else if constexpr (std::is_same_v<Packed_T, unorm16_t<components>>)	encodeUnorm16(in, static_cast<uint16_t*>(out), count);
+		else static_assert(components < 0, "Unsupported packed vertex attribute type.");
+	}
+	return result;
+}
+
+}} //namespace eltecg::ogl
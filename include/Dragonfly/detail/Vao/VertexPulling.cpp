@@ -0,0 +1,99 @@
+#include "VertexPulling.h"
+
+using namespace df;
+
+namespace {
+
+const char* const pulling_helpers = R"GLSL(
+uint df_loadUnaligned(uint byte_offset)
+{
+	uint word = byte_offset >> 2u, shift = (byte_offset & 3u) * 8u;
+	return shift == 0u ? df_vertex_data[word] : (df_vertex_data[word] >> shift) | (df_vertex_data[word + 1u] << (32u - shift));
+}
+vec4 df_unpackSnorm2_10_10_10(uint w)
+{
+	ivec4 v = ivec4(bitfieldExtract(int(w), 0, 10), bitfieldExtract(int(w), 10, 10), bitfieldExtract(int(w), 20, 10), bitfieldExtract(int(w), 30, 2));
+	return max(vec4(v) / vec4(511.0, 511.0, 511.0, 1.0), vec4(-1.0));
+}
+vec4 df_unpackUnorm2_10_10_10(uint w)
+{
+	uvec4 v = uvec4(bitfieldExtract(w, 0, 10), bitfieldExtract(w, 10, 10), bitfieldExtract(w, 20, 10), bitfieldExtract(w, 30, 2));
+	return vec4(v) / vec4(1023.0, 1023.0, 1023.0, 3.0);
+}
+)GLSL";
+
+std::string glslType(const detail::PulledAttrib& attrib)
+{
+	const char* scalar = attrib.type == detail::PulledType::INT ? "int" : attrib.type == detail::PulledType::UINT ? "uint" : "float";
+	const char* vector = attrib.type == detail::PulledType::INT ? "ivec" : attrib.type == detail::PulledType::UINT ? "uvec" : "vec";
+	return attrib.components == 1 ? scalar : vector + std::to_string(attrib.components);
+}
+
+//The first 'components' of a vec4 expression
+std::string swizzle(const std::string& vec4_expr, int components)
+{
+	static const char* const masks[] = { "", ".x", ".xy", ".xyz", "" };
+	return "(" + vec4_expr + ")" + masks[components];
+}
+
+//Expression of the attribute of the vertex at 'o' (a GLSL uint: its first word if the stride is a multiple of 4, its first byte otherwise)
+std::string fetchExpression(const detail::PulledAttrib& attrib, bool aligned_stride)
+{
+	auto word = [&](GLuint byte) {	// the 4 bytes from 'offset + byte'
+		const GLuint offset = attrib.offset + byte;
+		if (!aligned_stride) return "df_loadUnaligned(o + " + std::to_string(offset) + "u)";
+		if (offset % 4 == 0) return "df_vertex_data[o + " + std::to_string(offset / 4) + "u]";
+		return "df_loadUnaligned(4u * o + " + std::to_string(offset) + "u)";
+	};
+	const int n = attrib.components;
+	std::string result = glslType(attrib) + "(";
+	auto pairs = [&](const char* unpack) {	// two components per word
+		if (n == 1) return std::string(unpack) + "(" + word(0) + ").x";
+		if (n == 2) return std::string(unpack) + "(" + word(0) + ")";
+		return std::string(unpack) + "(" + word(0) + "), " + unpack + "(" + word(4) + ")" + (n == 3 ? ".x" : "");
+	};
+	switch (attrib.type) {
+	case detail::PulledType::FLOAT:
+	case detail::PulledType::INT:
+	case detail::PulledType::UINT:
+		for (int k = 0; k < n; ++k) {
+			const std::string w = word(4 * k);
+			result += (k ? ", " : "") + (attrib.type == detail::PulledType::FLOAT ? "uintBitsToFloat(" + w + ")" : attrib.type == detail::PulledType::INT ? "int(" + w + ")" : w);
+		}
+		break;
+	case detail::PulledType::HALF:				result += pairs("unpackHalf2x16");	break;
+	case detail::PulledType::SNORM16:			result += pairs("unpackSnorm2x16");	break;
+	case detail::PulledType::UNORM16:			result += pairs("unpackUnorm2x16");	break;
+	case detail::PulledType::SNORM8:			result += swizzle("unpackSnorm4x8(" + word(0) + ")", n);	break;
+	case detail::PulledType::UNORM8:			result += swizzle("unpackUnorm4x8(" + word(0) + ")", n);	break;
+	case detail::PulledType::SNORM_2_10_10_10:	result += "df_unpackSnorm2_10_10_10(" + word(0) + ")";	break;
+	case detail::PulledType::UNORM_2_10_10_10:	result += "df_unpackUnorm2_10_10_10(" + word(0) + ")";	break;
+	}
+	return result + ")";
+}
+
+} //namespace
+
+std::string df::detail::vertexPullingSource(const std::vector<PulledAttrib>& attribs, GLuint stride, const VertexPullingSettings& settings)
+{
+	const bool aligned_stride = stride % 4 == 0;
+	std::string code = "// Generated by df::VertexPuller, vertices of " + std::to_string(stride) + " bytes\n";
+	code += "layout(std430, binding = " + std::to_string(settings.vertex_binding) + ") readonly buffer df_VertexBuffer { uint df_vertex_data[]; };\n";
+	if (settings.indexed) {
+		code += "layout(std430, binding = " + std::to_string(settings.index_binding) + ") readonly buffer df_IndexBuffer { uint df_index_data[]; };\n";
+		code += "uniform int df_base_vertex = 0;\n";
+	}
+	code += pulling_helpers;
+	code += "\nuint df_vertexIndex() { return " + std::string(settings.indexed ? "uint(int(df_index_data[gl_VertexID]) + df_base_vertex)" : "uint(gl_VertexID)") + "; }\n\n";
+
+	for (const PulledAttrib& attrib : attribs)
+		code += glslType(attrib) + " df_fetch_" + attrib.name + "(uint vertex) { uint o = vertex * " + std::to_string(aligned_stride ? stride / 4 : stride)
+			+ "u; return " + fetchExpression(attrib, aligned_stride) + "; }\n";
+	code += "\n";
+	for (const PulledAttrib& attrib : attribs)
+		code += glslType(attrib) + " " + attrib.name + ";\n";
+	code += "\nvoid df_pullVertex()\n{\n\tuint vertex = df_vertexIndex();\n";
+	for (const PulledAttrib& attrib : attribs)
+		code += "\t" + attrib.name + " = df_fetch_" + attrib.name + "(vertex);\n";
+	return code + "}\n";
+}
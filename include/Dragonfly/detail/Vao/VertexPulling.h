@@ -0,0 +1,144 @@
+#pragma once
+#include "../../config.h"
+#include "../vao.h"
+#include "../Program/ProgramFwd.h"
+#include "Vao.h"
+#include <array>
+#include <string>
+#include <vector>
+
+namespace df
+{
+
+/****************************************************************************
+ *						Programmable vertex pulling							*
+ ****************************************************************************/
+// Instead of VAO attributes, the vertex shader reads the vertices from a ShaderStorageBuffer by gl_VertexID
+// (through an index buffer that is an SSBO too). The layout is the one of addVBO<T...>, packed types included,
+// so the same interleaved data (eg. from loadMesh or loadMeshCached) works both ways.
+// The generated GLSL declares the named attributes as globals and df_pullVertex() fills them:
+//	df::VertexPuller<glm::vec3, eltecg::ogl::snorm_2_10_10_10_t, df::half2> puller({ "vs_in_pos", "vs_in_norm", "vs_in_tex" });
+//	program << puller.Vert() << "Shaders/mesh.vert"_vert << "Shaders/mesh.frag"_frag << df::LinkProgram;
+//	... in mesh.vert, without the 'in' declarations:	void main() { df_pullVertex(); gl_Position = ...vs_in_pos...; }
+//	puller.Bind(vertex_ssbo, index_ssbo);
+//	program << "df_base_vertex" << base_vertex << puller.Draw(index_count, first_index);
+// There is no VAO state to set up, meshes with any layout can share one draw path and one mega buffer.
+// Attribute offsets do not need to be aligned, but 4 byte aligned ones read a single word. If the stride is not
+// a multiple of 4, pad the vertex buffer to a multiple of 4 bytes (the last attribute may read the word after it).
+
+struct VertexPullingSettings
+{
+	GLuint	vertex_binding = 6;	// SSBO binding points
+	GLuint	index_binding = 7;
+	bool	indexed = true;		// false: vertex = gl_VertexID
+};
+
+namespace detail {
+	enum class PulledType { FLOAT, HALF, SNORM8, UNORM8, SNORM16, UNORM16, SNORM_2_10_10_10, UNORM_2_10_10_10, INT, UINT };
+
+	struct PulledAttrib
+	{
+		PulledType	type;
+		int			components;
+		GLuint		offset;		// in bytes inside the vertex
+		std::string	name;
+	};
+
+	//GLSL for the attributes of a vertex of 'stride' bytes
+	std::string vertexPullingSource(const std::vector<PulledAttrib>& attribs, GLuint stride, const VertexPullingSettings& settings);
+
+	template<typename T> struct pulled_format { static_assert(sizeof(T) == 0, "Vertex pulling: unsupported attribute type."); };
+	template<int N, typename T> struct pulled_format<glm::vec<N, T>> { static constexpr int components = N; static constexpr PulledType type = pulled_format<T>::type; };
+	template<> struct pulled_format<float>		{ static constexpr int components = 1; static constexpr PulledType type = PulledType::FLOAT; };
+	template<> struct pulled_format<int8_t>		{ static constexpr int components = 1; static constexpr PulledType type = PulledType::SNORM8; };
+	template<> struct pulled_format<uint8_t>	{ static constexpr int components = 1; static constexpr PulledType type = PulledType::UNORM8; };
+	template<> struct pulled_format<int16_t>	{ static constexpr int components = 1; static constexpr PulledType type = PulledType::SNORM16; };
+	template<> struct pulled_format<uint16_t>	{ static constexpr int components = 1; static constexpr PulledType type = PulledType::UNORM16; };
+	template<> struct pulled_format<df::half>	{ static constexpr int components = 1; static constexpr PulledType type = PulledType::HALF; };
+	template<> struct pulled_format<df::half2>	{ static constexpr int components = 2; static constexpr PulledType type = PulledType::HALF; };
+	template<> struct pulled_format<df::half3>	{ static constexpr int components = 3; static constexpr PulledType type = PulledType::HALF; };
+	template<> struct pulled_format<df::half4>	{ static constexpr int components = 4; static constexpr PulledType type = PulledType::HALF; };
+	template<> struct pulled_format<eltecg::ogl::snorm_2_10_10_10_t> { static constexpr int components = 4; static constexpr PulledType type = PulledType::SNORM_2_10_10_10; };
+	template<> struct pulled_format<eltecg::ogl::unorm_2_10_10_10_t> { static constexpr int components = 4; static constexpr PulledType type = PulledType::UNORM_2_10_10_10; };
+
+	//integral_t attributes stay integers, other integer types are normalized like in the VAO path
+	template<typename T> struct pulled_integer {
+		static_assert(sizeof(T) == 4 && std::is_integral_v<T>, "Vertex pulling: integer attributes have to be 32 bit.");
+		static constexpr int components = 1;
+		static constexpr PulledType type = std::is_signed_v<T> ? PulledType::INT : PulledType::UINT;
+	};
+	template<int N, typename T> struct pulled_integer<glm::vec<N, T>> { static constexpr int components = N; static constexpr PulledType type = pulled_integer<T>::type; };
+	template<typename T> struct pulled_format<eltecg::ogl::integral_t<T>> : pulled_integer<T> {};
+
+	template<typename T_attrib>
+	void addPulledAttrib(std::vector<PulledAttrib>& attribs, GLuint& offset, const std::string& name)
+	{
+		if constexpr (!eltecg::ogl::is_dummy_t_v<T_attrib>) {
+			static_assert(std::is_same_v<eltecg::ogl::strip_instanced_t_t<T_attrib>, std::decay_t<T_attrib>>,
+				"Vertex pulling: instanced_t attributes are not supported, index them with gl_InstanceID in the shader instead.");
+			using format = pulled_format<std::decay_t<T_attrib>>;
+			attribs.push_back({ format::type, format::components, offset, name });
+		}
+		offset += sizeof(T_attrib);
+	}
+} //namespace detail
+
+template<typename ... T_vertex_types>
+class VertexPuller
+{
+public:
+	static constexpr size_t ATTRIB_COUNT = sizeof...(T_vertex_types);
+
+	//One GLSL name per type, the ones of dummy_t types are not used
+	explicit VertexPuller(const std::array<std::string, ATTRIB_COUNT>& names, const VertexPullingSettings& settings = VertexPullingSettings());
+
+	inline const std::string& GetSource() const { return _source; }
+	//The generated code as a vertex shader source: program << puller.Vert(). Has to come before the code that uses it.
+	inline detail::_GeneratedShader Vert() const { return { GL_VERTEX_SHADER, "VertexPuller.vert", _source }; }
+
+	//Binds the vertex data (and the indices) to the SSBO binding points, 'vertex_offset' and 'index_offset' in bytes
+	void Bind(eltecg::ogl::ShaderStorageBuffer& vertices, GLintptr vertex_offset = 0) const;
+	void Bind(eltecg::ogl::ShaderStorageBuffer& vertices, eltecg::ogl::ShaderStorageBuffer& indices, GLintptr vertex_offset = 0, GLintptr index_offset = 0) const;
+
+	//Draw of 'count' indices from 'first' (or vertices without indices). Set "df_base_vertex" on the program for base vertices.
+	inline NoVao Draw(GLsizei count, GLint first = 0, GLenum mode = GL_TRIANGLES, GLsizei instance_count = 1, GLuint base_instance = 0) const
+	{
+		return NoVao(mode, count, first, instance_count, base_instance);
+	}
+
+	inline GLsizei GetStride() const { return static_cast<GLsizei>((0 + ... + sizeof(T_vertex_types))); }
+
+private:
+	VertexPullingSettings _settings;
+	std::string _source;
+};
+
+/****************************************************************************
+ *						Implementation										*/
+
+template<typename ... T_vertex_types>
+inline VertexPuller<T_vertex_types...>::VertexPuller(const std::array<std::string, ATTRIB_COUNT>& names, const VertexPullingSettings& settings)
+	: _settings(settings)
+{
+	std::vector<detail::PulledAttrib> attribs;
+	GLuint offset = 0;
+	size_t i = 0;
+	(detail::addPulledAttrib<T_vertex_types>(attribs, offset, names[i++]), ...);
+	_source = detail::vertexPullingSource(attribs, offset, settings);
+}
+
+template<typename ... T_vertex_types>
+inline void VertexPuller<T_vertex_types...>::Bind(eltecg::ogl::ShaderStorageBuffer& vertices, GLintptr vertex_offset) const
+{
+	vertices.bindBufferRange(_settings.vertex_binding, vertex_offset, vertices.getSize() - vertex_offset);
+}
+
+template<typename ... T_vertex_types>
+inline void VertexPuller<T_vertex_types...>::Bind(eltecg::ogl::ShaderStorageBuffer& vertices, eltecg::ogl::ShaderStorageBuffer& indices, GLintptr vertex_offset, GLintptr index_offset) const
+{
+	ASSERT(_settings.indexed, "VertexPuller: the indices are not used without VertexPullingSettings::indexed.");
+	vertices.bindBufferRange(_settings.vertex_binding, vertex_offset, vertices.getSize() - vertex_offset);
+	indices.bindBufferRange(_settings.index_binding, index_offset, indices.getSize() - index_offset);
+}
+
+} //namespace df
@@ -41,6 +41,8 @@ ENUM_CLASS_FLAG_OPERATORS(BufferFlags)
  *						OpenGL Buffer base class							*
  ****************************************************************************/
 //https://www.khronos.org/opengl/wiki/Buffer_Object
+// Every edit goes through Direct State Access (glNamedBuffer*), so uploads never touch the bindings.
+// bindBuffer() is only needed when a buffer has to be bound for a non-DSA call.
 template<BufferType T_buffer_type>
 	class Buffer final
 		: public base::Object
@@ -76,27 +78,59 @@ public:
 	void constructImmutable(const Container &container, BufferFlags flags = BufferFlags::NONE)
 	{
 		//TODO assert valid flags (attention!)
-		bindBuffer();
 		this->m_buffer_size = container.size()*sizeof(Container::value_type);
-		glBufferStorage(GLtype(), this->m_buffer_size,
+		glNamedBufferStorage(this->object_id, this->m_buffer_size,
 			(GLvoid*) container.data(), static_cast<GLbitfield>(flags));
 	}
 
 	template<typename Container>
 	void constructMutable(const Container &container, GLenum usage) //TODO: make 'usage' easier
 	{
-		bindBuffer();
 		this->m_buffer_size = container.size()*sizeof(Container::value_type);
-		glBufferData(this->GLtype(), this->m_buffer_size , (GLvoid*) container.data(), usage);
+		glNamedBufferData(this->object_id, this->m_buffer_size , (GLvoid*) container.data(), usage);
 	}
 
 	template<typename Container>	//todo make it work with c array, std::array and std::vector
 	void assignMutable(const Container &container, size_t offset = 0)
 	{
-		bindBuffer();
 		size_t to_write = container.size() * sizeof(Container::value_type);
-		ASSERT(offset + to_write < this->m_buffer_size, "Container to be assigned is larger then it should be!");
-		glBufferSubData(GLtype(), offset, to_write, (GLvoid*) container.data());
+		ASSERT(offset + to_write <= this->m_buffer_size, "Container to be assigned is larger then it should be!");
+		glNamedBufferSubData(this->object_id, offset, to_write, (GLvoid*) container.data());
+	}
+
+	//Allocates 'size' bytes of immutable storage without uploading anything (eg. for persistent mapping)
+	void allocateImmutable(GLsizeiptr size, BufferFlags flags = BufferFlags::NONE)
+	{
+		this->m_buffer_size = size;
+		glNamedBufferStorage(this->object_id, this->m_buffer_size, nullptr, static_cast<GLbitfield>(flags));
+	}
+
+	inline GLsizeiptr getSize() const { return m_buffer_size; }
+
+/****************************************************************************
+ *						Mapping												*/
+
+	inline void* mapBufferRange(GLintptr offset, GLsizeiptr length, GLbitfield access)
+	{
+		ASSERT(offset + length <= this->m_buffer_size, "Mapped range is outside of the buffer.");
+		return glMapNamedBufferRange(this->object_id, offset, length, access);
+	}
+
+	inline bool unmapBuffer()
+	{
+		return glUnmapNamedBuffer(this->object_id) == GL_TRUE;
+	}
+
+/****************************************************************************
+ *						Copying												*/
+
+	//Copies a range of another buffer into this one (GPU side, no bindings involved)
+	template<BufferType T_other_type>
+	void copyBufferSubData(const Buffer<T_other_type>& source, GLintptr read_offset, GLintptr write_offset, GLsizeiptr size)
+	{
+		ASSERT(read_offset + size <= source.getSize() && write_offset + size <= this->m_buffer_size, "Copied range is outside of the buffer.");
+		ASSERT((GLuint)source != this->object_id || read_offset + size <= write_offset || write_offset + size <= read_offset, "Copied ranges overlap in the same buffer.");
+		glCopyNamedBufferSubData(source, this->object_id, read_offset, write_offset, size);
 	}
 	
 /****************************************************************************
@@ -104,7 +138,11 @@ public:
 
 	inline void bindBuffer()
 	{	
-		if(this->s_bound_buffer_id() != this->object_id)
+		if constexpr (T_buffer_type == BufferType::ELEMENT_ARRAY_BUFFER)
+		{	// the element buffer binding is part of the VAO state, caching it globally is wrong
+			glBindBuffer(GLtype(), this->object_id);
+		}
+		else if(this->s_bound_buffer_id() != this->object_id)
 		{
 			glBindBuffer(GLtype(), this->object_id);
 			this->s_bound_buffer_id() = this->object_id;
@@ -118,8 +156,9 @@ public:
 			|| T_buffer_type == BufferType::ATOMIC_COUNTER_BUFFER
 			|| T_buffer_type == BufferType::SHADER_STORAGE_BUFFER, "Invalid buffer type for binding buffer range.");
 		glBindBufferRange(GLtype(), index, this->object_id, offset, size == 0 ? this->m_buffer_size: size);
+		this->s_bound_buffer_id() = this->object_id; // glBindBufferRange binds the generic binding point too
 	}
-	//TODO: Multibind with glBindBuffersRange (note 's' in Buffers).
+	//For binding many ranges at once (glBindBuffersRange), see BindingTable in Buffer/BindingTable.h
 	
 protected:
 
@@ -151,7 +190,7 @@ inline Buffer<T_buffer_type>::Buffer()
 		|| T_buffer_type == BufferType::TRANSFORM_FEEDBACK_BUFFER
 		|| T_buffer_type == BufferType::UNIFORM_BUFFER, "Invalid buffer type.");
 
-	glGenBuffers(1, &this->object_id);
+	glCreateBuffers(1, &this->object_id);
 }
 template<BufferType T_buffer_type>
 inline Buffer<T_buffer_type>::~Buffer()
@@ -3,9 +3,12 @@
 #include "buffer.h"
 #include <glm/glm.hpp>
 #include <GL/glew.h>
-#include <iostream>
-#include <typeinfo>
+#include <vector>
+#include <map>
+#include <memory>
+#include <tuple>
 #include "Traits/UniformTypes.hpp" //glm -> ogl type conversion ... TODO refactor
+#include "Vao/VertexPacking.h"
 
 //namespace for opengl classes
 namespace eltecg { namespace ogl {
@@ -19,6 +22,164 @@ struct dummy_t{T_type dummy; using type = T_type;};
 template<typename T_integral> //TODO: check valid types!
 struct integral_t{T_integral dummy; using type = T_integral;};
 
+//Per-instance attribute: advances once every 'divisor' instances instead of every vertex.
+//Every attribute of one addVBO/addBinding type list has to have the same divisor (it belongs to the buffer binding).
+template<typename T_type, GLuint divisor = 1>
+struct instanced_t{T_type dummy; using type = T_type;};
+
+template<typename D> struct is_dummy_t : std::false_type{};
+template<typename T> struct is_dummy_t<dummy_t<T>> : std::true_type{};
+template<typename D> constexpr bool is_dummy_t_v = is_dummy_t< std::decay_t<D>>::value;
+
+template<typename D> struct is_integral_t : std::false_type {};
+template<typename T> struct is_integral_t<integral_t<T>> : std::true_type {};
+template<typename D> constexpr bool is_integral_t_v = is_integral_t< std::decay_t<D>>::value;
+
+template<typename D> struct attrib_divisor : std::integral_constant<GLuint, 0> {};
+template<typename T, GLuint divisor> struct attrib_divisor<instanced_t<T, divisor>> : std::integral_constant<GLuint, divisor> {};
+template<typename D> constexpr GLuint attrib_divisor_v = attrib_divisor< std::decay_t<D>>::value;
+
+template<typename T> struct strip_instanced_t { using type = T; };
+template<typename T, GLuint divisor> struct strip_instanced_t<instanced_t<T, divisor>> { using type = T; };
+template<typename T> using strip_instanced_t_t = typename strip_instanced_t<std::decay_t<T>>::type;
+
+//Strips the marker types (integral_t, instanced_t, ...) to get the type that is actually stored
+template<typename T> struct unwrap_attrib_type { using type = T; };
+template<typename T> struct unwrap_attrib_type<integral_t<T>> { using type = T; };
+template<typename T, GLuint divisor> struct unwrap_attrib_type<instanced_t<T, divisor>> { using type = typename unwrap_attrib_type<T>::type; };
+template<typename T> using unwrap_attrib_type_t = typename unwrap_attrib_type<std::decay_t<T>>::type;
+
+template <typename T> struct as_array_type { using type = T; };
+template <typename T> struct as_array_type<glm::vec<1, T>> { using type = T[1]; };
+template <typename T> struct as_array_type<glm::vec<2, T>> { using type = T[2]; };
+template <typename T> struct as_array_type<glm::vec<3, T>> { using type = T[3]; };
+template <typename T> struct as_array_type<glm::vec<4, T>> { using type = T[4]; };
+template <typename T> using as_array_type_t = typename as_array_type<std::decay_t<T>>::type;
+
+/****************************************************************************
+ *						Vertex format										*
+ ****************************************************************************/
+
+//One vertex attribute as given to glVertexArrayAttrib{,I,L}Format and glVertexArrayAttribBinding
+struct VertexAttribFormat
+{
+	enum class Kind : GLubyte { FLOAT, INTEGER, DOUBLE };
+	GLuint		index;
+	GLint		components;
+	GLenum		type;
+	GLboolean	normalized;
+	Kind		kind;
+	GLuint		relative_offset;
+	GLuint		binding;
+
+	auto tie() const { return std::tie(index, components, type, normalized, kind, relative_offset, binding); }
+	bool operator==(const VertexAttribFormat& o) const { return tie() == o.tie(); }
+	bool operator<(const VertexAttribFormat& o) const { return tie() < o.tie(); }
+};
+
+// The layout of the vertices without the buffers (ARB_vertex_attrib_binding). The type lists of
+// addBinding<T...> describe one interleaved buffer each, attribute indices are assigned in order.
+// Meshes with the same format can share one VAO and only swap the vertex buffers:
+//	VertexArray& vao = VertexArray::getShared<glm::vec3, glm::vec3, glm::vec2>();
+//	vao.setVertexBuffer(0, mesh.vbo); vao.addIBO(mesh.ibo);
+class VertexFormat final
+{
+public:
+	//The format built from a single type list, built once per type signature
+	template<typename ... T_vertex_types>
+	static const VertexFormat& get() { static const VertexFormat format = VertexFormat().addBinding<T_vertex_types...>(); return format; }
+
+	//Appends a new buffer binding point with the attributes described by the type list
+	template<typename ... T_vertex_types>
+	VertexFormat& addBinding();
+
+	inline const std::vector<VertexAttribFormat>& getAttribs() const { return _attribs; }
+	inline GLuint getBindingCount() const { return static_cast<GLuint>(_strides.size()); }
+	inline GLsizei getStride(GLuint binding) const { return _strides[binding]; }
+	//0 for per-vertex bindings, see instanced_t
+	inline GLuint getDivisor(GLuint binding) const { return _divisors[binding]; }
+
+	bool operator==(const VertexFormat& o) const { return _attribs == o._attribs && _strides == o._strides && _divisors == o._divisors; }
+	bool operator<(const VertexFormat& o) const { return std::tie(_attribs, _strides, _divisors) < std::tie(o._attribs, o._strides, o._divisors); }
+
+protected:
+	template<typename T_attrib>
+	void addAttrib(GLuint binding, GLuint& offset);
+
+	std::vector<VertexAttribFormat> _attribs;
+	std::vector<GLsizei> _strides;	// per binding
+	std::vector<GLuint> _divisors;	// per binding
+};
+
+namespace detail {
+	//The common divisor of the non-dummy attributes in a binding, or ~0u if they differ
+	template<typename ... T_vertex_types>
+	constexpr GLuint binding_divisor()
+	{
+		constexpr GLuint divisors[] = { attrib_divisor_v<T_vertex_types>... };
+		constexpr bool dummies[] = { is_dummy_t_v<T_vertex_types>... };
+		GLuint divisor = ~0u;
+		for (size_t i = 0; i < sizeof...(T_vertex_types); ++i)
+			if (!dummies[i] && divisor == ~0u) divisor = divisors[i];
+			else if (!dummies[i] && divisor != divisors[i]) return ~0u;
+		return divisor == ~0u ? 0 : divisor;
+	}
+} //namespace detail
+
+template<typename ...T_vertex_types>
+inline VertexFormat& VertexFormat::addBinding()
+{
+	static_assert(sizeof...(T_vertex_types) > 0, "A binding needs at least one attribute.");
+	constexpr GLuint divisor = detail::binding_divisor<T_vertex_types...>();
+	static_assert(divisor != ~0u, "Per-vertex and per-instance attributes (or different divisors) cannot share a buffer binding.");
+	const GLuint binding = getBindingCount();
+	_strides.push_back(static_cast<GLsizei>((0 + ... + sizeof(T_vertex_types))));
+	_divisors.push_back(divisor);
+	GLuint offset = 0;
+	(addAttrib<T_vertex_types>(binding, offset), ...);
+	return *this;
+}
+
+template<typename T_attrib>
+inline void VertexFormat::addAttrib(GLuint binding, GLuint& offset)
+{
+	if constexpr (!is_dummy_t_v<T_attrib>)
+	{
+		using stored_t = unwrap_attrib_type_t<T_attrib>;
+		using attib_t = as_array_type_t<stored_t>;
+		using base_t = std::remove_pointer_t<std::remove_all_extents_t<attib_t>>;
+		const GLuint index = static_cast<GLuint>(_attribs.size());
+
+		if constexpr (detail::is_half_v<stored_t>)
+		{	// df::half .. df::half4
+			_attribs.push_back({ index, detail::packed_components<stored_t>::value, GL_HALF_FLOAT, GL_FALSE, VertexAttribFormat::Kind::FLOAT, offset, binding });
+		}
+		else if constexpr (std::is_same_v<stored_t, snorm_2_10_10_10_t> || std::is_same_v<stored_t, unorm_2_10_10_10_t>)
+		{
+			constexpr GLenum packed_t = std::is_same_v<stored_t, snorm_2_10_10_10_t> ? GL_INT_2_10_10_10_REV : GL_UNSIGNED_INT_2_10_10_10_REV;
+			_attribs.push_back({ index, 4, packed_t, GL_TRUE, VertexAttribFormat::Kind::FLOAT, offset, binding });
+		}
+		else
+		{
+			constexpr GLenum	ogl_base_t = df::getOpenGLType<base_t>();
+			constexpr GLint		components = std::extent_v<attib_t> > 0 ? static_cast<GLint>(std::extent_v<attib_t>) : 1;
+			static_assert(1 <= components && components <= 4, "A vertex attribute has 1 to 4 components.");
+
+			// integer types that are not integral_t are fetched as normalized floats (snorm/unorm)
+			VertexAttribFormat attrib{ index, components, ogl_base_t, std::is_integral_v<base_t> ? GL_TRUE : GL_FALSE, VertexAttribFormat::Kind::FLOAT, offset, binding };
+			if constexpr (std::is_same_v<base_t, double>)
+			{	// double only
+				static_assert(ogl_base_t == GL_DOUBLE, "This should be double!");
+				attrib.kind = VertexAttribFormat::Kind::DOUBLE;
+			}
+			else if constexpr (is_integral_t_v<strip_instanced_t_t<T_attrib>> && std::is_integral_v<base_t>)
+				attrib.kind = VertexAttribFormat::Kind::INTEGER;
+			_attribs.push_back(attrib);
+		}
+	}
+	offset += sizeof(T_attrib);
+}
+
 /****************************************************************************
  *						OpenGL Vertex Array Object 							*
  ****************************************************************************/
@@ -29,26 +190,40 @@ class VertexArray final
 {
 public:
 
-	VertexArray(){ glGenVertexArrays(1, &this->object_id); }
+	VertexArray(){ glCreateVertexArrays(1, &this->object_id); }
+	explicit VertexArray(const VertexFormat& format) : VertexArray() { _format = format; applyFormat(0, 0); }
 	~VertexArray() { if (s_bound_vao_id() == this->object_id) s_bound_vao_id() = 0; glDeleteVertexArrays(1, &this->object_id); }
 
 	inline void bindVertexArray();
 
+	// Adds a new vertex buffer binding with the attributes described by the type list. Does not bind anything (DSA).
 	template<typename ... T_vertex_types>
 	void addVBO(ArrayBuffer& vertex_buffer_object);
 
-protected:
+	// Attaches a buffer to an existing binding point of the format (cheap, this is how meshes are switched)
+	inline void setVertexBuffer(GLuint binding, GLuint buffer, GLintptr offset = 0);
+
+	// Sets the element (index) buffer of the VAO. Does not bind anything (DSA).
+	inline void addIBO(ElementArrayBuffer& index_buffer_object);
+
+	inline const VertexFormat& getFormat() const { return _format; }
+
+	// One VAO per distinct format, created on first use. Formats with the same layout share it even if the type lists differ.
+	template<typename ... T_vertex_types>
+	static VertexArray& getShared() { return getShared(VertexFormat::get<T_vertex_types...>()); }
+	static inline VertexArray& getShared(const VertexFormat& format);
+	static size_t getSharedCount() { return s_shared().size(); }
+	// Deletes the shared VAOs (df::Sample does it before the context dies)
+	static void releaseShared() { s_shared().clear(); }
 
-	template<GLsizei stride, GLsizei index, GLsizei offset,
-		typename Type_head, typename ... Type_tail>
-	void addVBOrec();
+protected:
+	//Issues the format calls for the attributes and bindings starting from 'first_attrib' and 'first_binding'
+	inline void applyFormat(size_t first_attrib, GLuint first_binding);
 
-	template<GLsizei stride, GLsizei index, GLsizei offset>
-	void addVBOrec();
-	
 protected:
 	static GLuint& s_bound_vao_id() { static GLuint id = 0; return id; }
-	GLuint _curr_attrib_idx = 0;
+	static std::map<VertexFormat, std::unique_ptr<VertexArray>>& s_shared() { static std::map<VertexFormat, std::unique_ptr<VertexArray>> vaos; return vaos; }
+	VertexFormat _format;
 
 }; //VertexArray
 
@@ -65,80 +240,50 @@ inline void VertexArray::bindVertexArray()
 template<typename ...T_vertex_types>
 inline void VertexArray::addVBO(ArrayBuffer& vertex_buffer_object)
 {
-	vertex_buffer_object.bindBuffer();
-	this->bindVertexArray();
-	this->addVBOrec< (0 + ... + sizeof(T_vertex_types)),
-					0, 0,
-					T_vertex_types ...>();
+	const size_t first_attrib = _format.getAttribs().size();
+	const GLuint binding = _format.getBindingCount();
+	_format.addBinding<T_vertex_types...>();
+	applyFormat(first_attrib, binding);
+	setVertexBuffer(binding, vertex_buffer_object);
 }
 
-template<typename D> struct is_dummy_t : std::false_type{};
-template<typename T> struct is_dummy_t<dummy_t<T>> : std::true_type{};
-template<typename D> constexpr bool is_dummy_t_v = is_dummy_t< std::decay_t<D>>::value;
+inline void VertexArray::setVertexBuffer(GLuint binding, GLuint buffer, GLintptr offset)
+{
+	ASSERT(binding < _format.getBindingCount(), "VertexArray: the format has no such binding.");
+	glVertexArrayVertexBuffer(this->object_id, binding, buffer, offset, _format.getStride(binding));
+}
 
-template<typename D> struct is_integral_t : std::false_type {};
-template<typename T> struct is_integral_t<integral_t<T>> : std::true_type {};
-template<typename D> constexpr bool is_integral_t_v = is_integral_t< std::decay_t<D>>::value;
+inline void VertexArray::addIBO(ElementArrayBuffer& index_buffer_object)
+{
+	glVertexArrayElementBuffer(this->object_id, index_buffer_object);
+}
 
-template <typename T> struct as_array_type { using type = T; };
-template <typename T> struct as_array_type<glm::vec<1, T>> { using type = T[1]; };
-template <typename T> struct as_array_type<glm::vec<2, T>> { using type = T[2]; };
-template <typename T> struct as_array_type<glm::vec<3, T>> { using type = T[3]; };
-template <typename T> struct as_array_type<glm::vec<4, T>> { using type = T[4]; };
-template <typename T> using as_array_type_t = typename as_array_type<std::decay_t<T>>::type;
+inline VertexArray& VertexArray::getShared(const VertexFormat& format)
+{
+	std::unique_ptr<VertexArray>& vao = s_shared()[format];
+	if (!vao) vao = std::make_unique<VertexArray>(format);
+	return *vao;
+}
 
-template<GLsizei stride, GLsizei index, GLsizei offset,
-	typename Type_head, typename ... Type_tail>
-inline void VertexArray::addVBOrec()
+inline void VertexArray::applyFormat(size_t first_attrib, GLuint first_binding)
 {
-	if constexpr (!is_dummy_t_v<Type_head>)
+	for (GLuint binding = first_binding; binding < _format.getBindingCount(); ++binding)
+		if (_format.getDivisor(binding) != 0)
+			glVertexArrayBindingDivisor(this->object_id, binding, _format.getDivisor(binding));
+	const std::vector<VertexAttribFormat>& attribs = _format.getAttribs();
+	for (size_t i = first_attrib; i < attribs.size(); ++i)
 	{
-		glEnableVertexAttribArray(_curr_attrib_idx+index);
-		GL_CHECK;
-
-		using attib_t = as_array_type_t<Type_head>;
-		using base_t = std::remove_pointer_t<std::remove_all_extents_t<attib_t>>;
-
-		constexpr GLenum	ogl_base_t = df::getOpenGLType<base_t>();
-		constexpr GLboolean integral = is_integral_t_v<Type_head>;
-		constexpr GLint		components = std::extent_v<attib_t> > std::extent_v<Type_head> ? std::extent_v<attib_t> : std::extent_v<Type_head>;
-
-		std::cout << typeid(Type_head).name() << ": " << "index = " << _curr_attrib_idx + index
-			<< "\n\t"<< typeid(base_t).name() << '[' << components << ']'
-			<< " size=" << sizeof(Type_head) << " stride=" << stride << " offset=" << offset << std::endl;
-
-		if constexpr (std::is_same_v < base_t, double>)
-		{	// double only
-			static_assert(ogl_base_t == GL_DOUBLE, "This should be double!");
-			glVertexAttribLPointer(_curr_attrib_idx + index, components, ogl_base_t,
-				stride, reinterpret_cast<void*>(offset));
-			GL_CHECK;
-		}
-		else if constexpr (integral && std::is_integral_v<base_t>)
-		{	
-			glVertexAttribIPointer(_curr_attrib_idx + index, components, ogl_base_t,
-				stride, reinterpret_cast<void*>(offset));
-			GL_CHECK;
+		const VertexAttribFormat& a = attribs[i];
+		glEnableVertexArrayAttrib(this->object_id, a.index);
+		switch (a.kind)
+		{
+		case VertexAttribFormat::Kind::DOUBLE:	glVertexArrayAttribLFormat(this->object_id, a.index, a.components, a.type, a.relative_offset); break;
+		case VertexAttribFormat::Kind::INTEGER:	glVertexArrayAttribIFormat(this->object_id, a.index, a.components, a.type, a.relative_offset); break;
+		default:								glVertexArrayAttribFormat(this->object_id, a.index, a.components, a.type, a.normalized, a.relative_offset); break;
 		}
-		else 
-		{	
-			glVertexAttribPointer(_curr_attrib_idx + index, components, ogl_base_t,
-				true,	stride, reinterpret_cast<void*>(offset));
-			GL_CHECK;
-		}
-		addVBOrec<stride, index + 1, offset + sizeof(Type_head), Type_tail...>();
-	}
-	else
-	{
-		addVBOrec<stride, index, offset + sizeof(Type_head), Type_tail...>();
+		glVertexArrayAttribBinding(this->object_id, a.index, a.binding);
+		GL_CHECK;
 	}
 }
 
-template<GLsizei stride, GLsizei index, GLsizei offset>
-inline void VertexArray::addVBOrec()
-{
-	this->_curr_attrib_idx += index; // finally we increment the runtime counter
-}
-
-
-}} //namespace eltecg::ogl
\ No newline at end of file
+}} //namespace eltecg::ogl